@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+
+#include "storage_hal.h"
+
+// A compressed text file holds the text of one topic in blocks that are each compressed on their own, so any position
+// can be reached by decompressing only the block it is in:
+//
+//   [header][block table][compressed block 0][compressed block 1]...
+//
+// The block table has one offset in the file per block plus the end of the last block, which are the seek points.
+// Every block except the last one holds exactly the block size of text. Blocks are LZSS compressed with a window of the
+// block itself, so the buffer a block is decompressed into is all the memory decompression needs:
+//
+//   [flags][8 items]... a flag bit per item starting at the lowest, 1 for a literal byte, 0 for a two byte match
+//   match: distance - 1 in the low 8 bits of the first byte and the high 4 bits of the second, length - 3 in its low 4 bits
+//
+// All numbers are little endian, like both the ESP32-S3 and the host the compressor runs on.
+
+// ===== Compressed Text Definitions =====
+
+#define COMPRESSED_TEXT_FILE_EXTENSION ".txc"
+#define COMPRESSED_TEXT_MAGIC "PFTZ"
+#define COMPRESSED_TEXT_VERSION 1
+#define COMPRESSED_TEXT_BLOCK_SIZE 4096      // Text per block written by the compressor, has to fit the stream reader buffer
+#define COMPRESSED_TEXT_MIN_MATCH 3          // Shorter repeats are cheaper as literals
+#define COMPRESSED_TEXT_MAX_MATCH 18         // Longest repeat a match can hold in its 4 bits
+#define COMPRESSED_TEXT_MAX_DISTANCE 4096    // Farthest back a match can reach in its 12 bits
+#define COMPRESSED_TEXT_INPUT_CHUNK_SIZE 512 // Compressed bytes read from the file at a time while decompressing, one card sector
+
+// ===== Struct Definitions =====
+
+struct CompressedTextHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t blockSize;      // Size of the text in every block but the last
+    uint32_t textSize;       // Size of the whole text once decompressed
+    uint32_t headerChecksum; // Checksum of the header up to this field
+};
+
+static_assert(sizeof(CompressedTextHeader) == 16, "The compressed text header has a fixed size");
+
+// ===== Function Definitions =====
+
+// Compute the checksum of a header, over everything before the checksum itself
+uint32_t compressedTextHeaderChecksum(const CompressedTextHeader &header);
+
+// Count the blocks a text is split into
+uint32_t countCompressedTextBlocks(uint16_t blockSize, uint32_t textSize);
+
+// Read and check the header at the start of a compressed text file, leaving the file right after it
+StorageError readCompressedTextHeader(File &file, CompressedTextHeader &header);
+
+// Decompress one block of a file with the block and text size from its header into the output, which has to hold the block size.
+// Returns the size of the block's text through textLength
+StorageError decompressTextBlock(File &file, uint16_t blockSize, uint32_t textSize, uint32_t blockIndex, uint8_t *output, size_t &textLength);
+
+// Decompress the whole text of an open compressed text file straight into the destination, which has to hold the text size
+StorageError decompressText(File &file, uint8_t *destination, uint32_t textSize);
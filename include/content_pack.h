@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+
+#include "storage_hal.h"
+#include "text_layout.h"
+#include "topic_catalog.h"
+
+// A content pack holds every topic in one file, so boot needs one open and one read instead of a directory scan:
+//
+//   [header][topic table][checkpoint tables][names][text of topic 0][text of topic 1]...
+//
+// The topic table, checkpoint tables and names together form the table area, which is read in one go and checked as a whole.
+// A checkpoint table is the checkpoint interval and amount of a topic's layout, followed by the line and offset of every checkpoint.
+// All numbers are little endian, like both the ESP32-S3 and the host the packer runs on.
+
+// ===== Content Pack Definitions =====
+
+#define CONTENT_PACK_MAGIC "PFPK"
+#define CONTENT_PACK_VERSION 3
+#define CONTENT_PACK_MAX_TABLE_SIZE (1024 * 1024) // Larger table areas are treated as corrupt instead of being allocated
+
+// ===== Struct Definitions =====
+
+struct ContentPackHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint8_t lineWidth; // Width the topics were wrapped at
+    uint8_t reserved;
+    uint16_t topicAmount;
+    uint16_t reserved2;
+    uint32_t tableSize;      // Size of the table area right after the header
+    uint32_t tableChecksum;  // Checksum of the table area
+    uint32_t headerChecksum; // Checksum of the header up to this field
+};
+
+struct ContentPackTopic
+{
+    uint32_t nameOffset;            // Offset in the table area of the name, ended by a zero
+    uint32_t checkpointTableOffset; // Offset in the table area of the checkpoint table
+    uint32_t lineAmount;
+    uint32_t textOffset; // Offset in the pack of the text, checkpoints are relative to it
+    uint32_t textSize;
+    uint32_t textChecksum;
+};
+
+static_assert(sizeof(ContentPackHeader) == 24, "The content pack header has a fixed size");
+static_assert(sizeof(ContentPackTopic) == 24, "The content pack topic entries have a fixed size");
+static_assert(sizeof(LayoutCheckpoint) == 8, "Checkpoints are stored as they are in memory");
+
+// ===== Function Definitions =====
+
+// Continue a CRC-32 checksum over more data, starting from 0
+uint32_t calculateChecksum(const uint8_t *data, size_t length, uint32_t checksum = 0);
+
+// Get the size of the checkpoint table of a laid out topic
+uint32_t checkpointTableSize(const TopicLayout &layout);
+
+// Write the checkpoint table of a laid out topic
+void packCheckpointTable(const TopicLayout &layout, uint8_t *destination);
+
+// Give a layout the checkpoint table at an offset in a table area, returns false when the table does not fit in the area
+// or its checkpoints are out of order
+bool unpackCheckpointTable(const uint8_t *table, uint32_t tableSize, uint32_t offset, uint32_t lineAmount, uint8_t lineWidth, TopicLayout &layout);
+
+// Fill the catalog with the topics and their layouts from a content pack, reading the header and table area in one go
+StorageError loadContentPack(fs::FS &fs, const char *path, TopicCatalog &catalog);
+
+// Check the text a reader streams against its checksum, the reader is left at the start of the text
+StorageError verifyContentPackText(StreamReader &reader, uint32_t textChecksum);
@@ -2,6 +2,8 @@
 #include <Arduino_GFX_Library.h>
 #include <bb_captouch.h>
 
+#include "qr_code.h"
+
 // ===== Display Configuration Definitions =====
 
 #define DISPLAY_CS_PIN 45
@@ -19,6 +21,21 @@
 #define SCREEN_WIDTH 480
 #define SCREEN_HEIGHT 272
 #define SCR_BUF_LEN 32
+#define FRAMEBUFFER_ROW_BYTES (SCREEN_WIDTH / 2) // The canvas holds palette indexes, two pixels to a byte
+#define FRAMEBUFFER_SIZE (FRAMEBUFFER_ROW_BYTES * SCREEN_HEIGHT)
+
+// ===== Dirty Region Definitions =====
+
+#define DIRTY_RECT_MAX_AMOUNT 8             // Regions tracked before they get merged into each other
+#define DIRTY_RECT_MERGE_DISTANCE 8         // Regions closer than this are merged, one window is cheaper than two
+#define DIRTY_RECT_FULL_FLUSH_PERCENTAGE 60 // Above this share of the screen the whole canvas is flushed instead
+#define DIRTY_FLUSH_BUFFER_LINES 8          // Screen lines expanded to RGB565 in internal RAM per bus transfer
+
+// ===== Flush Pipeline Definitions =====
+
+#define DISPLAY_FLUSH_TASK_CORE 0 // Arduino's loop runs on core 1, so the panel transfers run on the other core
+#define DISPLAY_FLUSH_TASK_PRIORITY 2
+#define DISPLAY_FLUSH_TASK_STACK_SIZE 4096
 
 // ===== Display Backlight Definitions =====
 
@@ -36,15 +53,58 @@
 
 #define TOUCH_PRESS_DEBOUNCE_DELAY 50
 #define TOUCH_PRESS_LONG_PRESS_DELAY 1000
+#define TOUCH_LONG_PRESS_REPEAT_INTERVAL 100 // A held up or down button repeats at this interval after the long press delay
+
+// ===== Touch Drag Definitions =====
+
+#define TOUCH_DRAG_START_DISTANCE 4        // Pixels a finger on the content area has to move before it drags, so a tap does not scroll
+#define TOUCH_DRAG_VELOCITY_SMOOTHING 0.3f // Share of the previous speed kept at every move, the rest comes from the move itself
+#define TOUCH_FLING_MIN_VELOCITY 0.1f      // Pixels per millisecond a finger has to move at when it lets go to fling the content
+#define TOUCH_FLING_MAX_PAUSE 50           // A finger that rested this long before letting go does not fling
+#define TOUCH_TAP_MAX_DURATION 300         // A finger on the content area that lets go within this many milliseconds without dragging taps it
+
+// ===== Touch Event Definitions =====
+
+#define TOUCH_EVENT_QUEUE_LENGTH 16
+#define TOUCH_RELEASE_POLL_INTERVAL 10 // The controller only interrupts on new reports, so a held finger is sampled to catch the release
+#define TOUCH_HOST_POLL_INTERVAL 50    // Without an interrupt the touch panel is sampled at this interval
+#define TOUCH_TASK_CORE 0
+#define TOUCH_TASK_PRIORITY 3
+#define TOUCH_TASK_STACK_SIZE 3072
+
+// ===== Touch Trace Definitions =====
+
+#define TOUCH_TRACE_PREFIX "touch" // Serial lines of a TOUCH_TRACE_RECORD build starting with this are one readTouchScreen() result each
 
 // ===== Interface Definitions =====
 
 #define INTERFACE_BORDER_WIDTH 3
 #define NAVIGATION_WIDTH 90
 #define MAIN_SCREEN_PADDING_SIZE 45
+#define MAIN_MENU_ROW_AMOUNT 5 // Topics on one page of the main screen
 #define DETAILS_SCREEN_PADDING_SIZE 30
 #define DETAILS_LINE_WIDTH 55
 #define DETAILS_LINE_AMOUNT 23
+#define DETAILS_LINE_HEIGHT 8                             // Text size 1 -> 6x8 character size
+#define DETAILS_TEXT_Y (DETAILS_SCREEN_PADDING_SIZE + 29) // Below the title of the topic
+#define DETAILS_TEXT_WIDTH (SCREEN_WIDTH - NAVIGATION_WIDTH - DETAILS_SCREEN_PADDING_SIZE)
+#define DETAILS_TEXT_HEIGHT (DETAILS_LINE_AMOUNT * DETAILS_LINE_HEIGHT)
+#define DETAILS_SCROLLBAR_X (DETAILS_SCREEN_PADDING_SIZE + DETAILS_LINE_WIDTH * 6 + 16) // Right of the longest line, within the text area so it scrolls along
+#define DETAILS_SCROLLBAR_WIDTH 6
+#define DETAILS_SCROLLBAR_MIN_HEIGHT 8                                                // The thumb stays large enough to see in the longest topics
+#define DETAILS_SCROLLBAR_TOUCH_X (DETAILS_SCROLLBAR_X - 10)                          // Taps right of this jump to their height in the topic
+#define DETAILS_SCROLLBAR_END_ZONE 12                                                 // Taps this close to the top or bottom jump to the start or end, a fingertip rarely hits the last pixel row
+
+// ===== Interface Chrome Definitions =====
+
+#define INTERFACE_CONTENT_X INTERFACE_BORDER_WIDTH // Area within the border and left of the navigation, the rest of the screen is chrome
+#define INTERFACE_CONTENT_Y INTERFACE_BORDER_WIDTH
+#define INTERFACE_CONTENT_WIDTH (SCREEN_WIDTH - NAVIGATION_WIDTH - INTERFACE_BORDER_WIDTH)
+#define INTERFACE_CONTENT_HEIGHT (SCREEN_HEIGHT - 2 * INTERFACE_BORDER_WIDTH)
+#define INTERFACE_CONTENT_FIRST_BYTE ((INTERFACE_CONTENT_X + 1) / 2) // Bytes of a row that only hold content pixels
+#define INTERFACE_CONTENT_END_BYTE ((INTERFACE_CONTENT_X + INTERFACE_CONTENT_WIDTH) / 2)
+#define INTERFACE_CHROME_BYTE_AMOUNT (FRAMEBUFFER_SIZE - (INTERFACE_CONTENT_END_BYTE - INTERFACE_CONTENT_FIRST_BYTE) * INTERFACE_CONTENT_HEIGHT)
+#define INTERFACE_CHROME_CACHE_AMOUNT 2 // Prerendered interface variants kept, the main screen's "Select" and the details screen's "Back"
 
 // ===== Enum Definitions =====
 
@@ -62,16 +122,37 @@ enum class ButtonPressed
     DOWN_BUTTON
 };
 
+// ===== Struct Definitions =====
+
+struct TouchEvent
+{
+    unsigned long timestamp; // millis() when the controller reported the change
+    TouchState state;
+    uint16_t x;
+    uint16_t y;
+};
+
+struct TouchAction
+{
+    ButtonPressed button; // Navigation button that was pressed or repeats, none most of the time
+    int16_t dragDistance; // Pixels a finger dragging over the content area moved down since the last read, negative when it moved up
+    float flingVelocity;  // Pixels per millisecond a dragging finger moved down at when it let go fast enough to fling, zero otherwise
+    bool dragging;        // A finger is down on the content area
+    int16_t tapX;         // Location of a finger that tapped the content area without dragging, -1 otherwise
+    int16_t tapY;
+};
+
 // ===== Function Definitions =====
 
 // Initializes the display and it's backlight at the specified value, sets screen to black and cursor at 0, 0 (top left)
 void initializeDisplay(uint8_t initDisplayBrightness);
 
-// Initializes the display touchscreen
+// Initializes the display touchscreen, and the interrupt that feeds its touch events
 bool initializeTouchScreen();
 
-// Reads the touchscreen to see if it is being pressed
-ButtonPressed readTouchScreen();
+// Waits for the next touch event, a held button to repeat or at most the wait time in milliseconds,
+// and returns the button that was pressed together with any drag over or tap on the content area
+TouchAction readTouchScreen(uint32_t maximumWaitTime);
 
 // Determines if a button was short- or long-pressed, and only returns when the press is correct
 ButtonPressed determineTouchPress();
@@ -79,6 +160,18 @@ ButtonPressed determineTouchPress();
 // Clears the display by filling it with black
 void clearDisplay();
 
+// Clears a part of the display by filling it with black
+void clearDisplayRegion(int16_t x, int16_t y, int16_t w, int16_t h);
+
+// Fills a part of the display with a color
+void fillDisplayRegion(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+// Shifts a part of the canvas vertically by moving its rows, a negative amount moves it up, the uncovered rows are cleared
+void scrollDisplayRegion(int16_t x, int16_t y, int16_t w, int16_t h, int16_t amount);
+
+// Marks a part of the canvas as changed, so it gets sent to the panel with the next flush
+void markDirtyRegion(int16_t x, int16_t y, int16_t w, int16_t h);
+
 // To set the brightness of the display. Int of 0 - 255 as input
 void setBrightness(uint8_t value);
 
@@ -88,20 +181,32 @@ void setCursorLocation(uint16_t x, uint16_t y);
 // Set the text size
 void setTextSize(uint8_t size);
 
+// Limit the text drawn from now on to a band of rows, text crossing its edges is cut off. The whole screen is the default
+void setTextClipRows(int16_t y, int16_t h);
+
+// Draw a QR code with its quiet zone, every module a square of scale pixels. Keeps to the text clip rows like text does
+void displayDrawQrCode(int16_t x, int16_t y, const QrCode &code, uint8_t scale);
+
 // To display a status message mainly for startup diagnostics
-void displayStatusMessage(String message, String state, uint16_t stateColor);
+void displayStatusMessage(const char *message, const char *state, uint16_t stateColor);
 
 // To print a string
-void displayPrint(String text, uint16_t color);
+void displayPrint(const char *text, uint16_t color);
 
 // To print a string finishing with a newline
-void displayPrintln(String text, uint16_t color);
+void displayPrintln(const char *text, uint16_t color);
 
 // Prints on the display, without flushing the text to be actually displayed
-void displayPrintWithoutFlush(String text, uint16_t color);
+void displayPrintWithoutFlush(const char *text, uint16_t color);
 
-// Flush all current text to the display
+// Flush everything drawn since the last flush to the display, only sending the changed regions.
+// With two framebuffers the transfer happens on the other core while the next frame is already being drawn
 void flushToDisplay();
 
-// Draw the border of the application's interface
-void displayDrawInterface(uint16_t interfaceColor, uint16_t centerButtonTextColor, String centerButtonText);
+// Wait until the last flushed frame has completely reached the panel
+void waitForDisplayFlush();
+
+// Draw the border of the application's interface and clear the content area within it.
+// Every variant is drawn once and then restored from a cache, when it is still on screen only the content area is cleared.
+// The cache keeps the pointer to the center button text, so it has to stay valid, like a string literal
+void displayDrawInterface(uint16_t interfaceColor, uint16_t centerButtonTextColor, const char *centerButtonText);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Timing of the stages of a screen update, only compiled in when FRAME_TIMING_ENABLED is defined.
+// Without it FRAME_TIMING_SCOPE() expands to nothing and none of this ends up in the firmware.
+
+// ===== Frame Timing Definitions =====
+
+#define FRAME_TIMING_RING_LENGTH 64            // Latest samples kept in order, to see how one update was spent
+#define FRAME_TIMING_BUCKET_AMOUNT 92          // Four buckets per power of two microseconds, the last one also takes everything above 16 s
+#define FRAME_TIMING_CONSOLE_POLL_INTERVAL 100 // Interval at which the serial console checks for a command
+#define FRAME_TIMING_CONSOLE_TASK_CORE 0
+#define FRAME_TIMING_CONSOLE_TASK_PRIORITY 1
+#define FRAME_TIMING_CONSOLE_TASK_STACK_SIZE 4096
+
+// ===== Enum Definitions =====
+
+enum class TimingStage
+{
+    SCREEN_UPDATE,  // A full redraw of the screen, from drawing the interface until the frame is handed to the flush
+    PARTIAL_UPDATE, // Moving the indicator or scrolling the text
+    TOPIC_SELECT,   // Opening a topic, including checking and wrapping it when needed
+    TOPIC_VERIFY,   // Checking the text of a content pack topic against its checksum
+    TOPIC_LAYOUT,   // Wrapping a topic into lines
+    TOPIC_LOAD,     // Reading the whole text of a topic into the topic cache, in the background or when it was missing
+    LINE_READ,      // Moving the viewport to the visible lines of a topic, wrapping and compiling them when they are not in its window
+    TEXT_DRAW,      // Drawing one piece of text into the canvas
+    QR_ENCODE,      // Encoding the link of a topic into a QR code, once until it drops out of the QR code cache
+    QR_DRAW,        // Drawing a QR code into the canvas
+    INTERFACE_DRAW, // Drawing or restoring the interface chrome
+    FLUSH_SUBMIT,   // Handing a frame to the flush, including waiting for the previous one
+    PANEL_TRANSFER, // Sending a frame to the panel
+    AMOUNT
+};
+
+#ifdef FRAME_TIMING_ENABLED
+
+// ===== Class Definitions =====
+
+// Records the time between its construction and the end of its scope
+class FrameTimingScope
+{
+public:
+    explicit FrameTimingScope(TimingStage stage);
+    ~FrameTimingScope();
+
+private:
+    TimingStage stage;
+    uint32_t start;
+};
+
+#define FRAME_TIMING_SCOPE(stage) FrameTimingScope frameTimingScope(stage)
+
+// ===== Function Definitions =====
+
+// Start the serial console that prints the timing report on the command "timing", and clears it on "timing reset".
+// The host has no serial input, so there the report is printed when the run ends
+void initializeFrameTiming();
+
+// Microseconds from a free running clock, only differences between two readings mean something
+uint32_t readTimingClock();
+
+// Add a sample of a stage to its histogram and to the ring of latest samples, safe to call from either core
+void recordTiming(TimingStage stage, uint32_t duration);
+
+// Print the count, minimum, average, 99th percentile and maximum of every stage, followed by the latest samples
+void printFrameTimingReport();
+
+// Forget every sample recorded so far
+void resetFrameTiming();
+
+#else
+
+#define FRAME_TIMING_SCOPE(stage)
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===== Glyph Blitter Definitions =====
+
+#define GLYPH_COLUMNS 5 // Columns of the 5x7 font that can be set, the sixth is spacing
+#define GLYPH_WIDTH 6   // Width of a character cell at text size 1, including its spacing
+#define GLYPH_HEIGHT 8  // Height of a character cell at text size 1, the lowest row is for descenders
+#define GLYPH_FIRST_CHARACTER 0x20
+#define GLYPH_LAST_CHARACTER 0x7E
+#define GLYPH_AMOUNT (GLYPH_LAST_CHARACTER - GLYPH_FIRST_CHARACTER + 1)
+#define GLYPH_BLITTER_MAX_TEXT_SIZE 2 // Text sizes with prepared glyph tables, larger text goes through the GFX library
+
+// ===== Function Definitions =====
+
+// Check if text of a size can be drawn by the blitter
+bool canBlitText(uint8_t textSize);
+
+// Draw text straight into the framebuffer of an indexed canvas with an even width, in a palette index and without a background.
+// Newlines and wrapping at the right edge follow the rules of the GFX print, and the cursor is moved past the text the same way.
+// Characters outside of printable ASCII are drawn as '?'
+void blitText(uint8_t *framebuffer, int16_t width, int16_t height, int16_t &cursorX, int16_t &cursorY, const char *text, uint8_t textSize, uint8_t colorIndex);
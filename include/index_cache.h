@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+
+#include "content_pack.h"
+#include "storage_hal.h"
+#include "text_layout.h"
+#include "topic_catalog.h"
+
+// The index cache keeps the layouts of the text files on the card between boots, so a topic is only wrapped again
+// when its file changed. It has the same layout as the table area of a content pack, without any text after it:
+//
+//   [header][topic table][checkpoint tables][names]
+//
+// Each topic remembers the size and modification time of its file, a topic whose file no longer matches is left out.
+
+// ===== Index Cache Definitions =====
+
+#define INDEX_CACHE_MAGIC "PFIX"
+#define INDEX_CACHE_VERSION 4
+#define INDEX_CACHE_MAX_TABLE_SIZE (1024 * 1024) // Larger table areas are treated as corrupt instead of being allocated
+
+// ===== Struct Definitions =====
+
+// The header is the one of a content pack, with its own magic and version
+typedef ContentPackHeader IndexCacheHeader;
+
+struct IndexCacheTopic
+{
+    uint32_t nameOffset;            // Offset in the table area of the name, ended by a zero
+    uint32_t checkpointTableOffset; // Offset in the table area of the checkpoint table
+    uint32_t lineAmount;
+    uint32_t fileSize;  // Size of the text file when it was wrapped
+    uint32_t lastWrite; // Modification time of the text file when it was wrapped
+    uint32_t reserved;
+};
+
+static_assert(sizeof(IndexCacheTopic) == 24, "The index cache topic entries have a fixed size");
+
+// ===== Function Definitions =====
+
+// Give every topic in the catalog whose file is unchanged its layout from the cache, reading the cache in one go.
+// Topics that are not in the cache, or were wrapped at another width, are left as they are
+StorageError loadIndexCache(fs::FS &fs, const char *path, uint8_t lineWidth, TopicCatalog &catalog, uint16_t &cachedAmount);
+
+// Wrap every topic in the catalog that is not wrapped at the width yet, streaming each file through the buffer once
+StorageError indexTopics(fs::FS &fs, const char *directory, uint8_t lineWidth, uint8_t *buffer, size_t bufferSize, TopicCatalog &catalog, uint16_t &indexedAmount);
+
+// Write the layout of every topic wrapped at the width to the cache, in one go
+StorageError saveIndexCache(fs::FS &fs, const char *path, uint8_t lineWidth, const TopicCatalog &catalog);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Arduino_GFX_Library.h>
+
+// Canvas that keeps every pixel as an index into a palette of up to 16 RGB565 colors, two pixels to a byte with the left
+// one in the low nibble. A frame takes a quarter of the memory of an RGB565 canvas, and is only expanded to RGB565 a few
+// lines at a time while it is sent to the panel. Colors get a palette entry the first time they are drawn and keep it,
+// so pixels already in a framebuffer never change color. Once the palette is full a new color gets the closest entry.
+
+// ===== Indexed Canvas Definitions =====
+
+#define INDEXED_CANVAS_PALETTE_SIZE 16
+#define INDEXED_CANVAS_BLACK_INDEX 0 // Black always has the first entry, so a cleared row is all zero bytes
+#define INDEXED_CANVAS_ROW_BYTES(width) ((width) / 2)
+
+// ===== Class Definitions =====
+
+class IndexedCanvas : public Arduino_GFX
+{
+public:
+    IndexedCanvas(int16_t w, int16_t h, Arduino_G *output);
+
+    bool begin(int32_t speed = GFX_NOT_DEFINED) override;
+    void writePixelPreclipped(int16_t x, int16_t y, uint16_t color) override;
+    void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+
+    uint8_t *getFramebuffer() { return framebuffer; }
+
+    // Draw into another framebuffer from now on, returning the one drawn in so far
+    uint8_t *swapFramebuffer(uint8_t *otherFramebuffer);
+
+    // Get the palette index of a color, giving it an entry when it has none yet
+    uint8_t colorIndex(uint16_t color);
+
+    // Expand a run of pixels of a framebuffer row to RGB565
+    void expandPixels(const uint8_t *row, int16_t x, int16_t w, uint16_t *destination) const;
+
+private:
+    uint8_t *framebuffer = nullptr;
+    Arduino_G *output;
+    uint16_t palette[INDEXED_CANVAS_PALETTE_SIZE] = {BLACK};
+    uint8_t paletteAmount = 1;
+    uint32_t pairColors[256] = {}; // Both RGB565 pixels of every byte, the left one in the low half
+    uint16_t lastColor = BLACK;    // Last color looked up, most drawing repeats it
+    uint8_t lastIndex = INDEXED_CANVAS_BLACK_INDEX;
+};
+
+// ===== Function Definitions =====
+
+// Allocate a framebuffer for an indexed canvas, in internal RAM when there is room for it and otherwise in PSRAM
+uint8_t *allocateIndexedFramebuffer(int16_t w, int16_t h);
+
+// Set the pixels of a run in a framebuffer row to a palette index
+void fillIndexedPixels(uint8_t *row, int16_t x, int16_t w, uint8_t index);
+
+// Copy the pixels of a run from one framebuffer row to the same columns of another one
+void copyIndexedPixels(uint8_t *destinationRow, const uint8_t *sourceRow, int16_t x, int16_t w);
+
+// Set one pixel of a framebuffer row to a palette index
+inline void setIndexedPixel(uint8_t *row, int16_t x, uint8_t index)
+{
+    uint8_t &pair = row[x >> 1];
+    pair = (x & 1) ? (pair & 0x0F) | (index << 4) : (pair & 0xF0) | index;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+// QR codes for the links in topics, encoded in byte mode at error correction level M in the smallest version that fits.
+// A code is kept as a packed bit matrix, one bit per module, and drawn by expanding its rows straight into a framebuffer.
+
+// ===== QR Code Definitions =====
+
+#define QR_CODE_MIN_VERSION 1
+#define QR_CODE_MAX_VERSION 10                          // Larger codes get too small to scan on the panel
+#define QR_CODE_MAX_TEXT_LENGTH 213                     // Bytes the largest code holds
+#define QR_CODE_MAX_SIZE (17 + 4 * QR_CODE_MAX_VERSION) // Modules along each side of the largest code
+#define QR_CODE_ROW_BYTES ((QR_CODE_MAX_SIZE + 7) / 8)  // Bytes of a packed module row
+#define QR_CODE_QUIET_ZONE 4                            // Light modules around the code that scanners need to find it
+#define QR_CODE_MAX_CODEWORDS 346                       // Data and error correction codewords of the largest code
+#define QR_CODE_DARK_COLOR 0x0000                       // Dark modules are black on a white code, like on paper
+#define QR_CODE_LIGHT_COLOR 0xFFFF
+
+// ===== Struct Definitions =====
+
+struct QrCode
+{
+    uint8_t size = 0; // Modules along each side, zero when nothing is encoded
+    uint8_t modules[QR_CODE_MAX_SIZE][QR_CODE_ROW_BYTES]; // Row by row, the lowest bit of the first byte is the leftmost module
+};
+
+// ===== Function Definitions =====
+
+// Encode text into a QR code, in the smallest version that holds it. Returns false when the text is too long for any version
+bool encodeQrCode(const char *text, size_t length, QrCode &code);
+
+// Check if a module of a code is dark
+bool isQrCodeModuleDark(const QrCode &code, uint8_t x, uint8_t y);
+
+// Get the side of a code in pixels at a scale, including its quiet zone
+int16_t qrCodePixelSize(const QrCode &code, uint8_t scale);
+
+// Draw a code with its quiet zone into the framebuffer of an indexed canvas, every module a square of scale pixels in the
+// palette index of its color. Each module row is expanded into the framebuffer once with span fills and copied to its
+// other pixel rows. Parts outside the framebuffer are cut off
+void blitQrCode(uint8_t *framebuffer, int16_t width, int16_t height, int16_t x, int16_t y, const QrCode &code, uint8_t scale, uint8_t darkIndex, uint8_t lightIndex);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Read throughput of the SD card, only compiled in when STORAGE_BENCHMARK_ENABLED is defined. Compares reading a sector
+// at a time with reading through a stream reader, which reads whole blocks and reads ahead, in order and at random places.
+
+#ifdef STORAGE_BENCHMARK_ENABLED
+
+// ===== Storage Benchmark Definitions =====
+
+#define STORAGE_BENCHMARK_SEQUENTIAL_SIZE (4 * 1024 * 1024) // Bytes read in order at most, less when the file is smaller
+#define STORAGE_BENCHMARK_RANDOM_READ_AMOUNT 256            // Reads at random places in the file
+#define STORAGE_BENCHMARK_SEED 0x2545F491                   // Start of the random places, the same on every run so runs compare
+
+// ===== Function Definitions =====
+
+// Read the largest file of a directory in each of the ways and print the throughput of each in kB/s, along with the bus
+// clock the card was mounted at. Takes a stream reader buffer of its own for as long as it runs
+void runStorageBenchmark(fs::FS &fs, const char *dirname);
+
+#endif
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <Arduino.h>
 #include <SD.h>
 
@@ -7,37 +9,119 @@
 #define STORAGE_MOSI 11
 #define STORAGE_SCK 12
 #define STORAGE_MISO 13
+#ifndef STORAGE_SPI_FREQUENCY
+#define STORAGE_SPI_FREQUENCY 40000000 // Bus clock the card is mounted at first, a build flag can set it for a card model
+#endif
+#define STORAGE_SPI_MIN_FREQUENCY 4000000 // The clock halves until the card mounts and reads cleanly, down to this one
+#define STORAGE_SECTOR_SIZE 512
+
+// ===== Stream Reader Definitions =====
+
+#define STREAM_READER_BLOCK_SIZE 4096      // Bytes of a plain file read from the card at a time, whole sectors in a single multi-sector read
+#define STREAM_READER_CACHE_BLOCK_AMOUNT 4 // Blocks a reader keeps in its buffer, so going back over text that was just read does not read it again
+#define STREAM_READER_READ_AHEAD_AMOUNT 2  // Blocks read at once while a stream goes through its file in order
+#define STREAM_READER_BUFFER_SIZE (STREAM_READER_BLOCK_SIZE * STREAM_READER_CACHE_BLOCK_AMOUNT) // Size of the buffer files are streamed through, bounds the memory needed for reading
+#define STREAM_LINE_MAX_LENGTH 256 // Longer lines are cut off when read as a line
 
-// ===== Global Constant =====
-const uint8_t MAXIMUM_FILE_AMOUNT = 5;
+// ===== Enum Definitions =====
+
+enum class StorageError
+{
+    NONE,
+    OPEN_FAILED,
+    NOT_A_DIRECTORY,
+    READ_FAILED,
+    SEEK_FAILED,
+    END_OF_FILE,
+    BAD_FORMAT,
+    CHECKSUM_MISMATCH,
+    WRITE_FAILED
+};
 
 // ===== Struct Definitions =====
 
-struct Topic
+struct StreamReader
 {
-    String name;
-    String textFileName;
+    File file;
+    uint8_t *buffer = nullptr; // Provided by the caller, the reader never allocates
+    size_t bufferSize = 0;
+    const uint8_t *bufferData = nullptr; // The block being read, in a slot of the buffer or in the memory of a memory stream
+    uint32_t bufferStart = 0;            // Offset in the file of the first byte of that block
+    size_t bufferLength = 0;             // Amount of valid bytes in the block
+    size_t bufferPosition = 0;           // Position of the next byte to read in the block
+    uint16_t slotSize = 0;               // The buffer is split into slots of a block each, which keep the blocks read last
+    uint8_t slotAmount = 0;
+    uint8_t nextSlot = 0;                                   // Slot the next read goes to, slots are reused in the order they were filled
+    uint32_t slotBlocks[STREAM_READER_CACHE_BLOCK_AMOUNT];  // Block of the file in each slot, UINT32_MAX when the slot is empty
+    uint16_t slotLengths[STREAM_READER_CACHE_BLOCK_AMOUNT]; // Amount of valid bytes in each slot
+    uint32_t readAheadBlock = UINT32_MAX;                   // Block the file is at after the last read, reading it next is reading in order
+    uint32_t rangeStart = 0;           // Offset in the file of the streamed part, stream positions are relative to it
+    uint32_t rangeLength = UINT32_MAX; // Length of the streamed part, the rest of the file when it is not limited
+    bool inMemory = false;             // The whole stream is already in the buffer and there is no file behind it
+    uint16_t blockSize = 0;            // Text per block of a compressed file, stream positions are then in the decompressed text. Zero for a plain file
 };
 
+
 // ===== Function Definitions =====
 
-// Start the SPI communication bus and initialize the SD card
+// Start the SPI communication bus and mount the SD card, at the highest clock from STORAGE_SPI_FREQUENCY down at which the
+// card mounts and its first sector reads back with the boot signature. A card failing its CRC checks at a clock fails either
 bool initializeStorage();
 
+// Get the clock the SD card was mounted at, zero when it is not mounted
+uint32_t storageBusFrequency();
+
 // Check if the SD card is mounted correctly
 bool checkIfSDMounted();
 
 // If the SD card is mounted correctly, determine its type
 String determineSDCardType();
 
-// Show the total, used and free space of the SD card
-std::array<uint64_t, 3> getSDCardStats();
+// Get the size of the SD card and the total space of its file system in MB, both come straight from the card and the FAT header
+std::array<uint64_t, 2> getSDCardStats();
+
+// Get the used space of the SD card in MB. Walks the whole FAT, which takes seconds on a large card
+uint64_t getSDCardUsedSpace();
+
+// Get a buffer to stream files through, from PSRAM when available and otherwise from internal RAM
+uint8_t *allocateReadBuffer(size_t size);
+
+// Get a readable description of a storage error
+const char *storageErrorToString(StorageError error);
+
+// Open a file for reading with a read buffer of a whole block, so reading a block reaches the card as one multi-sector read
+// instead of a sector at a time. The 2.x Arduino-ESP32 core can not change the buffer and keeps its 128 bytes
+File openStorageFile(fs::FS &fs, const String &path);
+
+// Open a file for streaming through a buffer provided by the caller. A buffer of STREAM_READER_BUFFER_SIZE keeps the last
+// few blocks read, and reads ahead while the file is read in order
+StorageError openStreamReader(fs::FS &fs, String path, uint8_t *buffer, size_t bufferSize, StreamReader &reader);
+
+// Open only a part of a file for streaming, the stream then starts at position 0 and ends with the part
+StorageError openStreamReaderRange(fs::FS &fs, String path, uint32_t rangeStart, uint32_t rangeLength, uint8_t *buffer, size_t bufferSize, StreamReader &reader);
+
+// Open a compressed text file for streaming its decompressed text, one block at a time through a buffer that holds a whole block.
+// Seeking only decompresses the block the position is in, see compressed_text.h for the format
+StorageError openCompressedStreamReader(fs::FS &fs, String path, uint8_t *buffer, size_t bufferSize, StreamReader &reader);
+
+// Stream from data that is already in memory, the data stays with the caller and has to outlive the reader
+void openMemoryStreamReader(const uint8_t *data, size_t length, StreamReader &reader);
+
+// Close the file of a stream reader, the buffer stays with the caller
+void closeStreamReader(StreamReader &reader);
+
+// Get the bytes available in the buffer without copying them, refilling it from the file when it is empty
+StorageError readStreamChunk(StreamReader &reader, const uint8_t *&data, size_t &length);
+
+// Copy bytes from the stream into a destination, returns the amount copied through readAmount
+StorageError readStream(StreamReader &reader, uint8_t *destination, size_t length, size_t &readAmount);
+
+// Read the next line without its line ending, lines longer than the line buffer are cut off but still skipped completely
+StorageError readStreamLine(StreamReader &reader, char *line, size_t lineSize, size_t &lineLength);
 
-// Assemble the different topics from the specified directory, there is a maximum amount and they must be TXT files
-std::array<Topic, MAXIMUM_FILE_AMOUNT> assembleTopicsFromDirectory(fs::FS &fs, const char *dirname);
+// Move the stream to a position in the file, staying within the buffer when the position is already in it
+StorageError seekStreamReader(StreamReader &reader, uint32_t position);
 
-// Count the amount of topics that are actually filled in in the array
-uint8_t countAvailableTopics(std::array<Topic, MAXIMUM_FILE_AMOUNT> topicsArray);
+// Get the position in the file of the next byte the stream will read
+uint32_t streamReaderPosition(const StreamReader &reader);
 
-// Read a file from path
-String readFile(fs::FS &fs, String path);
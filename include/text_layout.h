@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+#include "qr_code.h"
+#include "storage_hal.h"
+#include "topic_markup.h"
+
+// A topic is wrapped once into a sparse index: the amount of lines on screen and, every so many lines, where a line starts
+// in the file. Wrapping can start over at any of those checkpoints, so a viewport only wraps the lines around what is shown
+// and neither the index nor the viewport grows with the length of the topic. The lines of a window are compiled into a display
+// list while they are wrapped, so drawing them again only runs their ops.
+
+// ===== Text Layout Definitions =====
+
+#define LAYOUT_QR_CODE_PREFIX "@qr "  // A line of the text starting with this holds a link, shown as a QR code instead of as text when it fits one
+#define LAYOUT_QR_CODE_LINE_AMOUNT 17 // Lines on screen a QR code takes up
+
+#define LAYOUT_CHECKPOINT_MAX_AMOUNT 128    // Checkpoints kept per topic, every other one is dropped when a topic needs more
+#define LAYOUT_CHECKPOINT_FIRST_INTERVAL 32 // Lines on screen between checkpoints until the first time they are thinned out
+#define LAYOUT_WINDOW_LINE_AMOUNT 64        // Lines on screen a viewport keeps wrapped, a little under three screens
+#define LAYOUT_RESUME_POINT_AMOUNT 16       // Places near what was shown a viewport can start wrapping at again, closer than the checkpoints
+#define LAYOUT_RESUME_POINT_INTERVAL 32     // Lines on screen between those places
+#define LAYOUT_DISPLAY_LIST_SIZE 8192       // Bytes of ops a viewport keeps for its window, a screen of lines fits even with a tag on every character
+
+// ===== Struct Definitions =====
+
+struct LineSpan
+{
+    uint32_t offset;      // Byte offset in the file where the line on screen starts
+    uint16_t length;      // Amount of bytes of the file on the line, markup tags included
+    uint8_t part;         // Which of the lines on screen of its QR code or heading line the line is, zero for other lines
+    uint8_t color;        // Markup color in effect at the start of the line, MARKUP_DEFAULT_COLOR when no tag is
+    ParagraphStyle style; // How the line of the file the line is part of is shown
+};
+
+struct LayoutCheckpoint
+{
+    uint32_t line;   // Line on screen starting at the offset
+    uint32_t offset; // Byte offset in the file, always the start of a line of the file or of a line that can not be a QR code
+};
+
+struct TopicLayout
+{
+    std::vector<LayoutCheckpoint> checkpoints;                      // In order, the first line is a checkpoint without being in here
+    uint32_t checkpointInterval = LAYOUT_CHECKPOINT_FIRST_INTERVAL; // Least amount of lines on screen between two checkpoints
+    uint32_t lineAmount = 0;                                        // Lines on screen, after wrapping
+    uint8_t lineWidth = 0;                                          // Width the topic was wrapped at, zero when it has not been laid out yet
+};
+
+struct TopicViewport
+{
+    const TopicLayout *layout = nullptr;
+    LineSpan windowSpans[LAYOUT_WINDOW_LINE_AMOUNT];
+    uint32_t windowFirstLine = 0;
+    uint16_t windowLineAmount = 0; // Zero when nothing is wrapped yet
+    LayoutCheckpoint resumePoints[LAYOUT_RESUME_POINT_AMOUNT]; // In order, passed while the window was filled before
+    uint8_t resumePointAmount = 0;
+    uint8_t displayList[LAYOUT_DISPLAY_LIST_SIZE]; // Ops of the lines in the window, one after the other
+    uint16_t lineOps[LAYOUT_WINDOW_LINE_AMOUNT + 1]; // Where the ops of each line of the window start, the last one is where they end
+};
+
+// ===== Function Definitions =====
+
+// Wrap a whole file on word boundaries at the given width, once, counting the lines on screen and keeping checkpoints
+// between them. A QR code line becomes LAYOUT_QR_CODE_LINE_AMOUNT lines on screen, each with the offset of the QR code line in the file.
+// Heading lines are wrapped at a fraction of the width and each takes MARKUP_HEADING_TEXT_SIZE lines on screen, markup takes no room
+StorageError layoutTopic(StreamReader &reader, uint8_t lineWidth, TopicLayout &layout);
+
+// Check if a topic is already laid out at the given width, so it does not have to be wrapped again
+bool isTopicLaidOut(const TopicLayout &layout, uint8_t lineWidth);
+
+// Count the amount of lines on screen of a laid out topic
+uint32_t countLayoutLines(const TopicLayout &layout);
+
+// Start viewing a laid out topic, forgetting any lines wrapped for the topic viewed before
+void openTopicViewport(const TopicLayout &layout, TopicViewport &viewport);
+
+// Make sure a range of lines on screen is in the window of a viewport, wrapping the text around it again and compiling its
+// lines into the display list when it is not. Wrapping starts at the closest checkpoint or resume point before the window
+StorageError moveTopicViewport(StreamReader &reader, TopicViewport &viewport, uint32_t firstLine, uint8_t lineAmount);
+
+// Check if a line on screen is in the window of a viewport
+bool isLineInViewport(const TopicViewport &viewport, uint32_t line);
+
+// Get the span of a line on screen that is in the window of a viewport
+const LineSpan &viewportLineSpan(const TopicViewport &viewport, uint32_t line);
+
+// Get the display list ops of a line on screen that is in the window of a viewport, see DisplayOp
+const uint8_t *viewportLineOps(const TopicViewport &viewport, uint32_t line, size_t &opsLength);
+
+// Read the link of a QR code line without its prefix and line ending, cut off when it is longer than the link buffer
+StorageError readQrCodeLink(StreamReader &reader, const LineSpan &span, char *link, size_t linkSize, size_t &linkLength);
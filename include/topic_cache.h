@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+
+#include "storage_hal.h"
+#include "topic_catalog.h"
+
+// ===== Topic Cache Definitions =====
+
+#define TOPIC_CACHE_SIZE (1024 * 1024)                // PSRAM kept for the text of recently used topics
+#define TOPIC_CACHE_MAX_TOPIC_SIZE (TOPIC_CACHE_SIZE / 4) // Larger topics are streamed from the card instead of taking over the cache
+#define TOPIC_CACHE_MAX_ENTRIES 16
+#define TOPIC_PREFETCH_DISTANCE 1    // Topics above and below the one selected in the menu that are loaded ahead
+#define TOPIC_CACHE_LOAD_WAIT_TIME 10 // Interval at which a topic that is still being loaded in the background is checked on
+#define TOPIC_CACHE_TASK_CORE 0
+#define TOPIC_CACHE_TASK_PRIORITY 1
+#define TOPIC_CACHE_TASK_STACK_SIZE 4096
+
+// ===== Struct Definitions =====
+
+struct CachedTopic
+{
+    const uint8_t *text; // Stays valid until the topic is released
+    uint32_t size;
+    bool textMatches; // The text matches its checksum, always true for topics with their own text file
+};
+
+// ===== Function Definitions =====
+
+// Start the storage task that loads topics of the catalog into the cache. Without it topics are loaded when they are asked for
+void initializeTopicCache(fs::FS &fs, const char *directory, const TopicCatalog &catalog);
+
+// Ask for a topic and its neighbours in the menu to be loaded in the background, replacing any earlier request still waiting
+void prefetchTopics(uint16_t topicIndex);
+
+// Get the text of a topic from the cache, reading it right away when it is not there yet. The text is kept until it is released.
+// Returns false when the topic does not fit the cache or could not be read, it then has to be streamed from the card
+bool acquireCachedTopic(uint16_t topicIndex, CachedTopic &topic);
+
+// Allow an acquired topic to be evicted from the cache again
+void releaseCachedTopic(uint16_t topicIndex);
+
+// Check if the storage task has finished its first prefetch request and has no other one waiting or being read, so other
+// long reads of the card hold up nothing the menu asked for. Always true without the storage task
+bool isTopicPrefetchIdle();
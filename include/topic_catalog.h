@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <vector>
+
+#include "storage_hal.h"
+#include "text_layout.h"
+
+// ===== Topic Catalog Definitions =====
+
+#define TOPIC_FILE_EXTENSION ".txt"
+#define TOPIC_CATALOG_MAX_AMOUNT UINT16_MAX // Topics are indexed with 16 bits
+
+// ===== Struct Definitions =====
+
+struct TopicEntry
+{
+    uint32_t nameOffset;         // Offset of the name in the name arena of the catalog
+    uint32_t textOffset;         // Where the text starts in its file, only not zero for topics in a content pack
+    uint32_t textSize;           // Size of the text, for a text file its size when the card was scanned
+    uint32_t textChecksum;       // Only used for topics in a content pack
+    uint32_t lastWrite = 0;      // Modification time of a text file when the card was scanned, zero for topics in a content pack
+    bool textVerified = true;    // Content pack text is checked against its checksum the first time it is opened
+    bool textCompressed = false; // The text file is a compressed text file, its text size is then the decompressed size
+};
+
+struct TopicCatalog
+{
+    std::vector<TopicEntry> entries;  // Sorted by name, so the index of a topic is also its place in the menu
+    std::vector<TopicLayout> layouts; // Wrapped lines of each topic, at the same index as its entry
+    std::vector<char> nameArena;      // Every name after each other, each ended by a zero
+    String packFileName;              // Content pack every topic is read from, empty when each topic has its own text file
+};
+
+// ===== Function Definitions =====
+
+// Remove every topic from the catalog and release its memory
+void clearTopicCatalog(TopicCatalog &catalog);
+
+// Add a topic to the end of the catalog, returns false when the catalog is full
+bool addTopic(TopicCatalog &catalog, const char *name, size_t nameLength, uint32_t textOffset, uint32_t textSize, uint32_t textChecksum);
+
+// Sort the topics by name, ignoring case
+void sortTopicCatalog(TopicCatalog &catalog);
+
+// Count the amount of topics in the catalog
+uint16_t countTopics(const TopicCatalog &catalog);
+
+// Get the name of a topic, stays valid until a topic is added
+const char *topicName(const TopicCatalog &catalog, uint16_t index);
+
+// Find a topic by its exact name, -1 when the catalog has no topic with that name
+int32_t findTopic(const TopicCatalog &catalog, const char *name);
+
+// Get the name of the file the text of a topic is in
+String topicFileName(const TopicCatalog &catalog, uint16_t index);
+
+// Open the text of a topic for streaming through a buffer provided by the caller, from its text file, compressed text file or content pack
+StorageError openTopicStreamReader(fs::FS &fs, const char *directory, const TopicCatalog &catalog, uint16_t index, uint8_t *buffer, size_t bufferSize, StreamReader &reader);
+
+// Fill the catalog with every TXT and compressed TXC file in the specified directory, sorted by name, along with the size and
+// modification time of each file. A compressed file counts with the size of its text once decompressed
+StorageError assembleTopicsFromDirectory(fs::FS &fs, const char *dirname, TopicCatalog &catalog);
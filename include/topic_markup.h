@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Topics can style their text with a little markup, which is compiled once when lines are wrapped into a display list of
+// drawing ops per line on screen, so drawing a line only runs its ops and never looks at the markup again.
+//
+//   # Heading        A line of the file starting with "# " is drawn at text size 2 in the heading color
+//   ## Subheading    A line starting with "## " is drawn in the subheading color
+//   ---              A line holding only "---" is drawn as a horizontal rule
+//   {red}word{/}     Colors the text after it until "{/}" or the end of the line of the file. Tags with another name stay text
+//
+// Neither the prefixes nor the tags are shown, and they take no room when the text is wrapped.
+
+// ===== Topic Markup Definitions =====
+
+#define MARKUP_HEADING_PREFIX "# "
+#define MARKUP_SUBHEADING_PREFIX "## "
+#define MARKUP_RULE_LINE "---"
+#define MARKUP_TAG_START '{'
+#define MARKUP_TAG_END '}'
+#define MARKUP_TAG_RESET "/"          // Name of the tag that goes back to the color of the line
+#define MARKUP_TAG_NAME_MAX_LENGTH 9  // Longest name between the braces, longer ones are text
+#define MARKUP_HEADING_TEXT_SIZE 2    // A heading line on screen takes up this many lines of text size 1
+#define MARKUP_DEFAULT_COLOR 0xFF     // Color of a span that has no tag in effect, the color of its paragraph style
+#define MARKUP_TEXT_COLOR_INDEX 0     // Index of the color text is drawn in without markup, every line starts in it
+
+// ===== Enum Definitions =====
+
+// How a line of the file is shown, from its prefix
+enum class ParagraphStyle : uint8_t
+{
+    TEXT,
+    HEADING,
+    SUBHEADING,
+    RULE,
+    QR_CODE
+};
+
+// Ops of a display list. Every line on screen starts in the text color at text size 1 with the cursor at its left edge,
+// its ops only hold what differs from that
+enum class DisplayOp : uint8_t
+{
+    TEXT,    // Followed by the characters to draw and a zero, the cursor moves past them
+    COLOR,   // Followed by the index of the color the text after it is drawn in, see markupColor()
+    SIZE,    // Followed by the text size of the text after it
+    PART,    // Followed by which line of something taller the line is. Its ops draw all of it from that many lines higher
+    RULE,    // A horizontal rule across the text area in the current color
+    QR_CODE  // The QR code the line belongs to, with its top at the cursor
+};
+
+// ===== Function Definitions =====
+
+// Check if a character can be part of the name of a tag
+bool isMarkupTagCharacter(char character);
+
+// Look up the color a tag name stands for. The reset tag gives MARKUP_DEFAULT_COLOR, false when the name is not a tag
+bool findMarkupColor(const char *name, size_t nameLength, uint8_t &color);
+
+// Get the RGB565 color of a color index in a display list
+uint16_t markupColor(uint8_t color);
+
+// Compile a line on screen into display list ops: the bytes of the file it shows including any tags, how its paragraph is
+// styled, which line of a taller paragraph line it is and the color in effect at its start. Returns false when the ops do
+// not fit, opsLength then holds nothing useful
+bool compileDisplayLine(const char *text, size_t textLength, ParagraphStyle style, uint8_t part, uint8_t color, uint8_t *ops, size_t opsSize, size_t &opsLength);
@@ -0,0 +1,77 @@
+#pragma once
+
+// Host stand-in for the Arduino core, only covering what the firmware uses so it can run on Linux
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "WString.h"
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+// ===== Time =====
+
+// Virtual milliseconds since start, only advanced by delay() so host runs are deterministic
+unsigned long millis();
+
+// Virtual microseconds since start, follows the same clock as millis()
+unsigned long micros();
+
+// Advances the virtual clock instead of sleeping
+void delay(unsigned long ms);
+
+// ===== Memory =====
+
+// Plain malloc on the host, counted like every other heap allocation
+void *ps_malloc(size_t size);
+
+// Heap allocations made so far through new, String and the standard containers included, and ps_malloc
+unsigned long hostHeapAllocations();
+
+// ===== Backlight PWM =====
+
+inline double ledcSetup(uint8_t channel, double frequency, uint8_t resolutionBits) { return frequency; }
+inline void ledcAttachPin(uint8_t pin, uint8_t channel) {}
+inline void ledcWrite(uint8_t channel, uint32_t duty) {}
+
+// ===== Serial =====
+
+class HostSerial
+{
+public:
+    void begin(unsigned long baud) {}
+    int available();
+    int read();
+
+    size_t print(const String &text) { return fputs(text.c_str(), stdout) >= 0 ? text.length() : 0; }
+    size_t print(const char *text) { return print(String(text)); }
+    size_t println(const String &text = String()) { return print(text + "\r\n"); }
+    size_t println(const char *text) { return println(String(text)); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        va_list arguments;
+        va_start(arguments, format);
+        int written = vprintf(format, arguments);
+        va_end(arguments);
+        return written < 0 ? 0 : written;
+    }
+};
+
+extern HostSerial Serial;
+
+// ===== Sketch Entry Points =====
+
+void setup();
+void loop();
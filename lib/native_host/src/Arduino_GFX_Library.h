@@ -0,0 +1,205 @@
+#pragma once
+
+// Host stand-in for the GFX Library for Arduino: same class names and calls as the firmware uses,
+// drawing into memory and into a simulated NV3041A panel that can dump each transferred frame as a PPM
+
+#include "Arduino.h"
+
+#define GFX_NOT_DEFINED -1
+
+// ===== Colors =====
+
+#define BLACK 0x0000
+#define NAVY 0x000F
+#define DARKGREEN 0x03E0
+#define BLUE 0x001F
+#define GREEN 0x07E0
+#define CYAN 0x07FF
+#define RED 0xF800
+#define MAGENTA 0xF81F
+#define YELLOW 0xFFE0
+#define ORANGE 0xFDA0
+#define WHITE 0xFFFF
+
+class Arduino_NV3041A;
+
+// ===== Data Bus =====
+
+class Arduino_DataBus
+{
+public:
+    virtual ~Arduino_DataBus() {}
+    virtual bool begin(int32_t speed = GFX_NOT_DEFINED, int8_t dataMode = GFX_NOT_DEFINED) { return true; }
+    virtual void writePixels(uint16_t *data, uint32_t len);
+
+    // Host only: the panel that receives the pixels written on this bus
+    void attachPanel(Arduino_NV3041A *attachedPanel) { panel = attachedPanel; }
+
+protected:
+    Arduino_NV3041A *panel = nullptr;
+};
+
+class Arduino_ESP32QSPI : public Arduino_DataBus
+{
+public:
+    Arduino_ESP32QSPI(int8_t cs, int8_t sck, int8_t mosi, int8_t miso, int8_t quadwp, int8_t quadhd, bool is_shared_interface = false) {}
+};
+
+// ===== Graphics Base =====
+
+class Arduino_G
+{
+public:
+    Arduino_G(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {}
+    virtual ~Arduino_G() {}
+    virtual bool begin(int32_t speed = GFX_NOT_DEFINED) = 0;
+    virtual void draw16bitRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) = 0;
+
+protected:
+    int16_t WIDTH;
+    int16_t HEIGHT;
+};
+
+class Arduino_GFX : public Arduino_G
+{
+public:
+    Arduino_GFX(int16_t w, int16_t h) : Arduino_G(w, h) {}
+
+    virtual void startWrite() {}
+    virtual void endWrite() {}
+    virtual void writePixelPreclipped(int16_t x, int16_t y, uint16_t color) = 0;
+    virtual void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    virtual void flush(bool force_flush = false) {}
+
+    int16_t width() const { return WIDTH; }
+    int16_t height() const { return HEIGHT; }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillScreen(uint16_t color) { fillRect(0, 0, WIDTH, HEIGHT, color); }
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg);
+    void draw16bitRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) override;
+
+    void setCursor(int16_t x, int16_t y)
+    {
+        cursor_x = x;
+        cursor_y = y;
+    }
+    int16_t getCursorX() const { return cursor_x; }
+    int16_t getCursorY() const { return cursor_y; }
+    void setTextSize(uint8_t s) { textsize_x = textsize_y = s > 0 ? s : 1; }
+    void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+    void setTextColor(uint16_t c, uint16_t bg)
+    {
+        textcolor = c;
+        textbgcolor = bg;
+    }
+    void setTextWrap(bool w) { wrap = w; }
+
+    size_t write(uint8_t c);
+    size_t print(const String &text) { return print(text.c_str()); }
+    size_t print(const char *text);
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t println(const String &text) { return print(text) + print("\r\n"); }
+    size_t println(const char *text) { return print(text) + print("\r\n"); }
+    size_t println() { return print("\r\n"); }
+
+protected:
+    int16_t cursor_x = 0;
+    int16_t cursor_y = 0;
+    uint8_t textsize_x = 1;
+    uint8_t textsize_y = 1;
+    uint16_t textcolor = WHITE;
+    uint16_t textbgcolor = WHITE;
+    bool wrap = true;
+};
+
+// ===== Panel =====
+
+class Arduino_TFT : public Arduino_GFX
+{
+public:
+    Arduino_TFT(Arduino_DataBus *bus, int16_t w, int16_t h) : Arduino_GFX(w, h), _bus(bus) {}
+    virtual void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) = 0;
+
+protected:
+    Arduino_DataBus *_bus;
+};
+
+// Simulated panel: keeps its own display RAM, so what it shows only changes through bus transfers
+class Arduino_NV3041A : public Arduino_TFT
+{
+public:
+    Arduino_NV3041A(Arduino_DataBus *bus, int8_t rst = GFX_NOT_DEFINED, uint8_t r = 0, bool ips = false, int16_t w = 480, int16_t h = 272);
+    ~Arduino_NV3041A();
+
+    bool begin(int32_t speed = GFX_NOT_DEFINED) override;
+    void startWrite() override;
+    void endWrite() override;
+    void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) override;
+    void writePixelPreclipped(int16_t x, int16_t y, uint16_t color) override;
+    void draw16bitRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) override;
+
+    // Host only: receives the pixels written on the bus into the current address window
+    void receivePixels(const uint16_t *data, uint32_t len);
+
+    // Host only: the panel's display RAM, one RGB565 value per pixel
+    const uint16_t *getDisplayRam() const { return displayRam; }
+
+private:
+    uint16_t *displayRam = nullptr;
+    int16_t windowX = 0;
+    int16_t windowY = 0;
+    uint16_t windowW = 0;
+    uint16_t windowH = 0;
+    uint32_t windowPosition = 0;
+    uint32_t pixelsThisWrite = 0;
+};
+
+// ===== Canvas =====
+
+class Arduino_Canvas : public Arduino_GFX
+{
+public:
+    Arduino_Canvas(int16_t w, int16_t h, Arduino_G *output, int16_t output_x = 0, int16_t output_y = 0, uint8_t rotation = 0);
+    ~Arduino_Canvas();
+
+    bool begin(int32_t speed = GFX_NOT_DEFINED) override;
+    void writePixelPreclipped(int16_t x, int16_t y, uint16_t color) override;
+    void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void flush(bool force_flush = false) override;
+    uint16_t *getFramebuffer() { return _framebuffer; }
+
+protected:
+    uint16_t *_framebuffer = nullptr;
+    Arduino_G *_output;
+    int16_t _output_x;
+    int16_t _output_y;
+};
+
+// ===== Host Statistics =====
+
+struct HostPanelStats
+{
+    uint32_t frames;
+    uint64_t pixelsTransferred;
+    uint32_t allocatingFrames;    // Transfers with a heap allocation since the transfer before them
+    uint32_t lastAllocatingFrame; // Number of the last of those, zero when there was none
+    uint64_t renderMicros;        // Host time spent between the transfers, what the firmware took to draw and send them
+    uint64_t slowestFrameMicros;
+    uint32_t slowestFrame;
+    bool goldenCompared;          // The frames were checked against a golden hash file instead of writing it
+    uint32_t goldenFrames;        // Hashes in that file
+    uint32_t goldenMismatches;    // Transfers that left a different frame than the golden one, or had none to compare with
+    uint32_t firstGoldenMismatch; // Number of the first of those, zero when there was none
+};
+
+// Returns how many bus transfers reached the simulated panel, how many pixels they carried, which ones followed a heap allocation,
+// what they cost to render and how they compared against the golden frame hashes
+HostPanelStats hostPanelStats();
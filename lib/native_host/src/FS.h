@@ -0,0 +1,107 @@
+#pragma once
+
+#include <ctime>
+#include <memory>
+#include <string>
+
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs
+{
+    enum SeekMode
+    {
+        SeekSet = 0,
+        SeekCur = 1,
+        SeekEnd = 2
+    };
+
+    class FileImpl;
+    typedef std::shared_ptr<FileImpl> FileImplPtr;
+
+    // ===== Host File =====
+
+    // Mirrors the ESP32 fs::File handle, a file or directory inside the host directory backing the FS
+    class File
+    {
+    public:
+        File(FileImplPtr impl = FileImplPtr()) : impl(impl) {}
+
+        size_t write(uint8_t byte);
+        size_t write(const uint8_t *buffer, size_t size);
+        int available();
+        int read();
+        int peek();
+        size_t read(uint8_t *buffer, size_t size);
+        size_t readBytes(char *buffer, size_t length) { return read((uint8_t *)buffer, length); }
+        String readString();
+        String readStringUntil(char terminator);
+        bool seek(uint32_t pos, SeekMode mode);
+        bool seek(uint32_t pos) { return seek(pos, SeekSet); }
+        size_t position() const;
+        size_t size() const;
+        void flush();
+        void close();
+        time_t getLastWrite();
+        const char *path() const;
+        const char *name() const;
+
+        bool isDirectory();
+        File openNextFile(const char *mode = FILE_READ);
+        void rewindDirectory();
+
+        operator bool() const;
+
+    protected:
+        FileImplPtr impl;
+    };
+
+    // ===== Host Filesystem =====
+
+    // Resolves every path relative to a local directory that stands in for the card root
+    class FS
+    {
+    public:
+        explicit FS(const std::string &rootDirectory = std::string()) : rootDirectory(rootDirectory) {}
+
+        File open(const char *path, const char *mode = FILE_READ, const bool create = false);
+        File open(const String &path, const char *mode = FILE_READ, const bool create = false) { return open(path.c_str(), mode, create); }
+
+        bool exists(const char *path);
+        bool exists(const String &path) { return exists(path.c_str()); }
+        bool remove(const char *path);
+        bool remove(const String &path) { return remove(path.c_str()); }
+        bool rename(const char *pathFrom, const char *pathTo);
+        bool mkdir(const char *path);
+        bool mkdir(const String &path) { return mkdir(path.c_str()); }
+
+        void setRootDirectory(const std::string &directory) { rootDirectory = directory; }
+        const std::string &getRootDirectory() const { return rootDirectory; }
+
+    protected:
+        std::string hostPath(const char *path) const;
+
+        std::string rootDirectory;
+    };
+}
+
+// ===== Host Statistics =====
+
+struct HostFileStats
+{
+    uint32_t reads; // Calls that read from a file, each one a transfer the card would have to start
+    uint64_t bytesRead;
+};
+
+// Returns how many reads reached the files behind every FS and how many bytes they carried
+HostFileStats hostFileStats();
+
+using fs::File;
+using fs::FS;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekMode;
+using fs::SeekSet;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "FS.h"
+#include "SPI.h"
+
+typedef enum
+{
+    CARD_NONE,
+    CARD_MMC,
+    CARD_SD,
+    CARD_SDHC,
+    CARD_UNKNOWN
+} sdcard_type_t;
+
+namespace fs
+{
+    // ===== Host SD Card =====
+
+    // SD card backed by the directory in PORTFOLIO_SD_ROOT (defaults to ./sdcard), whose raw sector reads fail above the bus
+    // clock in PORTFOLIO_SD_MAX_FREQUENCY when it is set. It reports the size of a 32 GB card whatever the host volume holds
+    class SDFS : public FS
+    {
+    public:
+        bool begin(uint8_t ssPin = 10, SPIClass &spi = defaultSPI, uint32_t frequency = 4000000, const char *mountpoint = "/sd", uint8_t max_files = 5, bool format_if_empty = false);
+        void end() { mounted = false; }
+        sdcard_type_t cardType() { return mounted ? CARD_SDHC : CARD_NONE; }
+        uint64_t cardSize();
+        uint64_t totalBytes();
+        uint64_t usedBytes();
+        bool readRAW(uint8_t *buffer, uint32_t sector);
+
+    private:
+        static SPIClass defaultSPI;
+        bool mounted = false;
+        uint32_t frequency = 0;
+    };
+}
+
+extern fs::SDFS SD;
+
+using namespace fs;
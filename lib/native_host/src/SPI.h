@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+#define FSPI 0
+#define HSPI 1
+
+// ===== Host SPI Bus =====
+
+// The host SD card is a local directory, so the bus only has to accept the calls
+class SPIClass
+{
+public:
+    explicit SPIClass(uint8_t spiBus = HSPI) {}
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void end() {}
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// ===== Host String =====
+
+// Subset of the Arduino String class used by the firmware, backed by std::string
+class String
+{
+public:
+    String() {}
+    String(const char *text) : value(text ? text : "") {}
+    String(const std::string &text) : value(text) {}
+    explicit String(char character) : value(1, character) {}
+    String(int number) : value(std::to_string(number)) {}
+    String(unsigned int number) : value(std::to_string(number)) {}
+    String(long number) : value(std::to_string(number)) {}
+    String(unsigned long number) : value(std::to_string(number)) {}
+    String(long long number) : value(std::to_string(number)) {}
+    String(unsigned long long number) : value(std::to_string(number)) {}
+    String(float number, unsigned int decimalPlaces = 2) : String((double)number, decimalPlaces) {}
+    String(double number, unsigned int decimalPlaces = 2)
+    {
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, number);
+        value = buffer;
+    }
+
+    unsigned int length() const { return value.length(); }
+    bool isEmpty() const { return value.empty(); }
+    const char *c_str() const { return value.c_str(); }
+    bool reserve(unsigned int size)
+    {
+        value.reserve(size);
+        return true;
+    }
+
+    char charAt(unsigned int index) const { return index < value.length() ? value[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index) { return value[index]; }
+
+    String substring(unsigned int from) const { return from < value.length() ? String(value.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to)
+        {
+            std::swap(from, to);
+        }
+        if (from >= value.length())
+        {
+            return String();
+        }
+        return String(value.substr(from, to - from));
+    }
+
+    int indexOf(char character, unsigned int from = 0) const { return toIndex(value.find(character, from)); }
+    int indexOf(const String &text, unsigned int from = 0) const { return toIndex(value.find(text.value, from)); }
+    int lastIndexOf(char character) const { return toIndex(value.rfind(character)); }
+
+    bool startsWith(const String &prefix) const { return value.compare(0, prefix.value.length(), prefix.value) == 0; }
+    bool endsWith(const String &suffix) const
+    {
+        return value.length() >= suffix.value.length() &&
+               value.compare(value.length() - suffix.value.length(), suffix.value.length(), suffix.value) == 0;
+    }
+    bool equals(const String &other) const { return value == other.value; }
+
+    void trim()
+    {
+        size_t begin = value.find_first_not_of(" \t\r\n");
+        size_t end = value.find_last_not_of(" \t\r\n");
+        value = begin == std::string::npos ? std::string() : value.substr(begin, end - begin + 1);
+    }
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1)
+    {
+        if (index < value.length())
+        {
+            value.erase(index, count);
+        }
+    }
+    void toLowerCase()
+    {
+        for (char &character : value)
+        {
+            character = (char)tolower((unsigned char)character);
+        }
+    }
+    long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+
+    bool concat(const String &text)
+    {
+        value += text.value;
+        return true;
+    }
+    bool concat(const char *text, unsigned int length)
+    {
+        value.append(text, length);
+        return true;
+    }
+    bool concat(char character)
+    {
+        value += character;
+        return true;
+    }
+
+    String &operator+=(const String &text)
+    {
+        value += text.value;
+        return *this;
+    }
+    String &operator+=(const char *text)
+    {
+        value += text;
+        return *this;
+    }
+    String &operator+=(char character)
+    {
+        value += character;
+        return *this;
+    }
+
+    friend String operator+(const String &left, const String &right) { return String(left.value + right.value); }
+    friend String operator+(const String &left, const char *right) { return String(left.value + right); }
+    friend String operator+(const char *left, const String &right) { return String(left + right.value); }
+    friend String operator+(const String &left, char right) { return String(left.value + right); }
+
+    friend bool operator==(const String &left, const String &right) { return left.value == right.value; }
+    friend bool operator==(const String &left, const char *right) { return left.value == right; }
+    friend bool operator!=(const String &left, const String &right) { return left.value != right.value; }
+    friend bool operator!=(const String &left, const char *right) { return left.value != right; }
+    friend bool operator<(const String &left, const String &right) { return left.value < right.value; }
+
+private:
+    static int toIndex(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+
+    std::string value;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define CT_SUCCESS 0
+#define CT_ERROR -1
+
+// ===== Host Touch Panel =====
+
+typedef struct _fttouchinfo
+{
+    int count;
+    uint16_t x[5], y[5];
+    uint8_t pressure[5], area[5];
+} TOUCHINFO;
+
+// Touch panel fed by the script in PORTFOLIO_TOUCH_SCRIPT instead of the I2C controller.
+// Every script line is "<start ms> <duration ms> <x> <y> [<end x> <end y>]", the finger is down for that span of virtual time.
+class BBCapTouch
+{
+public:
+    int init(int iSDA, int iSCL, int iRST = -1, int iINT = -1, uint32_t u32Speed = 400000);
+    int getSamples(TOUCHINFO *pTI);
+};
+
+// One readTouchScreen() result from a trace recorded on the device, the fields of TouchAction with the button as its number
+struct HostTracedTouch
+{
+    unsigned long time;
+    uint8_t button;
+    int16_t dragDistance;
+    float flingVelocity;
+    bool dragging;
+    int16_t tapX; // -1 without a tap, and in traces recorded before taps were
+    int16_t tapY;
+};
+
+// Returns true once the touch script or trace has played out, so a headless run knows when to stop
+bool hostTouchScriptFinished();
+
+// Returns true when PORTFOLIO_TOUCH_TRACE holds a recorded trace, readTouchScreen() then replays it instead of the panel
+bool hostTouchTraceActive();
+
+// Waits at most the wait time in milliseconds of virtual time for the next traced touch, and returns true when it came
+bool hostNextTracedTouch(HostTracedTouch &touch, uint32_t maximumWaitTime);
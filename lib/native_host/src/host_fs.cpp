@@ -0,0 +1,386 @@
+#include "SD.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+// ===== Host Card Configuration =====
+
+// Size the host card reports, the same on every host so the boot screen and its frame hashes do not depend on the volume
+#define HOST_SD_CARD_SIZE 31914983424ULL // A 32 GB card
+
+// ===== Host Statistics =====
+
+static HostFileStats fileStats = {0, 0};
+
+HostFileStats hostFileStats()
+{
+    return fileStats;
+}
+
+namespace fs
+{
+    // ===== Host File Implementation =====
+
+    class FileImpl
+    {
+    public:
+        ~FileImpl() { close(); }
+
+        void close()
+        {
+            if (handle)
+            {
+                fclose(handle);
+                handle = nullptr;
+            }
+            directoryEntries.clear();
+            isOpen = false;
+        }
+
+        FS *owner = nullptr;
+        std::string virtualPath;
+        std::string localPath;
+        std::string baseName;
+        FILE *handle = nullptr;
+        bool directory = false;
+        bool isOpen = false;
+        std::vector<std::string> directoryEntries;
+        size_t nextDirectoryEntry = 0;
+    };
+
+    // ===== File Implementations =====
+
+    size_t File::write(uint8_t byte)
+    {
+        return write(&byte, 1);
+    }
+
+    size_t File::write(const uint8_t *buffer, size_t size)
+    {
+        if (!impl || !impl->handle)
+        {
+            return 0;
+        }
+        return fwrite(buffer, 1, size, impl->handle);
+    }
+
+    int File::available()
+    {
+        if (!impl || !impl->handle)
+        {
+            return 0;
+        }
+        return (int)(size() - position());
+    }
+
+    int File::read()
+    {
+        if (!impl || !impl->handle)
+        {
+            return -1;
+        }
+        int character = fgetc(impl->handle);
+        fileStats.reads++;
+        fileStats.bytesRead += character == EOF ? 0 : 1;
+        return character == EOF ? -1 : character;
+    }
+
+    int File::peek()
+    {
+        int character = read();
+        if (character >= 0)
+        {
+            ungetc(character, impl->handle);
+        }
+        return character;
+    }
+
+    size_t File::read(uint8_t *buffer, size_t size)
+    {
+        if (!impl || !impl->handle)
+        {
+            return 0;
+        }
+        size_t readAmount = fread(buffer, 1, size, impl->handle);
+        fileStats.reads++;
+        fileStats.bytesRead += readAmount;
+        return readAmount;
+    }
+
+    String File::readString()
+    {
+        String result;
+        uint8_t buffer[512];
+        size_t readAmount;
+        while ((readAmount = read(buffer, sizeof(buffer))) > 0)
+        {
+            result.concat((const char *)buffer, readAmount);
+        }
+        return result;
+    }
+
+    String File::readStringUntil(char terminator)
+    {
+        String result;
+        int character;
+        while ((character = read()) >= 0 && character != terminator)
+        {
+            result.concat((char)character);
+        }
+        return result;
+    }
+
+    bool File::seek(uint32_t pos, SeekMode mode)
+    {
+        if (!impl || !impl->handle)
+        {
+            return false;
+        }
+        int whence = mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END);
+        return fseek(impl->handle, pos, whence) == 0;
+    }
+
+    size_t File::position() const
+    {
+        if (!impl || !impl->handle)
+        {
+            return 0;
+        }
+        return ftell(impl->handle);
+    }
+
+    size_t File::size() const
+    {
+        struct stat fileStat;
+        if (!impl || stat(impl->localPath.c_str(), &fileStat) != 0)
+        {
+            return 0;
+        }
+        return impl->directory ? 0 : fileStat.st_size;
+    }
+
+    void File::flush()
+    {
+        if (impl && impl->handle)
+        {
+            fflush(impl->handle);
+        }
+    }
+
+    void File::close()
+    {
+        if (impl)
+        {
+            impl->close();
+        }
+    }
+
+    time_t File::getLastWrite()
+    {
+        struct stat fileStat;
+        if (!impl || stat(impl->localPath.c_str(), &fileStat) != 0)
+        {
+            return 0;
+        }
+        return fileStat.st_mtime;
+    }
+
+    const char *File::path() const
+    {
+        return impl ? impl->virtualPath.c_str() : nullptr;
+    }
+
+    const char *File::name() const
+    {
+        return impl ? impl->baseName.c_str() : nullptr;
+    }
+
+    bool File::isDirectory()
+    {
+        return impl && impl->directory;
+    }
+
+    File File::openNextFile(const char *mode)
+    {
+        if (!impl || !impl->directory || impl->nextDirectoryEntry >= impl->directoryEntries.size())
+        {
+            return File();
+        }
+        std::string childPath = impl->virtualPath;
+        if (childPath.empty() || childPath.back() != '/')
+        {
+            childPath += '/';
+        }
+        childPath += impl->directoryEntries[impl->nextDirectoryEntry++];
+        return impl->owner->open(childPath.c_str(), mode);
+    }
+
+    void File::rewindDirectory()
+    {
+        if (impl)
+        {
+            impl->nextDirectoryEntry = 0;
+        }
+    }
+
+    File::operator bool() const
+    {
+        return impl && impl->isOpen;
+    }
+
+    // ===== FS Implementations =====
+
+    std::string FS::hostPath(const char *path) const
+    {
+        std::string result = rootDirectory;
+        if (path && path[0] != '/')
+        {
+            result += '/';
+        }
+        result += path ? path : "";
+        return result;
+    }
+
+    File FS::open(const char *path, const char *mode, const bool create)
+    {
+        FileImplPtr impl = std::make_shared<FileImpl>();
+        impl->owner = this;
+        impl->virtualPath = path[0] == '/' ? path : std::string("/") + path;
+        impl->localPath = hostPath(path);
+        impl->baseName = impl->virtualPath.substr(impl->virtualPath.find_last_of('/') + 1);
+
+        struct stat fileStat;
+        if (stat(impl->localPath.c_str(), &fileStat) == 0 && S_ISDIR(fileStat.st_mode))
+        {
+            DIR *directory = opendir(impl->localPath.c_str());
+            if (!directory)
+            {
+                return File();
+            }
+            struct dirent *entry;
+            while ((entry = readdir(directory)) != nullptr)
+            {
+                if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+                {
+                    impl->directoryEntries.push_back(entry->d_name);
+                }
+            }
+            closedir(directory);
+            // Keep the listing order stable between runs, a real FAT keeps creation order
+            std::sort(impl->directoryEntries.begin(), impl->directoryEntries.end());
+            impl->directory = true;
+            impl->isOpen = true;
+            return File(impl);
+        }
+
+        const char *hostMode = strcmp(mode, FILE_WRITE) == 0 ? "wb" : (strcmp(mode, FILE_APPEND) == 0 ? "ab" : "rb");
+        impl->handle = fopen(impl->localPath.c_str(), hostMode);
+        if (!impl->handle)
+        {
+            return File();
+        }
+        impl->isOpen = true;
+        return File(impl);
+    }
+
+    bool FS::exists(const char *path)
+    {
+        struct stat fileStat;
+        return stat(hostPath(path).c_str(), &fileStat) == 0;
+    }
+
+    bool FS::remove(const char *path)
+    {
+        return unlink(hostPath(path).c_str()) == 0;
+    }
+
+    bool FS::rename(const char *pathFrom, const char *pathTo)
+    {
+        return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+    }
+
+    bool FS::mkdir(const char *path)
+    {
+        return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+    }
+
+    // ===== SD Implementations =====
+
+    static uint64_t directorySize(const std::string &localPath)
+    {
+        uint64_t size = 0;
+        DIR *directory = opendir(localPath.c_str());
+        if (!directory)
+        {
+            return 0;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(directory)) != nullptr)
+        {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            {
+                continue;
+            }
+            std::string childPath = localPath + "/" + entry->d_name;
+            struct stat childStat;
+            if (stat(childPath.c_str(), &childStat) == 0)
+            {
+                size += S_ISDIR(childStat.st_mode) ? directorySize(childPath) : (uint64_t)childStat.st_size;
+            }
+        }
+        closedir(directory);
+        return size;
+    }
+
+    SPIClass SDFS::defaultSPI;
+
+    bool SDFS::begin(uint8_t ssPin, SPIClass &spi, uint32_t frequency, const char *mountpoint, uint8_t max_files, bool format_if_empty)
+    {
+        const char *root = getenv("PORTFOLIO_SD_ROOT");
+        setRootDirectory(root ? root : "sdcard");
+        this->frequency = frequency;
+
+        struct stat rootStat;
+        mounted = stat(rootDirectory.c_str(), &rootStat) == 0 && S_ISDIR(rootStat.st_mode);
+        return mounted;
+    }
+
+    uint64_t SDFS::cardSize()
+    {
+        return totalBytes();
+    }
+
+    uint64_t SDFS::totalBytes()
+    {
+        return mounted ? HOST_SD_CARD_SIZE : 0;
+    }
+
+    uint64_t SDFS::usedBytes()
+    {
+        // Only count the card's own files, the rest of the host volume changes from run to run
+        return mounted ? directorySize(rootDirectory) : 0;
+    }
+
+    bool SDFS::readRAW(uint8_t *buffer, uint32_t sector)
+    {
+        // Stands in for a card whose transfers fail their CRC checks above a clock. Only the boot signature of the first
+        // sector is there to be read, the files of the card are not laid out in sectors
+        const char *maximumFrequency = getenv("PORTFOLIO_SD_MAX_FREQUENCY");
+        if (!mounted || (maximumFrequency && frequency > strtoul(maximumFrequency, nullptr, 10)))
+        {
+            return false;
+        }
+        memset(buffer, 0, 512);
+        if (sector == 0)
+        {
+            buffer[510] = 0x55;
+            buffer[511] = 0xAA;
+        }
+        return true;
+    }
+}
+
+fs::SDFS SD;
@@ -0,0 +1,500 @@
+#include "Arduino_GFX_Library.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+// ===== Font =====
+
+// Printable ASCII range of the classic 5x7 GFX font, column-major with the LSB at the top
+static const uint8_t FONT_FIRST_CHARACTER = 0x20;
+static const uint8_t FONT_LAST_CHARACTER = 0x7E;
+static const uint8_t hostFont[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5F, 0x00, 0x00, 0x00, 0x07, 0x00, 0x07, 0x00, 0x14, 0x7F, 0x14, 0x7F, 0x14,
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, 0x23, 0x13, 0x08, 0x64, 0x62, 0x36, 0x49, 0x56, 0x20, 0x50, 0x00, 0x08, 0x07, 0x03, 0x00,
+    0x00, 0x1C, 0x22, 0x41, 0x00, 0x00, 0x41, 0x22, 0x1C, 0x00, 0x2A, 0x1C, 0x7F, 0x1C, 0x2A, 0x08, 0x08, 0x3E, 0x08, 0x08,
+    0x00, 0x80, 0x70, 0x30, 0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x60, 0x60, 0x00, 0x20, 0x10, 0x08, 0x04, 0x02,
+    0x3E, 0x51, 0x49, 0x45, 0x3E, 0x00, 0x42, 0x7F, 0x40, 0x00, 0x72, 0x49, 0x49, 0x49, 0x46, 0x21, 0x41, 0x49, 0x4D, 0x33,
+    0x18, 0x14, 0x12, 0x7F, 0x10, 0x27, 0x45, 0x45, 0x45, 0x39, 0x3C, 0x4A, 0x49, 0x49, 0x31, 0x41, 0x21, 0x11, 0x09, 0x07,
+    0x36, 0x49, 0x49, 0x49, 0x36, 0x46, 0x49, 0x49, 0x29, 0x1E, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x40, 0x34, 0x00, 0x00,
+    0x00, 0x08, 0x14, 0x22, 0x41, 0x14, 0x14, 0x14, 0x14, 0x14, 0x00, 0x41, 0x22, 0x14, 0x08, 0x02, 0x01, 0x59, 0x09, 0x06,
+    0x3E, 0x41, 0x5D, 0x59, 0x4E, 0x7C, 0x12, 0x11, 0x12, 0x7C, 0x7F, 0x49, 0x49, 0x49, 0x36, 0x3E, 0x41, 0x41, 0x41, 0x22,
+    0x7F, 0x41, 0x41, 0x41, 0x3E, 0x7F, 0x49, 0x49, 0x49, 0x41, 0x7F, 0x09, 0x09, 0x09, 0x01, 0x3E, 0x41, 0x41, 0x51, 0x73,
+    0x7F, 0x08, 0x08, 0x08, 0x7F, 0x00, 0x41, 0x7F, 0x41, 0x00, 0x20, 0x40, 0x41, 0x3F, 0x01, 0x7F, 0x08, 0x14, 0x22, 0x41,
+    0x7F, 0x40, 0x40, 0x40, 0x40, 0x7F, 0x02, 0x1C, 0x02, 0x7F, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x3E, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x09, 0x09, 0x09, 0x06, 0x3E, 0x41, 0x51, 0x21, 0x5E, 0x7F, 0x09, 0x19, 0x29, 0x46, 0x26, 0x49, 0x49, 0x49, 0x32,
+    0x03, 0x01, 0x7F, 0x01, 0x03, 0x3F, 0x40, 0x40, 0x40, 0x3F, 0x1F, 0x20, 0x40, 0x20, 0x1F, 0x3F, 0x40, 0x38, 0x40, 0x3F,
+    0x63, 0x14, 0x08, 0x14, 0x63, 0x03, 0x04, 0x78, 0x04, 0x03, 0x61, 0x59, 0x49, 0x4D, 0x43, 0x00, 0x7F, 0x41, 0x41, 0x41,
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x00, 0x41, 0x41, 0x41, 0x7F, 0x04, 0x02, 0x01, 0x02, 0x04, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x00, 0x03, 0x07, 0x08, 0x00, 0x20, 0x54, 0x54, 0x78, 0x40, 0x7F, 0x28, 0x44, 0x44, 0x38, 0x38, 0x44, 0x44, 0x44, 0x28,
+    0x38, 0x44, 0x44, 0x28, 0x7F, 0x38, 0x54, 0x54, 0x54, 0x18, 0x00, 0x08, 0x7E, 0x09, 0x02, 0x18, 0xA4, 0xA4, 0x9C, 0x78,
+    0x7F, 0x08, 0x04, 0x04, 0x78, 0x00, 0x44, 0x7D, 0x40, 0x00, 0x20, 0x40, 0x40, 0x3D, 0x00, 0x7F, 0x10, 0x28, 0x44, 0x00,
+    0x00, 0x41, 0x7F, 0x40, 0x00, 0x7C, 0x04, 0x78, 0x04, 0x78, 0x7C, 0x08, 0x04, 0x04, 0x78, 0x38, 0x44, 0x44, 0x44, 0x38,
+    0xFC, 0x18, 0x24, 0x24, 0x18, 0x18, 0x24, 0x24, 0x18, 0xFC, 0x7C, 0x08, 0x04, 0x04, 0x08, 0x48, 0x54, 0x54, 0x54, 0x24,
+    0x04, 0x04, 0x3F, 0x44, 0x24, 0x3C, 0x40, 0x40, 0x20, 0x7C, 0x1C, 0x20, 0x40, 0x20, 0x1C, 0x3C, 0x40, 0x30, 0x40, 0x3C,
+    0x44, 0x28, 0x10, 0x28, 0x44, 0x4C, 0x90, 0x90, 0x90, 0x7C, 0x44, 0x64, 0x54, 0x4C, 0x44, 0x00, 0x08, 0x36, 0x41, 0x00,
+    0x00, 0x00, 0x77, 0x00, 0x00, 0x00, 0x41, 0x36, 0x08, 0x00, 0x02, 0x01, 0x02, 0x04, 0x02};
+
+// ===== Time =====
+
+// The virtual clock lives with the panel, which logs it with every transfer, so tools that only link the display build too
+static unsigned long virtualMicros = 0;
+
+unsigned long millis()
+{
+    return virtualMicros / 1000;
+}
+
+unsigned long micros()
+{
+    return virtualMicros;
+}
+
+void delay(unsigned long ms)
+{
+    virtualMicros += ms * 1000;
+}
+
+// ===== Host Statistics =====
+
+static HostPanelStats panelStats = {};
+static unsigned long heapAllocationsAtLastFrame = 0;
+static std::chrono::steady_clock::time_point lastTransferEnd = std::chrono::steady_clock::now();
+
+HostPanelStats hostPanelStats()
+{
+    return panelStats;
+}
+
+// ===== Frame Hashes =====
+
+static std::vector<uint64_t> goldenHashes;
+static FILE *goldenRecordFile = nullptr;
+static FILE *frameLogFile = nullptr;
+static bool frameChecksOpened = false;
+
+// 64-bit FNV-1a over the whole display RAM, a frame that differs in a single pixel gets another hash
+static uint64_t hashFrame(const uint16_t *displayRam, int32_t pixelAmount)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    const uint8_t *bytes = (const uint8_t *)displayRam;
+    for (int32_t i = 0; i < pixelAmount * 2; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Compare against the golden hash file in PORTFOLIO_GOLDEN_HASHES when it exists, otherwise record it. Also opens the
+// per-frame log in PORTFOLIO_FRAME_LOG
+static void openFrameChecks()
+{
+    frameChecksOpened = true;
+    const char *goldenPath = getenv("PORTFOLIO_GOLDEN_HASHES");
+    if (goldenPath)
+    {
+        FILE *goldenFile = fopen(goldenPath, "r");
+        if (goldenFile)
+        {
+            char line[64];
+            while (fgets(line, sizeof(line), goldenFile))
+            {
+                unsigned int frame;
+                unsigned long long hash;
+                if (sscanf(line, "%u %llx", &frame, &hash) == 2)
+                {
+                    goldenHashes.push_back(hash);
+                }
+            }
+            fclose(goldenFile);
+            panelStats.goldenCompared = true;
+            panelStats.goldenFrames = goldenHashes.size();
+        }
+        else
+        {
+            goldenRecordFile = fopen(goldenPath, "w");
+        }
+    }
+
+    const char *logPath = getenv("PORTFOLIO_FRAME_LOG");
+    if (logPath)
+    {
+        frameLogFile = fopen(logPath, "w");
+        if (frameLogFile)
+        {
+            fprintf(frameLogFile, "# frame virtual_ms pixels render_us hash\n");
+        }
+    }
+}
+
+// Check the frame a transfer left on the panel against its golden hash, and log what it cost
+static void checkFrame(const uint16_t *displayRam, int32_t pixelAmount, uint32_t pixels, uint64_t renderMicros)
+{
+    if (!frameChecksOpened)
+    {
+        openFrameChecks();
+    }
+    uint64_t hash = hashFrame(displayRam, pixelAmount);
+    uint32_t frame = panelStats.frames;
+    if (panelStats.goldenCompared && (frame > goldenHashes.size() || goldenHashes[frame - 1] != hash))
+    {
+        panelStats.goldenMismatches++;
+        if (panelStats.firstGoldenMismatch == 0)
+        {
+            panelStats.firstGoldenMismatch = frame;
+        }
+    }
+    if (goldenRecordFile)
+    {
+        fprintf(goldenRecordFile, "%u %016llx\n", (unsigned int)frame, (unsigned long long)hash);
+    }
+    if (frameLogFile)
+    {
+        fprintf(frameLogFile, "%u %lu %u %llu %016llx\n", (unsigned int)frame, millis(), (unsigned int)pixels,
+                (unsigned long long)renderMicros, (unsigned long long)hash);
+    }
+}
+
+// ===== Data Bus Implementations =====
+
+void Arduino_DataBus::writePixels(uint16_t *data, uint32_t len)
+{
+    if (panel)
+    {
+        panel->receivePixels(data, len);
+    }
+}
+
+// ===== GFX Implementations =====
+
+void Arduino_GFX::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if (x >= 0 && y >= 0 && x < WIDTH && y < HEIGHT)
+    {
+        writePixelPreclipped(x, y, color);
+    }
+}
+
+void Arduino_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    fillRect(x, y, w, 1, color);
+}
+
+void Arduino_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    fillRect(x, y, 1, h, color);
+}
+
+void Arduino_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    int16_t left = std::max<int16_t>(x, 0);
+    int16_t top = std::max<int16_t>(y, 0);
+    int16_t right = std::min<int16_t>(x + w, WIDTH);
+    int16_t bottom = std::min<int16_t>(y + h, HEIGHT);
+    if (right > left && bottom > top)
+    {
+        writeFillRectPreclipped(left, top, right - left, bottom - top, color);
+    }
+}
+
+void Arduino_GFX::writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    for (int16_t row = y; row < y + h; row++)
+    {
+        for (int16_t column = x; column < x + w; column++)
+        {
+            writePixelPreclipped(column, row, color);
+        }
+    }
+}
+
+void Arduino_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Arduino_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    int16_t dx = abs(x1 - x0);
+    int16_t dy = -abs(y1 - y0);
+    int16_t stepX = x0 < x1 ? 1 : -1;
+    int16_t stepY = y0 < y1 ? 1 : -1;
+    int32_t error = dx + dy;
+    while (true)
+    {
+        drawPixel(x0, y0, color);
+        if (x0 == x1 && y0 == y1)
+        {
+            break;
+        }
+        int32_t doubleError = 2 * error;
+        if (doubleError >= dy)
+        {
+            error += dy;
+            x0 += stepX;
+        }
+        if (doubleError <= dx)
+        {
+            error += dx;
+            y0 += stepY;
+        }
+    }
+}
+
+void Arduino_GFX::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+{
+    drawLine(x0, y0, x1, y1, color);
+    drawLine(x1, y1, x2, y2, color);
+    drawLine(x2, y2, x0, y0, color);
+}
+
+void Arduino_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+{
+    int16_t top = std::min(y0, std::min(y1, y2));
+    int16_t bottom = std::max(y0, std::max(y1, y2));
+    for (int16_t y = top; y <= bottom; y++)
+    {
+        int16_t left = INT16_MAX;
+        int16_t right = INT16_MIN;
+        const int16_t edges[3][4] = {{x0, y0, x1, y1}, {x1, y1, x2, y2}, {x2, y2, x0, y0}};
+        for (const auto &edge : edges)
+        {
+            if ((y >= edge[1] && y <= edge[3]) || (y >= edge[3] && y <= edge[1]))
+            {
+                int16_t x = edge[1] == edge[3] ? edge[0] : edge[0] + (int32_t)(y - edge[1]) * (edge[2] - edge[0]) / (edge[3] - edge[1]);
+                left = std::min(left, edge[1] == edge[3] ? std::min(edge[0], edge[2]) : x);
+                right = std::max(right, edge[1] == edge[3] ? std::max(edge[0], edge[2]) : x);
+            }
+        }
+        if (left <= right)
+        {
+            drawFastHLine(left, y, right - left + 1, color);
+        }
+    }
+}
+
+void Arduino_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg)
+{
+    if (c < FONT_FIRST_CHARACTER || c > FONT_LAST_CHARACTER)
+    {
+        c = '?';
+    }
+    const uint8_t *glyph = &hostFont[(c - FONT_FIRST_CHARACTER) * 5];
+    for (int8_t column = 0; column < 5; column++)
+    {
+        uint8_t line = pgm_read_byte(&glyph[column]);
+        for (int8_t row = 0; row < 8; row++, line >>= 1)
+        {
+            if (line & 1)
+            {
+                fillRect(x + column * textsize_x, y + row * textsize_y, textsize_x, textsize_y, color);
+            }
+            else if (bg != color)
+            {
+                fillRect(x + column * textsize_x, y + row * textsize_y, textsize_x, textsize_y, bg);
+            }
+        }
+    }
+    if (bg != color)
+    {
+        fillRect(x + 5 * textsize_x, y, textsize_x, 8 * textsize_y, bg);
+    }
+}
+
+void Arduino_GFX::draw16bitRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h)
+{
+    for (int16_t row = 0; row < h; row++)
+    {
+        for (int16_t column = 0; column < w; column++)
+        {
+            drawPixel(x + column, y + row, bitmap[row * w + column]);
+        }
+    }
+}
+
+size_t Arduino_GFX::write(uint8_t c)
+{
+    if (c == '\n')
+    {
+        cursor_x = 0;
+        cursor_y += (int16_t)textsize_y * 8;
+    }
+    else if (c != '\r')
+    {
+        if (wrap && cursor_x + textsize_x * 6 > WIDTH)
+        {
+            cursor_x = 0;
+            cursor_y += (int16_t)textsize_y * 8;
+        }
+        drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor);
+        cursor_x += textsize_x * 6;
+    }
+    return 1;
+}
+
+size_t Arduino_GFX::print(const char *text)
+{
+    size_t written = 0;
+    while (*text)
+    {
+        written += write((uint8_t)*text++);
+    }
+    return written;
+}
+
+// ===== Panel Implementations =====
+
+Arduino_NV3041A::Arduino_NV3041A(Arduino_DataBus *bus, int8_t rst, uint8_t r, bool ips, int16_t w, int16_t h)
+    : Arduino_TFT(bus, w, h)
+{
+    bus->attachPanel(this);
+}
+
+Arduino_NV3041A::~Arduino_NV3041A()
+{
+    free(displayRam);
+}
+
+bool Arduino_NV3041A::begin(int32_t speed)
+{
+    displayRam = (uint16_t *)calloc((size_t)WIDTH * HEIGHT, sizeof(uint16_t));
+    return displayRam != nullptr && _bus->begin(speed);
+}
+
+void Arduino_NV3041A::startWrite()
+{
+    pixelsThisWrite = 0;
+}
+
+void Arduino_NV3041A::endWrite()
+{
+    if (pixelsThisWrite == 0)
+    {
+        return;
+    }
+    panelStats.frames++;
+
+    // Virtual time stands still while the firmware draws, so the host time since the last transfer is what this one cost
+    std::chrono::steady_clock::time_point transferEnd = std::chrono::steady_clock::now();
+    uint64_t renderMicros = std::chrono::duration_cast<std::chrono::microseconds>(transferEnd - lastTransferEnd).count();
+    panelStats.renderMicros += renderMicros;
+    if (renderMicros > panelStats.slowestFrameMicros)
+    {
+        panelStats.slowestFrameMicros = renderMicros;
+        panelStats.slowestFrame = panelStats.frames;
+    }
+    checkFrame(displayRam, (int32_t)WIDTH * HEIGHT, pixelsThisWrite, renderMicros);
+
+    // Drawing a frame the user only scrolled or moved the indicator in should not need the heap
+    unsigned long heapAllocations = hostHeapAllocations();
+    if (heapAllocations != heapAllocationsAtLastFrame)
+    {
+        panelStats.allocatingFrames++;
+        panelStats.lastAllocatingFrame = panelStats.frames;
+        heapAllocationsAtLastFrame = heapAllocations;
+    }
+
+    // Every finished transfer is a frame the user would have seen, dump it when asked to
+    const char *frameDirectory = getenv("PORTFOLIO_FRAME_DIR");
+    if (!frameDirectory)
+    {
+        lastTransferEnd = std::chrono::steady_clock::now();
+        return;
+    }
+    char framePath[512];
+    snprintf(framePath, sizeof(framePath), "%s/frame_%05u.ppm", frameDirectory, (unsigned int)panelStats.frames);
+    FILE *frameFile = fopen(framePath, "wb");
+    if (!frameFile)
+    {
+        return;
+    }
+    fprintf(frameFile, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
+    for (int32_t i = 0; i < (int32_t)WIDTH * HEIGHT; i++)
+    {
+        uint16_t pixel = displayRam[i];
+        uint8_t rgb[3] = {(uint8_t)((pixel >> 8) & 0xF8), (uint8_t)((pixel >> 3) & 0xFC), (uint8_t)((pixel << 3) & 0xF8)};
+        fwrite(rgb, 1, 3, frameFile);
+    }
+    fclose(frameFile);
+    lastTransferEnd = std::chrono::steady_clock::now();
+}
+
+void Arduino_NV3041A::writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h)
+{
+    windowX = x;
+    windowY = y;
+    windowW = w;
+    windowH = h;
+    windowPosition = 0;
+}
+
+void Arduino_NV3041A::writePixelPreclipped(int16_t x, int16_t y, uint16_t color)
+{
+    displayRam[y * WIDTH + x] = color;
+}
+
+void Arduino_NV3041A::draw16bitRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h)
+{
+    startWrite();
+    writeAddrWindow(x, y, w, h);
+    _bus->writePixels(bitmap, (uint32_t)w * h);
+    endWrite();
+}
+
+void Arduino_NV3041A::receivePixels(const uint16_t *data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len && windowW > 0; i++, windowPosition++)
+    {
+        int32_t x = windowX + windowPosition % windowW;
+        int32_t y = windowY + (windowPosition / windowW) % windowH;
+        if (x >= 0 && y >= 0 && x < WIDTH && y < HEIGHT)
+        {
+            displayRam[y * WIDTH + x] = data[i];
+        }
+    }
+    pixelsThisWrite += len;
+    panelStats.pixelsTransferred += len;
+}
+
+// ===== Canvas Implementations =====
+
+Arduino_Canvas::Arduino_Canvas(int16_t w, int16_t h, Arduino_G *output, int16_t output_x, int16_t output_y, uint8_t rotation)
+    : Arduino_GFX(w, h), _output(output), _output_x(output_x), _output_y(output_y)
+{
+}
+
+Arduino_Canvas::~Arduino_Canvas()
+{
+    free(_framebuffer);
+}
+
+bool Arduino_Canvas::begin(int32_t speed)
+{
+    if (!_output->begin(speed))
+    {
+        return false;
+    }
+    _framebuffer = (uint16_t *)calloc((size_t)WIDTH * HEIGHT, sizeof(uint16_t));
+    return _framebuffer != nullptr;
+}
+
+void Arduino_Canvas::writePixelPreclipped(int16_t x, int16_t y, uint16_t color)
+{
+    _framebuffer[y * WIDTH + x] = color;
+}
+
+void Arduino_Canvas::writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    for (int16_t row = y; row < y + h; row++)
+    {
+        std::fill(_framebuffer + row * WIDTH + x, _framebuffer + row * WIDTH + x + w, color);
+    }
+}
+
+void Arduino_Canvas::flush(bool force_flush)
+{
+    _output->draw16bitRGBBitmap(_output_x, _output_y, _framebuffer, WIDTH, HEIGHT);
+}
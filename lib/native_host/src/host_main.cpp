@@ -0,0 +1,205 @@
+#include <unistd.h>
+
+#include <vector>
+
+#include "Arduino_GFX_Library.h"
+#include "bb_captouch.h"
+
+// ===== Host Configuration =====
+
+// Virtual time the device keeps running after the last scripted touch, so the final screen gets drawn
+#define HOST_SETTLE_TIME_MS 1000
+
+struct ScriptedTouch
+{
+    unsigned long startTime;
+    unsigned long duration;
+    uint16_t x;
+    uint16_t y;
+    uint16_t endX; // A touch that drags moves in a straight line from where it starts to here, otherwise the same as its start
+    uint16_t endY;
+};
+
+static std::vector<ScriptedTouch> touchScript;
+static std::vector<HostTracedTouch> touchTrace;
+static size_t nextTracedTouch = 0;
+
+HostSerial Serial;
+
+// ===== Serial =====
+
+int HostSerial::available()
+{
+    return 0;
+}
+
+int HostSerial::read()
+{
+    return -1;
+}
+
+// ===== Touch =====
+
+// Read the touch lines of a serial log recorded with TOUCH_TRACE_RECORD, everything else the firmware printed is skipped
+static bool loadTouchTrace(const char *tracePath)
+{
+    FILE *traceFile = fopen(tracePath, "r");
+    if (!traceFile)
+    {
+        return false;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), traceFile))
+    {
+        HostTracedTouch touch;
+        unsigned int button, dragging;
+        int dragDistance, tapX = -1, tapY = -1;
+        if (sscanf(line, "touch %lu %u %d %f %u %d %d", &touch.time, &button, &dragDistance, &touch.flingVelocity, &dragging, &tapX, &tapY) >= 5)
+        {
+            touch.button = button;
+            touch.dragDistance = dragDistance;
+            touch.dragging = dragging != 0;
+            touch.tapX = tapX;
+            touch.tapY = tapY;
+            touchTrace.push_back(touch);
+        }
+    }
+    fclose(traceFile);
+    return true;
+}
+
+int BBCapTouch::init(int iSDA, int iSCL, int iRST, int iINT, uint32_t u32Speed)
+{
+    const char *tracePath = getenv("PORTFOLIO_TOUCH_TRACE");
+    if (tracePath && !loadTouchTrace(tracePath))
+    {
+        return CT_ERROR;
+    }
+    const char *scriptPath = getenv("PORTFOLIO_TOUCH_SCRIPT");
+    if (!scriptPath)
+    {
+        return CT_SUCCESS;
+    }
+    FILE *scriptFile = fopen(scriptPath, "r");
+    if (!scriptFile)
+    {
+        return CT_ERROR;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), scriptFile))
+    {
+        ScriptedTouch touch;
+        unsigned int x, y, endX, endY;
+        int fields = line[0] == '#' ? 0 : sscanf(line, "%lu %lu %u %u %u %u", &touch.startTime, &touch.duration, &x, &y, &endX, &endY);
+        if (fields == 4 || fields == 6)
+        {
+            touch.x = x;
+            touch.y = y;
+            touch.endX = fields == 6 ? endX : x;
+            touch.endY = fields == 6 ? endY : y;
+            touchScript.push_back(touch);
+        }
+    }
+    fclose(scriptFile);
+    return CT_SUCCESS;
+}
+
+int BBCapTouch::getSamples(TOUCHINFO *pTI)
+{
+    unsigned long now = millis();
+    for (const ScriptedTouch &touch : touchScript)
+    {
+        if (now >= touch.startTime && now < touch.startTime + touch.duration)
+        {
+            long progress = now - touch.startTime;
+            pTI->count = 1;
+            pTI->x[0] = touch.x + ((long)touch.endX - touch.x) * progress / (long)touch.duration;
+            pTI->y[0] = touch.y + ((long)touch.endY - touch.y) * progress / (long)touch.duration;
+            pTI->pressure[0] = 1;
+            pTI->area[0] = 1;
+            return 1;
+        }
+    }
+    pTI->count = 0;
+    return 0;
+}
+
+// Virtual time the last scripted or traced touch ends at
+static unsigned long lastTouchEnd()
+{
+    unsigned long lastEnd = touchTrace.empty() ? 0 : touchTrace.back().time;
+    for (const ScriptedTouch &touch : touchScript)
+    {
+        lastEnd = std::max(lastEnd, touch.startTime + touch.duration);
+    }
+    return lastEnd;
+}
+
+bool hostTouchScriptFinished()
+{
+    return millis() > lastTouchEnd() + HOST_SETTLE_TIME_MS;
+}
+
+bool hostTouchTraceActive()
+{
+    return !touchTrace.empty();
+}
+
+bool hostNextTracedTouch(HostTracedTouch &touch, uint32_t maximumWaitTime)
+{
+    // Nothing can come after the run has settled, so waiting longer than that would only skip ahead
+    unsigned long now = millis();
+    unsigned long dueTime = nextTracedTouch < touchTrace.size() ? touchTrace[nextTracedTouch].time : lastTouchEnd() + HOST_SETTLE_TIME_MS + 1;
+    unsigned long waitTime = dueTime > now ? dueTime - now : 0;
+    if (waitTime > maximumWaitTime)
+    {
+        delay(maximumWaitTime);
+        return false;
+    }
+    delay(waitTime);
+    if (nextTracedTouch >= touchTrace.size())
+    {
+        return false;
+    }
+
+    // A touch the device recorded while this run was still booting is passed on as soon as the touch screen is read
+    touch = touchTrace[nextTracedTouch++];
+    return true;
+}
+
+// ===== Entry Point =====
+
+// Unit tests bring their own main and drive setup() and loop() themselves
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv)
+{
+    setup();
+    while (!hostTouchScriptFinished())
+    {
+        loop();
+    }
+
+    HostPanelStats stats = hostPanelStats();
+    fprintf(stderr, "host: %u panel transfers, %llu pixels, %lu ms virtual time\n",
+            (unsigned int)stats.frames, (unsigned long long)stats.pixelsTransferred, millis());
+    fprintf(stderr, "host: %lu heap allocations, %u panel transfers came after one, the last was transfer %u\n",
+            hostHeapAllocations(), (unsigned int)stats.allocatingFrames, (unsigned int)stats.lastAllocatingFrame);
+    if (stats.frames > 0)
+    {
+        fprintf(stderr, "host: %llu us average render cost per panel transfer, the slowest was transfer %u at %llu us\n",
+                (unsigned long long)(stats.renderMicros / stats.frames), (unsigned int)stats.slowestFrame,
+                (unsigned long long)stats.slowestFrameMicros);
+    }
+
+    // A replay that leaves other frames than the golden run, or another amount of them, is a regression
+    if (stats.goldenCompared)
+    {
+        bool matched = stats.goldenMismatches == 0 && stats.frames == stats.goldenFrames;
+        fprintf(stderr, "host: golden frames %s, %u of %u transfers differ, the first was transfer %u, %u golden frames\n",
+                matched ? "match" : "DIFFER", (unsigned int)stats.goldenMismatches, (unsigned int)stats.frames,
+                (unsigned int)stats.firstGoldenMismatch, (unsigned int)stats.goldenFrames);
+        return matched ? 0 : 1;
+    }
+    return 0;
+}
+#endif
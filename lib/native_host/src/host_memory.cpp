@@ -0,0 +1,76 @@
+#include "Arduino.h"
+
+#include <new>
+
+// ===== Heap Allocations =====
+
+static unsigned long heapAllocations = 0;
+
+unsigned long hostHeapAllocations()
+{
+    return heapAllocations;
+}
+
+void *ps_malloc(size_t size)
+{
+    heapAllocations++;
+    return malloc(size);
+}
+
+// Replacing the global new also counts what String and the standard containers allocate
+void *operator new(size_t size)
+{
+    heapAllocations++;
+    void *memory = malloc(size > 0 ? size : 1);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    heapAllocations++;
+    return malloc(size > 0 ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t size) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory, size_t size) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+    free(memory);
+}
@@ -0,0 +1,186 @@
+#include "compressed_text.h"
+#include "content_pack.h"
+
+// ===== Struct Definitions =====
+
+// Compressed bytes of one block, read from the file a chunk at a time
+struct CompressedInput
+{
+    File *file;
+    uint8_t chunk[COMPRESSED_TEXT_INPUT_CHUNK_SIZE];
+    size_t chunkLength = 0;
+    size_t chunkPosition = 0;
+    uint32_t remaining = 0; // Bytes of the block not read from the file yet
+    bool readFailed = false;
+};
+
+// ===== Internal Helpers =====
+
+// Take the next compressed byte, false at the end of the block or when the file could not be read
+static bool readCompressedByte(CompressedInput &input, uint8_t &byte)
+{
+    if (input.chunkPosition >= input.chunkLength)
+    {
+        if (input.remaining == 0)
+        {
+            return false;
+        }
+        size_t readLength = min((uint32_t)sizeof(input.chunk), input.remaining);
+        if (input.file->read(input.chunk, readLength) != readLength)
+        {
+            input.readFailed = true;
+            return false;
+        }
+        input.chunkLength = readLength;
+        input.chunkPosition = 0;
+        input.remaining -= readLength;
+    }
+    byte = input.chunk[input.chunkPosition++];
+    return true;
+}
+
+// ===== Functions Implementations =====
+
+uint32_t compressedTextHeaderChecksum(const CompressedTextHeader &header)
+{
+    return calculateChecksum((const uint8_t *)&header, offsetof(CompressedTextHeader, headerChecksum));
+}
+
+uint32_t countCompressedTextBlocks(uint16_t blockSize, uint32_t textSize)
+{
+    return (textSize + blockSize - 1) / blockSize;
+}
+
+StorageError readCompressedTextHeader(File &file, CompressedTextHeader &header)
+{
+    if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header))
+    {
+        return StorageError::READ_FAILED;
+    }
+    if (memcmp(header.magic, COMPRESSED_TEXT_MAGIC, sizeof(header.magic)) != 0 || header.version != COMPRESSED_TEXT_VERSION || header.blockSize == 0)
+    {
+        return StorageError::BAD_FORMAT;
+    }
+    if (compressedTextHeaderChecksum(header) != header.headerChecksum)
+    {
+        return StorageError::CHECKSUM_MISMATCH;
+    }
+    return StorageError::NONE;
+}
+
+StorageError decompressTextBlock(File &file, uint16_t blockSize, uint32_t textSize, uint32_t blockIndex, uint8_t *output, size_t &textLength)
+{
+    textLength = 0;
+    if (blockIndex >= countCompressedTextBlocks(blockSize, textSize))
+    {
+        return StorageError::SEEK_FAILED;
+    }
+
+    // The seek points of a block are its own offset and the one of the block after it
+    uint32_t blockOffsets[2];
+    if (!file.seek(sizeof(CompressedTextHeader) + blockIndex * sizeof(uint32_t)))
+    {
+        return StorageError::SEEK_FAILED;
+    }
+    if (file.read((uint8_t *)blockOffsets, sizeof(blockOffsets)) != sizeof(blockOffsets))
+    {
+        return StorageError::READ_FAILED;
+    }
+    if (blockOffsets[1] < blockOffsets[0])
+    {
+        return StorageError::BAD_FORMAT;
+    }
+    if (!file.seek(blockOffsets[0]))
+    {
+        return StorageError::SEEK_FAILED;
+    }
+
+    CompressedInput input;
+    input.file = &file;
+    input.remaining = blockOffsets[1] - blockOffsets[0];
+    size_t blockTextLength = min((uint32_t)blockSize, textSize - blockIndex * blockSize);
+    uint8_t flags = 0;
+    uint8_t flagsLeft = 0;
+    while (textLength < blockTextLength)
+    {
+        if (flagsLeft == 0)
+        {
+            if (!readCompressedByte(input, flags))
+            {
+                break;
+            }
+            flagsLeft = 8;
+        }
+        bool literal = flags & 1;
+        flags >>= 1;
+        flagsLeft--;
+
+        uint8_t first;
+        if (!readCompressedByte(input, first))
+        {
+            break;
+        }
+        if (literal)
+        {
+            output[textLength++] = first;
+            continue;
+        }
+        uint8_t second;
+        if (!readCompressedByte(input, second))
+        {
+            break;
+        }
+
+        // A match copies earlier text of the same block, one byte at a time so it can overlap what it writes
+        size_t distance = (first | ((second & 0xF0) << 4)) + 1;
+        size_t length = (second & 0x0F) + COMPRESSED_TEXT_MIN_MATCH;
+        if (distance > textLength || length > blockTextLength - textLength)
+        {
+            return StorageError::BAD_FORMAT;
+        }
+        for (size_t i = 0; i < length; i++, textLength++)
+        {
+            output[textLength] = output[textLength - distance];
+        }
+    }
+
+    if (input.readFailed)
+    {
+        return StorageError::READ_FAILED;
+    }
+    // A block has to end exactly where its text does, anything else means it is cut off or corrupt
+    if (textLength != blockTextLength || input.remaining > 0 || input.chunkPosition < input.chunkLength)
+    {
+        return StorageError::BAD_FORMAT;
+    }
+    return StorageError::NONE;
+}
+
+StorageError decompressText(File &file, uint8_t *destination, uint32_t textSize)
+{
+    CompressedTextHeader header;
+    if (!file.seek(0))
+    {
+        return StorageError::SEEK_FAILED;
+    }
+    StorageError error = readCompressedTextHeader(file, header);
+    if (error != StorageError::NONE)
+    {
+        return error;
+    }
+    if (header.textSize != textSize)
+    {
+        return StorageError::BAD_FORMAT;
+    }
+
+    for (uint32_t block = 0; block < countCompressedTextBlocks(header.blockSize, header.textSize); block++)
+    {
+        size_t textLength;
+        error = decompressTextBlock(file, header.blockSize, header.textSize, block, &destination[block * header.blockSize], textLength);
+        if (error != StorageError::NONE)
+        {
+            return error;
+        }
+    }
+    return StorageError::NONE;
+}
@@ -0,0 +1,186 @@
+#include "content_pack.h"
+
+// ===== Internal Helpers =====
+
+// CRC-32 (IEEE 802.3) a nibble at a time, small enough to not need a table in RAM
+static const uint32_t checksumNibbleTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+// Compute the checksum of a header, over everything before the checksum itself
+static uint32_t headerChecksum(const ContentPackHeader &header)
+{
+    return calculateChecksum((const uint8_t *)&header, offsetof(ContentPackHeader, headerChecksum));
+}
+
+// ===== Functions Implementations =====
+
+uint32_t calculateChecksum(const uint8_t *data, size_t length, uint32_t checksum)
+{
+    checksum = ~checksum;
+    for (size_t i = 0; i < length; i++)
+    {
+        checksum = checksumNibbleTable[(checksum ^ data[i]) & 0x0F] ^ (checksum >> 4);
+        checksum = checksumNibbleTable[(checksum ^ (data[i] >> 4)) & 0x0F] ^ (checksum >> 4);
+    }
+    return ~checksum;
+}
+
+uint32_t checkpointTableSize(const TopicLayout &layout)
+{
+    return 2 * sizeof(uint32_t) + layout.checkpoints.size() * sizeof(LayoutCheckpoint);
+}
+
+void packCheckpointTable(const TopicLayout &layout, uint8_t *destination)
+{
+    uint32_t checkpointAmount = layout.checkpoints.size();
+    memcpy(destination, &layout.checkpointInterval, sizeof(uint32_t));
+    memcpy(&destination[sizeof(uint32_t)], &checkpointAmount, sizeof(uint32_t));
+    if (checkpointAmount > 0)
+    {
+        memcpy(&destination[2 * sizeof(uint32_t)], layout.checkpoints.data(), checkpointAmount * sizeof(LayoutCheckpoint));
+    }
+}
+
+bool unpackCheckpointTable(const uint8_t *table, uint32_t tableSize, uint32_t offset, uint32_t lineAmount, uint8_t lineWidth, TopicLayout &layout)
+{
+    uint32_t checkpointInterval;
+    uint32_t checkpointAmount;
+    if (offset > tableSize || tableSize - offset < 2 * sizeof(uint32_t))
+    {
+        return false;
+    }
+    memcpy(&checkpointInterval, &table[offset], sizeof(uint32_t));
+    memcpy(&checkpointAmount, &table[offset + sizeof(uint32_t)], sizeof(uint32_t));
+    if (checkpointAmount > LAYOUT_CHECKPOINT_MAX_AMOUNT || checkpointAmount * sizeof(LayoutCheckpoint) > tableSize - offset - 2 * sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    layout.checkpoints.resize(checkpointAmount);
+    if (checkpointAmount > 0)
+    {
+        memcpy(layout.checkpoints.data(), &table[offset + 2 * sizeof(uint32_t)], checkpointAmount * sizeof(LayoutCheckpoint));
+    }
+    for (uint32_t i = 0; i < checkpointAmount; i++)
+    {
+        // Finding the checkpoint before a line relies on them being in order
+        if (layout.checkpoints[i].line >= lineAmount || (i > 0 && layout.checkpoints[i].line <= layout.checkpoints[i - 1].line))
+        {
+            layout.checkpoints.clear();
+            return false;
+        }
+    }
+    layout.checkpointInterval = checkpointInterval;
+    layout.lineAmount = lineAmount;
+    layout.lineWidth = lineWidth;
+    return true;
+}
+
+StorageError loadContentPack(fs::FS &fs, const char *path, TopicCatalog &catalog)
+{
+    clearTopicCatalog(catalog);
+
+    File packFile = openStorageFile(fs, path);
+    if (!packFile || packFile.isDirectory())
+    {
+        return StorageError::OPEN_FAILED;
+    }
+
+    // Check the header before trusting any size in it
+    ContentPackHeader header;
+    if (packFile.read((uint8_t *)&header, sizeof(header)) != sizeof(header))
+    {
+        return StorageError::READ_FAILED;
+    }
+    if (memcmp(header.magic, CONTENT_PACK_MAGIC, sizeof(header.magic)) != 0 || header.version != CONTENT_PACK_VERSION ||
+        header.tableSize > CONTENT_PACK_MAX_TABLE_SIZE || header.topicAmount * sizeof(ContentPackTopic) > header.tableSize)
+    {
+        return StorageError::BAD_FORMAT;
+    }
+    if (headerChecksum(header) != header.headerChecksum)
+    {
+        return StorageError::CHECKSUM_MISMATCH;
+    }
+
+    // The whole table area comes in with one read
+    uint8_t *table = allocateReadBuffer(header.tableSize);
+    if (!table)
+    {
+        return StorageError::READ_FAILED;
+    }
+    if (packFile.read(table, header.tableSize) != header.tableSize)
+    {
+        free(table);
+        return StorageError::READ_FAILED;
+    }
+    if (calculateChecksum(table, header.tableSize) != header.tableChecksum)
+    {
+        free(table);
+        return StorageError::CHECKSUM_MISMATCH;
+    }
+
+    uint32_t packSize = packFile.size();
+    StorageError error = StorageError::NONE;
+    catalog.entries.reserve(header.topicAmount);
+    catalog.layouts.reserve(header.topicAmount);
+    for (uint16_t i = 0; i < header.topicAmount; i++)
+    {
+        ContentPackTopic entry;
+        memcpy(&entry, &table[i * sizeof(ContentPackTopic)], sizeof(entry));
+
+        // A matching checksum only proves the table was written like this, the offsets still have to make sense
+        if (entry.nameOffset >= header.tableSize || memchr(&table[entry.nameOffset], '\0', header.tableSize - entry.nameOffset) == nullptr ||
+            entry.textOffset > packSize || entry.textSize > packSize - entry.textOffset)
+        {
+            error = StorageError::BAD_FORMAT;
+            break;
+        }
+
+        const char *name = (const char *)&table[entry.nameOffset];
+        addTopic(catalog, name, strlen(name), entry.textOffset, entry.textSize, entry.textChecksum);
+        catalog.entries.back().textVerified = false;
+        if (!unpackCheckpointTable(table, header.tableSize, entry.checkpointTableOffset, entry.lineAmount, header.lineWidth, catalog.layouts.back()))
+        {
+            error = StorageError::BAD_FORMAT;
+            break;
+        }
+    }
+    free(table);
+
+    if (error != StorageError::NONE)
+    {
+        // Leave nothing half loaded behind, so the caller can fall back to the text files
+        clearTopicCatalog(catalog);
+        return error;
+    }
+    catalog.packFileName = packFile.name();
+    sortTopicCatalog(catalog);
+    return StorageError::NONE;
+}
+
+StorageError verifyContentPackText(StreamReader &reader, uint32_t textChecksum)
+{
+    StorageError error = seekStreamReader(reader, 0);
+    if (error != StorageError::NONE)
+    {
+        return error;
+    }
+
+    uint32_t checksum = 0;
+    const uint8_t *data;
+    size_t length;
+    while ((error = readStreamChunk(reader, data, length)) == StorageError::NONE)
+    {
+        checksum = calculateChecksum(data, length, checksum);
+    }
+    if (error != StorageError::END_OF_FILE)
+    {
+        return error;
+    }
+    if (checksum != textChecksum)
+    {
+        return StorageError::CHECKSUM_MISMATCH;
+    }
+    return seekStreamReader(reader, 0);
+}
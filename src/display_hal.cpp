@@ -1,4 +1,14 @@
 #include "display_hal.h"
+#include "frame_timing.h"
+#include "glyph_blitter.h"
+#include "indexed_canvas.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
 
 // ===== Touch Panel Configuration =====
 
@@ -10,6 +20,88 @@ TouchState currentTouchState = TouchState::RELEASED;
 ButtonPressed whichButtonPressed = ButtonPressed::NONE;
 
 unsigned long last_rise_time = 0;
+unsigned long last_repeat_time = 0;
+
+// ===== Touch Drag Tracking =====
+
+struct TouchDrag
+{
+    bool fingerDown;            // A finger is on the screen, anywhere
+    bool active;                // The finger went down on the content area, so its moves scroll instead of pressing buttons
+    bool moving;                // The finger moved far enough from where it went down to count as a drag instead of a tap
+    uint16_t startX;            // Location the finger went down at
+    uint16_t startY;
+    unsigned long startTime;    // Timestamp of that
+    uint16_t lastY;             // Location of the last move that was passed on
+    unsigned long lastMoveTime; // Timestamp of that move
+    float velocity;             // Smoothed pixels per millisecond the finger moves down at, negative when it moves up
+};
+
+TouchDrag touchDrag = {};
+
+// ===== Touch Trace =====
+
+bool tracedDragging = false; // Whether the last traced touch was dragging, a trace leaves out the reads that only repeat it
+
+#ifdef ARDUINO_ARCH_ESP32
+QueueHandle_t touchEventQueue = nullptr;
+TaskHandle_t touchTaskHandle = nullptr;
+#else
+TouchEvent lastSampledTouchEvent = {0, TouchState::RELEASED, 0, 0};
+#endif
+
+// ===== Dirty Region Tracking =====
+
+struct DirtyRect
+{
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+};
+
+DirtyRect dirtyRects[DIRTY_RECT_MAX_AMOUNT];
+uint8_t dirtyRectAmount = 0;
+uint8_t currentTextSize = 1;
+int16_t textClipTop = 0; // Rows text is drawn in, rows outside of them are left untouched
+int16_t textClipBottom = SCREEN_HEIGHT;
+
+// Scanline buffer in internal RAM, the changed regions are expanded to RGB565 here before going over the bus
+alignas(4) static uint16_t dirtyFlushBuffer[SCREEN_WIDTH * DIRTY_FLUSH_BUFFER_LINES];
+
+// ===== Flush Pipeline =====
+
+struct DisplayFlushJob
+{
+    uint8_t *framebuffer; // Finished frame to send, nothing draws in it until the job is done
+    DirtyRect dirtyRects[DIRTY_RECT_MAX_AMOUNT];
+    uint8_t dirtyRectAmount;
+    bool fullFlush;
+};
+
+// Framebuffer that is not in the canvas, holding the last flushed frame. Stays null when there is no memory for it,
+// every flush then sends the canvas itself and waits for the transfer
+uint8_t *spareFramebuffer = nullptr;
+
+#ifdef ARDUINO_ARCH_ESP32
+QueueHandle_t flushJobQueue = nullptr;
+SemaphoreHandle_t flushIdleSemaphore = nullptr;
+#endif
+
+// ===== Interface Chrome Cache =====
+
+struct InterfaceChrome
+{
+    uint16_t interfaceColor;
+    uint16_t buttonIconTextColor;
+    const char *centerButtonText; // Kept as the caller's pointer, the labels are string literals
+    uint8_t *pixels; // Every byte of the framebuffer outside the content area, in framebuffer order
+};
+
+InterfaceChrome interfaceChromes[INTERFACE_CHROME_CACHE_AMOUNT];
+uint8_t interfaceChromeAmount = 0;
+uint8_t nextInterfaceChromeSlot = 0;
+int8_t visibleInterfaceChrome = -1; // Cached variant the canvas still shows untouched, anything drawn outside the content area resets it
 
 // ===== Display Driver and Panel Configuration =====
 
@@ -25,11 +117,477 @@ Arduino_NV3041A *panel = new Arduino_NV3041A(
     GFX_NOT_DEFINED,
     DISPLAY_ROTATION,
     DISPLAY_IS_IPS);
-Arduino_GFX *gfx = new Arduino_Canvas(
+IndexedCanvas *gfx = new IndexedCanvas(
     SCREEN_WIDTH,
     SCREEN_HEIGHT,
     panel);
 
+// ===== Internal Helpers =====
+
+// Merge two regions into the region that covers both
+static DirtyRect uniteDirtyRects(const DirtyRect &first, const DirtyRect &second)
+{
+    int16_t left = min(first.x, second.x);
+    int16_t top = min(first.y, second.y);
+    int16_t right = max(first.x + first.w, second.x + second.w);
+    int16_t bottom = max(first.y + first.h, second.y + second.h);
+    return {left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+// Check if two regions overlap or lie close enough to each other to be sent as one
+static bool dirtyRectsAreClose(const DirtyRect &first, const DirtyRect &second)
+{
+    return first.x <= second.x + second.w + DIRTY_RECT_MERGE_DISTANCE &&
+           second.x <= first.x + first.w + DIRTY_RECT_MERGE_DISTANCE &&
+           first.y <= second.y + second.h + DIRTY_RECT_MERGE_DISTANCE &&
+           second.y <= first.y + first.h + DIRTY_RECT_MERGE_DISTANCE;
+}
+
+// Print text and mark the area it was drawn in, text sizes the blitter knows are written straight into the canvas.
+// Only the blitter keeps to the clip rows, larger text is drawn by the GFX library over the whole screen
+static void printAndMarkDirty(const char *text, uint16_t color)
+{
+    FRAME_TIMING_SCOPE(TimingStage::TEXT_DRAW);
+    int16_t startX = gfx->getCursorX();
+    int16_t startY = gfx->getCursorY();
+    if (canBlitText(currentTextSize))
+    {
+        // The blitter clips to the framebuffer it is given, so it gets only the rows text may be drawn in
+        int16_t cursorX = startX;
+        int16_t cursorY = startY - textClipTop;
+        blitText(&gfx->getFramebuffer()[textClipTop * FRAMEBUFFER_ROW_BYTES], SCREEN_WIDTH, textClipBottom - textClipTop, cursorX, cursorY, text, currentTextSize, gfx->colorIndex(color));
+        gfx->setCursor(cursorX, cursorY + textClipTop);
+    }
+    else
+    {
+        gfx->setTextColor(color);
+        gfx->print(text);
+    }
+    int16_t endX = gfx->getCursorX();
+    int16_t endY = gfx->getCursorY();
+
+    int16_t top = max(startY, textClipTop);
+    int16_t bottom = min((int16_t)(endY + 8 * currentTextSize), textClipBottom);
+    if (bottom <= top)
+    {
+        return;
+    }
+    if (endY == startY)
+    {
+        markDirtyRegion(startX, top, endX - startX, bottom - top);
+    }
+    else
+    {
+        // The text wrapped, so mark all lines it went over
+        markDirtyRegion(0, top, SCREEN_WIDTH, bottom - top);
+    }
+}
+
+// Copy the chrome between a framebuffer and its cached bytes. In memory the chrome is one run before the first content row,
+// one run from the end of every content row to the start of the next, and one run after the last content row.
+// A byte holding both a chrome and a content pixel counts as chrome, its content pixel is cleared along with the content
+static void copyInterfaceChrome(uint8_t *framebuffer, uint8_t *chromePixels, bool toFramebuffer)
+{
+    uint32_t frameOffset = 0;
+    uint32_t chromeOffset = 0;
+    for (int16_t row = 0; row <= INTERFACE_CONTENT_HEIGHT; row++)
+    {
+        uint32_t runEnd = row < INTERFACE_CONTENT_HEIGHT ? (INTERFACE_CONTENT_Y + row) * FRAMEBUFFER_ROW_BYTES + INTERFACE_CONTENT_FIRST_BYTE : FRAMEBUFFER_SIZE;
+        uint32_t runLength = runEnd - frameOffset;
+        if (toFramebuffer)
+        {
+            memcpy(&framebuffer[frameOffset], &chromePixels[chromeOffset], runLength);
+        }
+        else
+        {
+            memcpy(&chromePixels[chromeOffset], &framebuffer[frameOffset], runLength);
+        }
+        chromeOffset += runLength;
+        frameOffset = runEnd + INTERFACE_CONTENT_END_BYTE - INTERFACE_CONTENT_FIRST_BYTE;
+    }
+}
+
+// Clear only the content area, a row at a time since black is all zero bits
+static void clearInterfaceContent(uint8_t *framebuffer)
+{
+    for (int16_t row = INTERFACE_CONTENT_Y; row < INTERFACE_CONTENT_Y + INTERFACE_CONTENT_HEIGHT; row++)
+    {
+        fillIndexedPixels(&framebuffer[row * FRAMEBUFFER_ROW_BYTES], INTERFACE_CONTENT_X, INTERFACE_CONTENT_WIDTH, INDEXED_CANVAS_BLACK_INDEX);
+    }
+}
+
+// Find the cached chrome of an interface variant, -1 when it was not drawn before
+static int8_t findInterfaceChrome(uint16_t interfaceColor, uint16_t buttonIconTextColor, const char *centerButtonText)
+{
+    for (uint8_t i = 0; i < interfaceChromeAmount; i++)
+    {
+        const InterfaceChrome &chrome = interfaceChromes[i];
+        if (chrome.interfaceColor == interfaceColor && chrome.buttonIconTextColor == buttonIconTextColor && strcmp(chrome.centerButtonText, centerButtonText) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Keep a copy of the chrome that was just drawn in the canvas, replacing the oldest variant when the cache is full.
+// Returns -1 when there is no memory for it, the variant is then simply drawn every time
+static int8_t storeInterfaceChrome(uint16_t interfaceColor, uint16_t buttonIconTextColor, const char *centerButtonText)
+{
+    uint8_t slot = nextInterfaceChromeSlot;
+    InterfaceChrome &chrome = interfaceChromes[slot];
+    if (!chrome.pixels)
+    {
+        chrome.pixels = (uint8_t *)ps_malloc(INTERFACE_CHROME_BYTE_AMOUNT);
+        if (!chrome.pixels)
+        {
+            return -1;
+        }
+    }
+    chrome.interfaceColor = interfaceColor;
+    chrome.buttonIconTextColor = buttonIconTextColor;
+    chrome.centerButtonText = centerButtonText;
+    copyInterfaceChrome(gfx->getFramebuffer(), chrome.pixels, false);
+
+    interfaceChromeAmount = max(interfaceChromeAmount, (uint8_t)(slot + 1));
+    nextInterfaceChromeSlot = (slot + 1) % INTERFACE_CHROME_CACHE_AMOUNT;
+    return slot;
+}
+
+// Draw the chrome of an interface variant line by line, over a cleared screen
+static void drawInterfaceChrome(uint16_t interfaceColor, uint16_t buttonIconTextColor, const char *centerButtonText)
+{
+    clearDisplay();
+    // Draw the interface itself, in a for loop to be adaptive with thickness, the regions are already marked by the clear
+    for (uint8_t i = 0; i < INTERFACE_BORDER_WIDTH; i++)
+    {
+        // Draw the outline
+        gfx->drawRect(i, i, SCREEN_WIDTH - (2 * i), SCREEN_HEIGHT - (2 * i), interfaceColor);
+        // Draw the navigation outline on the right
+        gfx->drawLine(SCREEN_WIDTH - NAVIGATION_WIDTH + i, i, SCREEN_WIDTH - NAVIGATION_WIDTH + i, SCREEN_HEIGHT, interfaceColor);
+        // Draw the navigation divisions
+        gfx->drawLine(SCREEN_WIDTH - NAVIGATION_WIDTH + i, SCREEN_HEIGHT / 3 + i, SCREEN_WIDTH, SCREEN_HEIGHT / 3 + i, interfaceColor);
+        gfx->drawLine(SCREEN_WIDTH - NAVIGATION_WIDTH + i, SCREEN_HEIGHT / 3 * 2 + i, SCREEN_WIDTH, SCREEN_HEIGHT / 3 * 2 + i, interfaceColor);
+    }
+    // Print the text for the center button
+    setTextSize(2);                                                                                                                             // 2 -> 12x16 character size
+    gfx->setCursor(SCREEN_WIDTH - NAVIGATION_WIDTH + ((NAVIGATION_WIDTH - (int16_t)strlen(centerButtonText) * 12) / 2), SCREEN_HEIGHT / 2 - 8); // Compensating and centering text based on size
+    printAndMarkDirty(centerButtonText, buttonIconTextColor);
+    // Draw the navigation buttons
+    gfx->drawTriangle(SCREEN_WIDTH - NAVIGATION_WIDTH / 2, SCREEN_HEIGHT / 9, SCREEN_WIDTH - NAVIGATION_WIDTH / 3, SCREEN_HEIGHT / 9 * 2, SCREEN_WIDTH - NAVIGATION_WIDTH / 3 * 2, SCREEN_HEIGHT / 9 * 2, buttonIconTextColor);
+    gfx->drawTriangle(SCREEN_WIDTH - NAVIGATION_WIDTH / 2, SCREEN_HEIGHT / 9 * 8, SCREEN_WIDTH - NAVIGATION_WIDTH / 3, SCREEN_HEIGHT / 9 * 7, SCREEN_WIDTH - NAVIGATION_WIDTH / 3 * 2, SCREEN_HEIGHT / 9 * 7, buttonIconTextColor);
+}
+
+// Send one region of a framebuffer to the panel, a few lines at a time expanded to RGB565 in the internal RAM buffer
+static void flushDirtyRect(const uint8_t *framebuffer, const DirtyRect &rect)
+{
+    uint8_t linesPerTransfer = min(DIRTY_FLUSH_BUFFER_LINES, SCREEN_WIDTH * DIRTY_FLUSH_BUFFER_LINES / rect.w);
+
+    panel->writeAddrWindow(rect.x, rect.y, rect.w, rect.h);
+    for (int16_t row = 0; row < rect.h; row += linesPerTransfer)
+    {
+        uint8_t lineAmount = min((int16_t)linesPerTransfer, (int16_t)(rect.h - row));
+        for (uint8_t line = 0; line < lineAmount; line++)
+        {
+            gfx->expandPixels(&framebuffer[(rect.y + row + line) * FRAMEBUFFER_ROW_BYTES], rect.x, rect.w, &dirtyFlushBuffer[line * rect.w]);
+        }
+        bus->writePixels(dirtyFlushBuffer, lineAmount * rect.w);
+    }
+}
+
+// Send a finished frame to the panel, either completely or only its changed regions
+static void runFlushJob(const DisplayFlushJob &job)
+{
+    FRAME_TIMING_SCOPE(TimingStage::PANEL_TRANSFER);
+    panel->startWrite();
+    if (job.fullFlush)
+    {
+        flushDirtyRect(job.framebuffer, {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
+    }
+    else
+    {
+        for (uint8_t i = 0; i < job.dirtyRectAmount; i++)
+        {
+            flushDirtyRect(job.framebuffer, job.dirtyRects[i]);
+        }
+    }
+    panel->endWrite();
+}
+
+// Bring the buffer that is drawn in next up to date with the frame that was just finished, only the changed regions differ
+static void copyFlushedRegions(const DisplayFlushJob &job, uint8_t *destination)
+{
+    if (job.fullFlush)
+    {
+        memcpy(destination, job.framebuffer, FRAMEBUFFER_SIZE);
+        return;
+    }
+
+    for (uint8_t i = 0; i < job.dirtyRectAmount; i++)
+    {
+        const DirtyRect &rect = job.dirtyRects[i];
+        for (int16_t row = rect.y; row < rect.y + rect.h; row++)
+        {
+            copyIndexedPixels(&destination[row * FRAMEBUFFER_ROW_BYTES], &job.framebuffer[row * FRAMEBUFFER_ROW_BYTES], rect.x, rect.w);
+        }
+    }
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+// Runs on the other core and sends every frame it gets to the panel, signalling when the panel is up to date
+static void displayFlushTask(void *parameter)
+{
+    DisplayFlushJob job;
+    while (true)
+    {
+        if (xQueueReceive(flushJobQueue, &job, portMAX_DELAY) == pdTRUE)
+        {
+            runFlushJob(job);
+            xSemaphoreGive(flushIdleSemaphore);
+        }
+    }
+}
+#endif
+
+// Find the navigation button at a location on the screen, none when it is outside the navigation on the right
+static ButtonPressed buttonAtLocation(uint16_t x, uint16_t y)
+{
+    if (x <= SCREEN_WIDTH - NAVIGATION_WIDTH)
+    {
+        return ButtonPressed::NONE;
+    }
+    // Check if touch press is within top button
+    if (y < SCREEN_HEIGHT / 3)
+    {
+        return ButtonPressed::UP_BUTTON;
+    }
+    else if (y > SCREEN_HEIGHT / 3 * 2)
+    {
+        return ButtonPressed::DOWN_BUTTON;
+    }
+    return ButtonPressed::SELECT_BACK_BUTTON;
+}
+
+// Read the touch panel once into an event
+static void sampleTouchPanel(TouchEvent &event)
+{
+    TOUCHINFO samplesInfo;
+    event.timestamp = millis();
+    if (touchPanel.getSamples(&samplesInfo))
+    {
+        event.state = TouchState::PRESSED;
+        event.x = samplesInfo.x[0];
+        event.y = samplesInfo.y[0];
+    }
+    else
+    {
+        event.state = TouchState::RELEASED;
+        event.x = 0;
+        event.y = 0;
+    }
+}
+
+// Check if a touch sample differs from the last one passed on, the finger went down or up or moved while down
+static bool touchEventChanged(const TouchEvent &previous, const TouchEvent &current)
+{
+    return current.state != previous.state ||
+           (current.state == TouchState::PRESSED && (current.x != previous.x || current.y != previous.y));
+}
+
+// Start following a finger that went down on the content area
+static void startTouchDrag(const TouchEvent &event)
+{
+    touchDrag.active = true;
+    touchDrag.moving = false;
+    touchDrag.startX = event.x;
+    touchDrag.startY = event.y;
+    touchDrag.startTime = event.timestamp;
+    touchDrag.lastY = event.y;
+    touchDrag.lastMoveTime = event.timestamp;
+    touchDrag.velocity = 0;
+}
+
+// Follow a move of a dragging finger, adding how far it moved down to the action and keeping track of its speed
+static void moveTouchDrag(const TouchEvent &event, TouchAction &action)
+{
+    int16_t distance = event.y - touchDrag.lastY;
+    if (!touchDrag.moving)
+    {
+        // Small movements of a finger that is meant to stay put do not scroll yet
+        if (abs(distance) < TOUCH_DRAG_START_DISTANCE)
+        {
+            return;
+        }
+        touchDrag.moving = true;
+    }
+
+    // Recent moves weigh the most, so the speed follows the finger without jumping on a single uneven sample
+    unsigned long elapsed = max(event.timestamp - touchDrag.lastMoveTime, 1UL);
+    touchDrag.velocity = TOUCH_DRAG_VELOCITY_SMOOTHING * touchDrag.velocity + (1 - TOUCH_DRAG_VELOCITY_SMOOTHING) * distance / elapsed;
+    touchDrag.lastY = event.y;
+    touchDrag.lastMoveTime = event.timestamp;
+    action.dragDistance += distance;
+}
+
+// Let go of a dragging finger, which flings the content when it was still moving fast enough, or taps it when it never moved
+static void endTouchDrag(const TouchEvent &event, TouchAction &action)
+{
+    if (!touchDrag.moving && event.timestamp - touchDrag.startTime <= TOUCH_TAP_MAX_DURATION)
+    {
+        action.tapX = touchDrag.startX;
+        action.tapY = touchDrag.startY;
+    }
+    bool stillMoving = touchDrag.moving && event.timestamp - touchDrag.lastMoveTime <= TOUCH_FLING_MAX_PAUSE;
+    if (stillMoving && fabsf(touchDrag.velocity) >= TOUCH_FLING_MIN_VELOCITY)
+    {
+        action.flingVelocity = touchDrag.velocity;
+    }
+    touchDrag.active = false;
+}
+
+// How long to wait for a touch event, a held up or down button has to come back in time for its long press to repeat
+static uint32_t touchEventWaitTime()
+{
+    if (currentTouchState != TouchState::PRESSED ||
+        (whichButtonPressed != ButtonPressed::UP_BUTTON && whichButtonPressed != ButtonPressed::DOWN_BUTTON))
+    {
+        return UINT32_MAX;
+    }
+    unsigned long heldTime = millis() - last_rise_time;
+    if (heldTime <= TOUCH_PRESS_LONG_PRESS_DELAY)
+    {
+        return TOUCH_PRESS_LONG_PRESS_DELAY - heldTime + 1;
+    }
+    unsigned long sinceRepeat = millis() - last_repeat_time;
+    return sinceRepeat >= TOUCH_LONG_PRESS_REPEAT_INTERVAL ? 0 : TOUCH_LONG_PRESS_REPEAT_INTERVAL - sinceRepeat;
+}
+
+#ifdef TOUCH_TRACE_RECORD
+// Print a touch that did something as a timestamped trace line, a serial log of them can be replayed on the host
+static void recordTouchAction(const TouchAction &action)
+{
+    if (action.button == ButtonPressed::NONE && action.dragDistance == 0 && action.flingVelocity == 0 && action.dragging == tracedDragging &&
+        action.tapX < 0)
+    {
+        return;
+    }
+    tracedDragging = action.dragging;
+    Serial.printf(TOUCH_TRACE_PREFIX " %lu %u %d %.6f %u %d %d\r\n", millis(), (unsigned int)action.button, action.dragDistance,
+                  action.flingVelocity, (unsigned int)action.dragging, action.tapX, action.tapY);
+}
+#endif
+
+#ifdef ARDUINO_ARCH_ESP32
+// The controller pulls its interrupt pin low when it has a new report, the I2C read itself happens in the touch task
+static void IRAM_ATTR touchInterruptHandler()
+{
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(touchTaskHandle, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// Sleeps until the controller interrupts, then queues a timestamped event whenever the finger goes down, moves or goes up
+static void touchTask(void *parameter)
+{
+    TouchEvent reportedEvent = {0, TouchState::RELEASED, 0, 0};
+    TouchEvent event;
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, reportedEvent.state == TouchState::PRESSED ? pdMS_TO_TICKS(TOUCH_RELEASE_POLL_INTERVAL) : portMAX_DELAY);
+        sampleTouchPanel(event);
+        if (touchEventChanged(reportedEvent, event))
+        {
+            // A full queue drops the newest change, the state is sent again once there is room
+            if (xQueueSend(touchEventQueue, &event, 0) == pdTRUE)
+            {
+                reportedEvent = event;
+            }
+        }
+    }
+}
+
+// Create the touch event queue and the task that fills it from the controller's interrupt
+static bool initializeTouchEvents()
+{
+    touchEventQueue = xQueueCreate(TOUCH_EVENT_QUEUE_LENGTH, sizeof(TouchEvent));
+    if (!touchEventQueue ||
+        xTaskCreatePinnedToCore(touchTask, "touch", TOUCH_TASK_STACK_SIZE, nullptr, TOUCH_TASK_PRIORITY, &touchTaskHandle, TOUCH_TASK_CORE) != pdPASS)
+    {
+        return false;
+    }
+    pinMode(TOUCH_INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(TOUCH_INT_PIN), touchInterruptHandler, FALLING);
+    return true;
+}
+
+// Sleep until a touch event arrives or the wait time in milliseconds has passed
+static bool receiveTouchEvent(TouchEvent &event, uint32_t waitTime)
+{
+    return xQueueReceive(touchEventQueue, &event, waitTime == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(waitTime)) == pdTRUE;
+}
+#else
+// Without an interrupt the touch panel is simply sampled
+static bool initializeTouchEvents()
+{
+    return true;
+}
+
+// Sample the touch panel and report when the finger went down, moved or went up, waits one poll interval when nothing changed
+static bool receiveTouchEvent(TouchEvent &event, uint32_t waitTime)
+{
+    sampleTouchPanel(event);
+    if (touchEventChanged(lastSampledTouchEvent, event))
+    {
+        lastSampledTouchEvent = event;
+        return true;
+    }
+    delay(min(waitTime, (uint32_t)TOUCH_HOST_POLL_INTERVAL));
+    return false;
+}
+
+// Return what a recorded trace read at this moment instead of reading the panel, so the state machine sees the same touches
+// at the same virtual time on every replay
+static TouchAction replayTouchAction(uint32_t maximumWaitTime)
+{
+    TouchAction action = {ButtonPressed::NONE, 0, 0, tracedDragging, -1, -1};
+    HostTracedTouch touch;
+    if (hostNextTracedTouch(touch, maximumWaitTime))
+    {
+        action = {(ButtonPressed)touch.button, touch.dragDistance, touch.flingVelocity, touch.dragging, touch.tapX, touch.tapY};
+        tracedDragging = touch.dragging;
+    }
+    return action;
+}
+#endif
+
+// Get a second framebuffer and start the flush task, without it every flush simply waits for its transfer
+static void initializeFlushPipeline()
+{
+    spareFramebuffer = allocateIndexedFramebuffer(SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!spareFramebuffer)
+    {
+        return;
+    }
+    // Both buffers have to start out the same, after that only the changed regions are copied between them
+    memcpy(spareFramebuffer, gfx->getFramebuffer(), FRAMEBUFFER_SIZE);
+
+#ifdef ARDUINO_ARCH_ESP32
+    flushJobQueue = xQueueCreate(1, sizeof(DisplayFlushJob));
+    flushIdleSemaphore = xSemaphoreCreateBinary();
+    if (!flushJobQueue || !flushIdleSemaphore ||
+        xTaskCreatePinnedToCore(displayFlushTask, "display_flush", DISPLAY_FLUSH_TASK_STACK_SIZE, nullptr, DISPLAY_FLUSH_TASK_PRIORITY, nullptr, DISPLAY_FLUSH_TASK_CORE) != pdPASS)
+    {
+        free(spareFramebuffer);
+        spareFramebuffer = nullptr;
+        return;
+    }
+    xSemaphoreGive(flushIdleSemaphore);
+#endif
+}
+
 // ===== Functions Implementations =====
 
 void initializeDisplay(uint8_t initDisplayBrightness)
@@ -40,6 +598,7 @@ void initializeDisplay(uint8_t initDisplayBrightness)
         Serial.begin(9600);
         Serial.println("gfx->begin() failed!");
     }
+    initializeFlushPipeline();
     clearDisplay();
 
     // Setting up the LEDC and configuring the backlight pin
@@ -55,47 +614,62 @@ bool initializeTouchScreen()
     {
         return false;
     }
-    else
-    {
-        return true;
-    }
+    return initializeTouchEvents();
 }
 
-ButtonPressed readTouchScreen()
+TouchAction readTouchScreen(uint32_t maximumWaitTime)
 {
-    TOUCHINFO samplesInfo;
-    // Being pressed
-    if (touchPanel.getSamples(&samplesInfo))
+#ifndef ARDUINO_ARCH_ESP32
+    if (hostTouchTraceActive())
     {
-        // Check if the touch press is within the navigation on the right
-        if (samplesInfo.x[0] > SCREEN_WIDTH - NAVIGATION_WIDTH)
+        return replayTouchAction(maximumWaitTime);
+    }
+#endif
+    TouchAction action = {ButtonPressed::NONE, 0, 0, false, -1, -1};
+    TouchEvent event;
+    if (receiveTouchEvent(event, min(touchEventWaitTime(), maximumWaitTime)))
+    {
+        if (event.state == TouchState::PRESSED && !touchDrag.fingerDown)
         {
-            // Check if touch press is within top button
-            if (samplesInfo.y[0] < SCREEN_HEIGHT / 3)
+            // Presses within the navigation on the right are buttons, the content area to the left of it can be dragged
+            touchDrag.fingerDown = true;
+            ButtonPressed button = buttonAtLocation(event.x, event.y);
+            if (button != ButtonPressed::NONE)
             {
-                whichButtonPressed = ButtonPressed::UP_BUTTON;
+                whichButtonPressed = button;
                 currentTouchState = TouchState::PRESSED;
             }
-            else if (samplesInfo.y[0] > SCREEN_HEIGHT / 3 * 2)
+            else
             {
-                whichButtonPressed = ButtonPressed::DOWN_BUTTON;
-                currentTouchState = TouchState::PRESSED;
+                startTouchDrag(event);
             }
-            else
+        }
+        else if (event.state == TouchState::PRESSED)
+        {
+            // A finger that went down on a button keeps pressing it wherever it moves
+            if (touchDrag.active)
             {
-                whichButtonPressed = ButtonPressed::SELECT_BACK_BUTTON;
-                currentTouchState = TouchState::PRESSED;
+                moveTouchDrag(event, action);
             }
         }
-    }
-    // Not pressed
-    else
-    {
-        whichButtonPressed = ButtonPressed::NONE;
-        currentTouchState = TouchState::RELEASED;
+        else
+        {
+            if (touchDrag.active)
+            {
+                endTouchDrag(event, action);
+            }
+            touchDrag.fingerDown = false;
+            whichButtonPressed = ButtonPressed::NONE;
+            currentTouchState = TouchState::RELEASED;
+        }
     }
 
-    return determineTouchPress();
+    action.button = determineTouchPress();
+    action.dragging = touchDrag.active;
+#ifdef TOUCH_TRACE_RECORD
+    recordTouchAction(action);
+#endif
+    return action;
 }
 
 ButtonPressed determineTouchPress()
@@ -105,9 +679,11 @@ ButtonPressed determineTouchPress()
     // Detect a long press of the buttons
     if (previousTouchState == TouchState::PRESSED && currentTouchState == TouchState::PRESSED && millis() - last_rise_time > TOUCH_PRESS_LONG_PRESS_DELAY)
     {
-        // Only allow a long press for the up and down buttons
-        if (whichButtonPressed == ButtonPressed::UP_BUTTON || whichButtonPressed == ButtonPressed::DOWN_BUTTON)
+        // Only allow a long press for the up and down buttons, repeating at a fixed pace
+        if ((whichButtonPressed == ButtonPressed::UP_BUTTON || whichButtonPressed == ButtonPressed::DOWN_BUTTON) &&
+            millis() - last_repeat_time >= TOUCH_LONG_PRESS_REPEAT_INTERVAL)
         {
+            last_repeat_time = millis();
             buttonToReturn = whichButtonPressed;
         }
     }
@@ -115,6 +691,7 @@ ButtonPressed determineTouchPress()
     else if (previousTouchState == TouchState::RELEASED && currentTouchState == TouchState::PRESSED)
     {
         last_rise_time = millis();
+        last_repeat_time = last_rise_time;
         buttonToReturn = whichButtonPressed;
     }
 
@@ -125,6 +702,126 @@ ButtonPressed determineTouchPress()
 void clearDisplay()
 {
     gfx->fillScreen(BLACK);
+    markDirtyRegion(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+void clearDisplayRegion(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    fillDisplayRegion(x, y, w, h, BLACK);
+}
+
+void fillDisplayRegion(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    gfx->fillRect(x, y, w, h, color);
+    markDirtyRegion(x, y, w, h);
+}
+
+void scrollDisplayRegion(int16_t x, int16_t y, int16_t w, int16_t h, int16_t amount)
+{
+    if (abs(amount) >= h)
+    {
+        clearDisplayRegion(x, y, w, h);
+        return;
+    }
+
+    uint8_t *framebuffer = gfx->getFramebuffer();
+    if (x == 0 && w == SCREEN_WIDTH)
+    {
+        // Full width rows follow each other in memory, so they can be moved in one go
+        uint8_t *top = &framebuffer[y * FRAMEBUFFER_ROW_BYTES];
+        if (amount < 0)
+        {
+            memmove(top, top - amount * FRAMEBUFFER_ROW_BYTES, (h + amount) * FRAMEBUFFER_ROW_BYTES);
+        }
+        else
+        {
+            memmove(top + amount * FRAMEBUFFER_ROW_BYTES, top, (h - amount) * FRAMEBUFFER_ROW_BYTES);
+        }
+    }
+    else if (amount < 0)
+    {
+        // Moving up, so start at the top to not overwrite rows that still have to be moved
+        for (int16_t row = y; row < y + h + amount; row++)
+        {
+            copyIndexedPixels(&framebuffer[row * FRAMEBUFFER_ROW_BYTES], &framebuffer[(row - amount) * FRAMEBUFFER_ROW_BYTES], x, w);
+        }
+    }
+    else
+    {
+        for (int16_t row = y + h - 1; row >= y + amount; row--)
+        {
+            copyIndexedPixels(&framebuffer[row * FRAMEBUFFER_ROW_BYTES], &framebuffer[(row - amount) * FRAMEBUFFER_ROW_BYTES], x, w);
+        }
+    }
+
+    // Clear the rows that were uncovered by the move
+    if (amount < 0)
+    {
+        gfx->fillRect(x, y + h + amount, w, -amount, BLACK);
+    }
+    else
+    {
+        gfx->fillRect(x, y, w, amount, BLACK);
+    }
+    markDirtyRegion(x, y, w, h);
+}
+
+void markDirtyRegion(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    // Anything changing outside the content area may have drawn over the chrome
+    if (x < INTERFACE_CONTENT_X || y < INTERFACE_CONTENT_Y ||
+        x + w > INTERFACE_CONTENT_X + INTERFACE_CONTENT_WIDTH || y + h > INTERFACE_CONTENT_Y + INTERFACE_CONTENT_HEIGHT)
+    {
+        visibleInterfaceChrome = -1;
+    }
+
+    // Clip the region to the screen, and round the columns to even values since the panel prefers even windows
+    int16_t left = max((int16_t)0, x) & ~1;
+    int16_t top = max((int16_t)0, y);
+    int16_t right = min((int16_t)SCREEN_WIDTH, (int16_t)((x + w + 1) & ~1));
+    int16_t bottom = min((int16_t)SCREEN_HEIGHT, (int16_t)(y + h));
+    if (right <= left || bottom <= top)
+    {
+        return;
+    }
+    DirtyRect newRect = {left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+
+    // Keep merging with the tracked regions it touches, a merged region can in turn touch others
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (uint8_t i = 0; i < dirtyRectAmount; i++)
+        {
+            if (dirtyRectsAreClose(newRect, dirtyRects[i]))
+            {
+                newRect = uniteDirtyRects(newRect, dirtyRects[i]);
+                dirtyRects[i] = dirtyRects[--dirtyRectAmount];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    // When out of slots, merge with the region that grows the least from it
+    if (dirtyRectAmount == DIRTY_RECT_MAX_AMOUNT)
+    {
+        uint8_t bestIndex = 0;
+        int32_t bestGrowth = INT32_MAX;
+        for (uint8_t i = 0; i < dirtyRectAmount; i++)
+        {
+            DirtyRect united = uniteDirtyRects(newRect, dirtyRects[i]);
+            int32_t growth = (int32_t)united.w * united.h - (int32_t)dirtyRects[i].w * dirtyRects[i].h;
+            if (growth < bestGrowth)
+            {
+                bestGrowth = growth;
+                bestIndex = i;
+            }
+        }
+        newRect = uniteDirtyRects(newRect, dirtyRects[bestIndex]);
+        dirtyRects[bestIndex] = dirtyRects[--dirtyRectAmount];
+    }
+    dirtyRects[dirtyRectAmount++] = newRect;
 }
 
 void setBrightness(uint8_t value)
@@ -140,60 +837,137 @@ void setCursorLocation(uint16_t x, uint16_t y)
 
 void setTextSize(uint8_t size)
 {
+    currentTextSize = size;
     gfx->setTextSize(size);
 }
 
-void displayStatusMessage(String message, String state, uint16_t stateColor)
+void setTextClipRows(int16_t y, int16_t h)
+{
+    textClipTop = max(y, (int16_t)0);
+    textClipBottom = min((int16_t)(y + h), (int16_t)SCREEN_HEIGHT);
+}
+
+void displayDrawQrCode(int16_t x, int16_t y, const QrCode &code, uint8_t scale)
+{
+    FRAME_TIMING_SCOPE(TimingStage::QR_DRAW);
+    int16_t size = qrCodePixelSize(code, scale);
+    blitQrCode(&gfx->getFramebuffer()[textClipTop * FRAMEBUFFER_ROW_BYTES], SCREEN_WIDTH, textClipBottom - textClipTop, x, y - textClipTop, code, scale,
+               gfx->colorIndex(QR_CODE_DARK_COLOR), gfx->colorIndex(QR_CODE_LIGHT_COLOR));
+
+    int16_t left = max(x, (int16_t)0);
+    int16_t right = min((int16_t)(x + size), (int16_t)SCREEN_WIDTH);
+    int16_t top = max(y, textClipTop);
+    int16_t bottom = min((int16_t)(y + size), textClipBottom);
+    if (right > left && bottom > top)
+    {
+        markDirtyRegion(left, top, right - left, bottom - top);
+    }
+}
+
+void displayStatusMessage(const char *message, const char *state, uint16_t stateColor)
 {
     displayPrint(message, WHITE);
     displayPrintln(state, stateColor);
 }
 
-void displayPrint(String text, uint16_t color)
+void displayPrint(const char *text, uint16_t color)
 {
-    gfx->setTextColor(color);
-    gfx->print(text);
-    gfx->flush();
+    printAndMarkDirty(text, color);
+    flushToDisplay();
 }
 
-void displayPrintln(String text, uint16_t color)
+void displayPrintln(const char *text, uint16_t color)
 {
-    gfx->setTextColor(color);
-    gfx->println(text);
-    gfx->flush();
+    printAndMarkDirty(text, color);
+    gfx->println();
+    flushToDisplay();
 }
 
-void displayPrintWithoutFlush(String text, uint16_t color)
+void displayPrintWithoutFlush(const char *text, uint16_t color)
 {
-    gfx->setTextColor(color);
-    gfx->print(text);
+    printAndMarkDirty(text, color);
 }
 
 void flushToDisplay()
 {
-    gfx->flush();
+    if (dirtyRectAmount == 0)
+    {
+        return;
+    }
+    FRAME_TIMING_SCOPE(TimingStage::FLUSH_SUBMIT);
+
+    DisplayFlushJob job;
+    memcpy(job.dirtyRects, dirtyRects, dirtyRectAmount * sizeof(DirtyRect));
+    job.dirtyRectAmount = dirtyRectAmount;
+    dirtyRectAmount = 0;
+
+    // When most of the screen changed a single full transfer is cheaper than many windows
+    uint32_t dirtyArea = 0;
+    for (uint8_t i = 0; i < job.dirtyRectAmount; i++)
+    {
+        dirtyArea += (uint32_t)job.dirtyRects[i].w * job.dirtyRects[i].h;
+    }
+    job.fullFlush = dirtyArea * 100 >= (uint32_t)SCREEN_WIDTH * SCREEN_HEIGHT * DIRTY_RECT_FULL_FLUSH_PERCENTAGE;
+
+    if (!spareFramebuffer)
+    {
+        job.framebuffer = gfx->getFramebuffer();
+        runFlushJob(job);
+        return;
+    }
+
+    // The spare buffer holds the previous frame, it is only free to draw in again once that frame is on the panel
+#ifdef ARDUINO_ARCH_ESP32
+    xSemaphoreTake(flushIdleSemaphore, portMAX_DELAY);
+#endif
+    job.framebuffer = gfx->swapFramebuffer(spareFramebuffer);
+    spareFramebuffer = job.framebuffer;
+
+#ifdef ARDUINO_ARCH_ESP32
+    xQueueSend(flushJobQueue, &job, portMAX_DELAY);
+#else
+    runFlushJob(job);
+#endif
+
+    // While the frame is being sent, catch the new canvas buffer up with it, both only read from the finished frame
+    copyFlushedRegions(job, gfx->getFramebuffer());
 }
 
-void displayDrawInterface(uint16_t interfaceColor, uint16_t buttonIconTextColor, String centerButtonText)
+void waitForDisplayFlush()
 {
-    clearDisplay();
-    // Draw the interface itself, in a for loop to be adaptive with thickness
-    for (uint8_t i = 0; i < INTERFACE_BORDER_WIDTH; i++)
+#ifdef ARDUINO_ARCH_ESP32
+    if (flushIdleSemaphore)
     {
-        // Draw the outline
-        gfx->drawRect(i, i, SCREEN_WIDTH - (2 * i), SCREEN_HEIGHT - (2 * i), interfaceColor);
-        // Draw the navigation outline on the right
-        gfx->drawLine(SCREEN_WIDTH - NAVIGATION_WIDTH + i, i, SCREEN_WIDTH - NAVIGATION_WIDTH + i, SCREEN_HEIGHT, interfaceColor);
-        // Draw the navigation divisions
-        gfx->drawLine(SCREEN_WIDTH - NAVIGATION_WIDTH + i, SCREEN_HEIGHT / 3 + i, SCREEN_WIDTH, SCREEN_HEIGHT / 3 + i, interfaceColor);
-        gfx->drawLine(SCREEN_WIDTH - NAVIGATION_WIDTH + i, SCREEN_HEIGHT / 3 * 2 + i, SCREEN_WIDTH, SCREEN_HEIGHT / 3 * 2 + i, interfaceColor);
+        xSemaphoreTake(flushIdleSemaphore, portMAX_DELAY);
+        xSemaphoreGive(flushIdleSemaphore);
     }
-    // Print the text for the center button
-    gfx->setTextColor(buttonIconTextColor);
-    gfx->setTextSize(2);                                                                                                                // 2 -> 12x16 character size
-    gfx->setCursor(SCREEN_WIDTH - NAVIGATION_WIDTH + ((NAVIGATION_WIDTH - centerButtonText.length() * 12) / 2), SCREEN_HEIGHT / 2 - 8); // Compensating and centering text based on size
-    gfx->print(centerButtonText);
-    // Draw the navigation buttons
-    gfx->drawTriangle(SCREEN_WIDTH - NAVIGATION_WIDTH / 2, SCREEN_HEIGHT / 9, SCREEN_WIDTH - NAVIGATION_WIDTH / 3, SCREEN_HEIGHT / 9 * 2, SCREEN_WIDTH - NAVIGATION_WIDTH / 3 * 2, SCREEN_HEIGHT / 9 * 2, buttonIconTextColor);
-    gfx->drawTriangle(SCREEN_WIDTH - NAVIGATION_WIDTH / 2, SCREEN_HEIGHT / 9 * 8, SCREEN_WIDTH - NAVIGATION_WIDTH / 3, SCREEN_HEIGHT / 9 * 7, SCREEN_WIDTH - NAVIGATION_WIDTH / 3 * 2, SCREEN_HEIGHT / 9 * 7, buttonIconTextColor);
+#endif
+}
+
+void displayDrawInterface(uint16_t interfaceColor, uint16_t buttonIconTextColor, const char *centerButtonText)
+{
+    FRAME_TIMING_SCOPE(TimingStage::INTERFACE_DRAW);
+    int8_t chromeIndex = findInterfaceChrome(interfaceColor, buttonIconTextColor, centerButtonText);
+    if (chromeIndex < 0)
+    {
+        // First time this variant is shown, draw it and keep it for next time
+        drawInterfaceChrome(interfaceColor, buttonIconTextColor, centerButtonText);
+        visibleInterfaceChrome = storeInterfaceChrome(interfaceColor, buttonIconTextColor, centerButtonText);
+        return;
+    }
+
+    uint8_t *framebuffer = gfx->getFramebuffer();
+    clearInterfaceContent(framebuffer);
+    if (chromeIndex == visibleInterfaceChrome)
+    {
+        // The chrome on screen is already right, so only the content area changes
+        markDirtyRegion(INTERFACE_CONTENT_X, INTERFACE_CONTENT_Y, INTERFACE_CONTENT_WIDTH, INTERFACE_CONTENT_HEIGHT);
+    }
+    else
+    {
+        copyInterfaceChrome(framebuffer, interfaceChromes[chromeIndex].pixels, true);
+        markDirtyRegion(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+    setTextSize(2); // Left the same as after drawing the chrome
+    visibleInterfaceChrome = chromeIndex;
 }
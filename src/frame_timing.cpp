@@ -0,0 +1,237 @@
+#include "frame_timing.h"
+
+#ifdef FRAME_TIMING_ENABLED
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#endif
+
+// ===== Struct Definitions =====
+
+struct TimingSample
+{
+    uint32_t start;
+    uint32_t duration;
+    TimingStage stage;
+};
+
+struct TimingHistogram
+{
+    uint32_t count;
+    uint32_t minimum;
+    uint32_t maximum;
+    uint64_t total;
+    uint32_t buckets[FRAME_TIMING_BUCKET_AMOUNT];
+};
+
+// ===== Timing Storage =====
+
+static const char *timingStageNames[(uint8_t)TimingStage::AMOUNT] = {
+    "screen update", "partial update", "topic select", "topic verify", "topic layout",
+    "topic load", "line read", "text draw", "qr encode", "qr draw",
+    "interface draw", "flush submit", "panel transfer"};
+
+TimingHistogram timingHistograms[(uint8_t)TimingStage::AMOUNT];
+TimingSample timingRing[FRAME_TIMING_RING_LENGTH];
+uint32_t timingRingCount = 0; // Samples ever written to the ring, the oldest ones are overwritten
+
+#ifdef ARDUINO_ARCH_ESP32
+// The flush task records from the other core, so every access goes through this lock
+portMUX_TYPE frameTimingLock = portMUX_INITIALIZER_UNLOCKED;
+#define FRAME_TIMING_LOCK() portENTER_CRITICAL(&frameTimingLock)
+#define FRAME_TIMING_UNLOCK() portEXIT_CRITICAL(&frameTimingLock)
+#else
+#define FRAME_TIMING_LOCK()
+#define FRAME_TIMING_UNLOCK()
+#endif
+
+// ===== Internal Helpers =====
+
+// Bucket of a duration, the first four hold 0 to 3 us and after that every power of two is split into four
+static uint8_t timingBucket(uint32_t duration)
+{
+    if (duration < 4)
+    {
+        return duration;
+    }
+    uint8_t highestBit = 31 - __builtin_clz(duration);
+    uint8_t bucket = (highestBit - 1) * 4 + ((duration >> (highestBit - 2)) & 3);
+    return min(bucket, (uint8_t)(FRAME_TIMING_BUCKET_AMOUNT - 1));
+}
+
+// Largest duration that still falls in a bucket
+static uint32_t timingBucketLimit(uint8_t bucket)
+{
+    if (bucket < 4)
+    {
+        return bucket;
+    }
+    uint8_t highestBit = bucket / 4 + 1;
+    uint32_t step = 1UL << (highestBit - 2);
+    return (4 + bucket % 4) * step + step - 1;
+}
+
+// Duration that at least 99% of the samples of a histogram stay at or below, rounded up to the end of its bucket
+static uint32_t timingPercentile99(const TimingHistogram &histogram)
+{
+    uint32_t needed = histogram.count - histogram.count / 100;
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < FRAME_TIMING_BUCKET_AMOUNT; bucket++)
+    {
+        seen += histogram.buckets[bucket];
+        if (seen >= needed)
+        {
+            return min(timingBucketLimit(bucket), histogram.maximum);
+        }
+    }
+    return histogram.maximum;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+// Read serial input into a line, and run it as a command once it is complete
+static void handleFrameTimingConsole()
+{
+    static char command[32];
+    static uint8_t commandLength = 0;
+    while (Serial.available() > 0)
+    {
+        char character = Serial.read();
+        if (character != '\n' && character != '\r')
+        {
+            if (commandLength < sizeof(command) - 1)
+            {
+                command[commandLength++] = character;
+            }
+            continue;
+        }
+        command[commandLength] = '\0';
+        if (strcmp(command, "timing") == 0)
+        {
+            printFrameTimingReport();
+        }
+        else if (strcmp(command, "timing reset") == 0)
+        {
+            resetFrameTiming();
+            Serial.println("Frame timing reset");
+        }
+        else if (commandLength > 0)
+        {
+            Serial.println("Commands: timing, timing reset");
+        }
+        commandLength = 0;
+    }
+}
+
+// Polls the serial console, the main loop itself is asleep waiting for touch events most of the time
+static void frameTimingConsoleTask(void *parameter)
+{
+    while (true)
+    {
+        handleFrameTimingConsole();
+        vTaskDelay(pdMS_TO_TICKS(FRAME_TIMING_CONSOLE_POLL_INTERVAL));
+    }
+}
+#endif
+
+// ===== Functions Implementations =====
+
+FrameTimingScope::FrameTimingScope(TimingStage stage) : stage(stage), start(readTimingClock())
+{
+}
+
+FrameTimingScope::~FrameTimingScope()
+{
+    recordTiming(stage, readTimingClock() - start);
+}
+
+void initializeFrameTiming()
+{
+    resetFrameTiming();
+#ifdef ARDUINO_ARCH_ESP32
+    xTaskCreatePinnedToCore(frameTimingConsoleTask, "frame_timing", FRAME_TIMING_CONSOLE_TASK_STACK_SIZE, nullptr, FRAME_TIMING_CONSOLE_TASK_PRIORITY, nullptr, FRAME_TIMING_CONSOLE_TASK_CORE);
+#else
+    atexit(printFrameTimingReport);
+#endif
+}
+
+uint32_t readTimingClock()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    return (uint32_t)esp_timer_get_time();
+#else
+    // millis() and micros() only follow the virtual clock on the host, the real time is what is measured here
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void recordTiming(TimingStage stage, uint32_t duration)
+{
+    FRAME_TIMING_LOCK();
+    TimingHistogram &histogram = timingHistograms[(uint8_t)stage];
+    histogram.minimum = histogram.count == 0 ? duration : min(histogram.minimum, duration);
+    histogram.maximum = max(histogram.maximum, duration);
+    histogram.total += duration;
+    histogram.count++;
+    histogram.buckets[timingBucket(duration)]++;
+
+    TimingSample &sample = timingRing[timingRingCount % FRAME_TIMING_RING_LENGTH];
+    sample.start = readTimingClock() - duration;
+    sample.duration = duration;
+    sample.stage = stage;
+    timingRingCount++;
+    FRAME_TIMING_UNLOCK();
+}
+
+void printFrameTimingReport()
+{
+    // Copy everything first, printing is slow and should not hold up the flush task
+    static TimingHistogram histograms[(uint8_t)TimingStage::AMOUNT];
+    static TimingSample ring[FRAME_TIMING_RING_LENGTH];
+    FRAME_TIMING_LOCK();
+    memcpy(histograms, timingHistograms, sizeof(histograms));
+    memcpy(ring, timingRing, sizeof(ring));
+    uint32_t ringCount = timingRingCount;
+    FRAME_TIMING_UNLOCK();
+
+    Serial.printf("%-16s %8s %10s %10s %10s %10s\r\n", "stage", "count", "min us", "avg us", "p99 us", "max us");
+    for (uint8_t i = 0; i < (uint8_t)TimingStage::AMOUNT; i++)
+    {
+        const TimingHistogram &histogram = histograms[i];
+        if (histogram.count == 0)
+        {
+            Serial.printf("%-16s %8u %10s %10s %10s %10s\r\n", timingStageNames[i], 0U, "-", "-", "-", "-");
+            continue;
+        }
+        Serial.printf("%-16s %8u %10u %10u %10u %10u\r\n", timingStageNames[i], (unsigned int)histogram.count, (unsigned int)histogram.minimum,
+                      (unsigned int)(histogram.total / histogram.count), (unsigned int)timingPercentile99(histogram), (unsigned int)histogram.maximum);
+    }
+
+    // The latest samples in the order they ended, with their start relative to the start of the first one
+    uint32_t sampleAmount = min(ringCount, (uint32_t)FRAME_TIMING_RING_LENGTH);
+    if (sampleAmount == 0)
+    {
+        return;
+    }
+    Serial.printf("Latest %u samples:\r\n", (unsigned int)sampleAmount);
+    uint32_t first = ringCount - sampleAmount;
+    uint32_t firstStart = ring[first % FRAME_TIMING_RING_LENGTH].start;
+    for (uint32_t i = first; i < ringCount; i++)
+    {
+        const TimingSample &sample = ring[i % FRAME_TIMING_RING_LENGTH];
+        Serial.printf("  %+11d us %-16s %10u us\r\n", (int)(int32_t)(sample.start - firstStart), timingStageNames[(uint8_t)sample.stage], (unsigned int)sample.duration);
+    }
+}
+
+void resetFrameTiming()
+{
+    FRAME_TIMING_LOCK();
+    memset(timingHistograms, 0, sizeof(timingHistograms));
+    timingRingCount = 0;
+    FRAME_TIMING_UNLOCK();
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "glyph_blitter.h"
+#include "indexed_canvas.h"
+
+// ===== Font =====
+
+// Printable ASCII range of the classic 5x7 GFX font, column-major with the LSB at the top
+static const uint8_t glyphFont[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5F, 0x00, 0x00, 0x00, 0x07, 0x00, 0x07, 0x00, 0x14, 0x7F, 0x14, 0x7F, 0x14,
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, 0x23, 0x13, 0x08, 0x64, 0x62, 0x36, 0x49, 0x56, 0x20, 0x50, 0x00, 0x08, 0x07, 0x03, 0x00,
+    0x00, 0x1C, 0x22, 0x41, 0x00, 0x00, 0x41, 0x22, 0x1C, 0x00, 0x2A, 0x1C, 0x7F, 0x1C, 0x2A, 0x08, 0x08, 0x3E, 0x08, 0x08,
+    0x00, 0x80, 0x70, 0x30, 0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x60, 0x60, 0x00, 0x20, 0x10, 0x08, 0x04, 0x02,
+    0x3E, 0x51, 0x49, 0x45, 0x3E, 0x00, 0x42, 0x7F, 0x40, 0x00, 0x72, 0x49, 0x49, 0x49, 0x46, 0x21, 0x41, 0x49, 0x4D, 0x33,
+    0x18, 0x14, 0x12, 0x7F, 0x10, 0x27, 0x45, 0x45, 0x45, 0x39, 0x3C, 0x4A, 0x49, 0x49, 0x31, 0x41, 0x21, 0x11, 0x09, 0x07,
+    0x36, 0x49, 0x49, 0x49, 0x36, 0x46, 0x49, 0x49, 0x29, 0x1E, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x40, 0x34, 0x00, 0x00,
+    0x00, 0x08, 0x14, 0x22, 0x41, 0x14, 0x14, 0x14, 0x14, 0x14, 0x00, 0x41, 0x22, 0x14, 0x08, 0x02, 0x01, 0x59, 0x09, 0x06,
+    0x3E, 0x41, 0x5D, 0x59, 0x4E, 0x7C, 0x12, 0x11, 0x12, 0x7C, 0x7F, 0x49, 0x49, 0x49, 0x36, 0x3E, 0x41, 0x41, 0x41, 0x22,
+    0x7F, 0x41, 0x41, 0x41, 0x3E, 0x7F, 0x49, 0x49, 0x49, 0x41, 0x7F, 0x09, 0x09, 0x09, 0x01, 0x3E, 0x41, 0x41, 0x51, 0x73,
+    0x7F, 0x08, 0x08, 0x08, 0x7F, 0x00, 0x41, 0x7F, 0x41, 0x00, 0x20, 0x40, 0x41, 0x3F, 0x01, 0x7F, 0x08, 0x14, 0x22, 0x41,
+    0x7F, 0x40, 0x40, 0x40, 0x40, 0x7F, 0x02, 0x1C, 0x02, 0x7F, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x3E, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x09, 0x09, 0x09, 0x06, 0x3E, 0x41, 0x51, 0x21, 0x5E, 0x7F, 0x09, 0x19, 0x29, 0x46, 0x26, 0x49, 0x49, 0x49, 0x32,
+    0x03, 0x01, 0x7F, 0x01, 0x03, 0x3F, 0x40, 0x40, 0x40, 0x3F, 0x1F, 0x20, 0x40, 0x20, 0x1F, 0x3F, 0x40, 0x38, 0x40, 0x3F,
+    0x63, 0x14, 0x08, 0x14, 0x63, 0x03, 0x04, 0x78, 0x04, 0x03, 0x61, 0x59, 0x49, 0x4D, 0x43, 0x00, 0x7F, 0x41, 0x41, 0x41,
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x00, 0x41, 0x41, 0x41, 0x7F, 0x04, 0x02, 0x01, 0x02, 0x04, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x00, 0x03, 0x07, 0x08, 0x00, 0x20, 0x54, 0x54, 0x78, 0x40, 0x7F, 0x28, 0x44, 0x44, 0x38, 0x38, 0x44, 0x44, 0x44, 0x28,
+    0x38, 0x44, 0x44, 0x28, 0x7F, 0x38, 0x54, 0x54, 0x54, 0x18, 0x00, 0x08, 0x7E, 0x09, 0x02, 0x18, 0xA4, 0xA4, 0x9C, 0x78,
+    0x7F, 0x08, 0x04, 0x04, 0x78, 0x00, 0x44, 0x7D, 0x40, 0x00, 0x20, 0x40, 0x40, 0x3D, 0x00, 0x7F, 0x10, 0x28, 0x44, 0x00,
+    0x00, 0x41, 0x7F, 0x40, 0x00, 0x7C, 0x04, 0x78, 0x04, 0x78, 0x7C, 0x08, 0x04, 0x04, 0x78, 0x38, 0x44, 0x44, 0x44, 0x38,
+    0xFC, 0x18, 0x24, 0x24, 0x18, 0x18, 0x24, 0x24, 0x18, 0xFC, 0x7C, 0x08, 0x04, 0x04, 0x08, 0x48, 0x54, 0x54, 0x54, 0x24,
+    0x04, 0x04, 0x3F, 0x44, 0x24, 0x3C, 0x40, 0x40, 0x20, 0x7C, 0x1C, 0x20, 0x40, 0x20, 0x1C, 0x3C, 0x40, 0x30, 0x40, 0x3C,
+    0x44, 0x28, 0x10, 0x28, 0x44, 0x4C, 0x90, 0x90, 0x90, 0x7C, 0x44, 0x64, 0x54, 0x4C, 0x44, 0x00, 0x08, 0x36, 0x41, 0x00,
+    0x00, 0x00, 0x77, 0x00, 0x00, 0x00, 0x41, 0x36, 0x08, 0x00, 0x02, 0x01, 0x02, 0x04, 0x02};
+
+// ===== Glyph Tables =====
+
+// Every glyph row prepared per text size and per start phase, with two bits for each byte of framebuffer it touches:
+// 0 leaves the byte alone, 1 and 2 set its first or second pixel, 3 sets both pixels with one byte write.
+// The phase is the parity of the x where the glyph starts, an odd start shifts the glyph by a pixel within the bytes
+static uint16_t glyphRowCodes[GLYPH_BLITTER_MAX_TEXT_SIZE][2][GLYPH_AMOUNT][GLYPH_HEIGHT];
+static bool glyphTablesPrepared = false;
+
+// Palette index of the last text, kept together with its two pixel byte so the byte is only packed again when the index changes.
+// Both start out black, which packs to a zero byte
+static uint8_t cachedIndex = INDEXED_CANVAS_BLACK_INDEX;
+static uint8_t cachedIndexPair = 0;
+
+// ===== Internal Helpers =====
+
+// Get the font index of a character, characters the font does not have become '?'
+static uint8_t glyphIndex(char character)
+{
+    uint8_t code = character;
+    if (code < GLYPH_FIRST_CHARACTER || code > GLYPH_LAST_CHARACTER)
+    {
+        code = '?';
+    }
+    return code - GLYPH_FIRST_CHARACTER;
+}
+
+// Scale every glyph of the font once into the write codes for each text size and phase
+static void prepareGlyphTables()
+{
+    for (uint8_t size = 1; size <= GLYPH_BLITTER_MAX_TEXT_SIZE; size++)
+    {
+        for (uint8_t phase = 0; phase < 2; phase++)
+        {
+            for (uint8_t glyph = 0; glyph < GLYPH_AMOUNT; glyph++)
+            {
+                for (uint8_t row = 0; row < GLYPH_HEIGHT; row++)
+                {
+                    uint16_t codes = 0;
+                    for (uint8_t column = 0; column < GLYPH_COLUMNS * size; column++)
+                    {
+                        if (pgm_read_byte(&glyphFont[glyph * GLYPH_COLUMNS + column / size]) & (1 << row))
+                        {
+                            uint8_t pixel = column + phase;
+                            codes |= (1 << (pixel & 1)) << ((pixel / 2) * 2);
+                        }
+                    }
+                    glyphRowCodes[size - 1][phase][glyph][row] = codes;
+                }
+            }
+        }
+    }
+    glyphTablesPrepared = true;
+}
+
+// Draw one glyph that lies completely within the framebuffer, a glyph row at a time through its write codes.
+// The text size is a template parameter so text size 1 does not write every row twice
+template <uint8_t textSize>
+static void blitGlyph(uint8_t *framebuffer, int16_t width, int16_t x, int16_t y, uint8_t glyph)
+{
+    uint8_t phase = x & 1;
+    const uint16_t *rowCodes = glyphRowCodes[textSize - 1][phase][glyph];
+    int16_t rowStride = INDEXED_CANVAS_ROW_BYTES(width);
+    uint8_t *rowBytes = &framebuffer[y * rowStride + (x - phase) / 2];
+    for (uint8_t row = 0; row < GLYPH_HEIGHT; row++, rowBytes += rowStride * textSize)
+    {
+        uint16_t codes = rowCodes[row];
+        if (codes == 0)
+        {
+            continue;
+        }
+        // Larger text repeats every row of the glyph, the codes already hold the wider columns
+        uint8_t *repeatBytes = rowBytes + (textSize - 1) * rowStride;
+        for (uint8_t pair = 0; codes != 0; codes >>= 2, pair++)
+        {
+            switch (codes & 3)
+            {
+            case 1:
+                rowBytes[pair] = (rowBytes[pair] & 0xF0) | cachedIndex;
+                repeatBytes[pair] = (repeatBytes[pair] & 0xF0) | cachedIndex;
+                break;
+            case 2:
+                rowBytes[pair] = (rowBytes[pair] & 0x0F) | (cachedIndex << 4);
+                repeatBytes[pair] = (repeatBytes[pair] & 0x0F) | (cachedIndex << 4);
+                break;
+            case 3:
+                rowBytes[pair] = cachedIndexPair;
+                repeatBytes[pair] = cachedIndexPair;
+                break;
+            }
+        }
+    }
+}
+
+// Draw one glyph that is partly outside of the framebuffer, pixel by pixel
+static void blitClippedGlyph(uint8_t *framebuffer, int16_t width, int16_t height, int16_t x, int16_t y, uint8_t glyph, uint8_t textSize)
+{
+    for (uint8_t column = 0; column < GLYPH_COLUMNS * textSize; column++)
+    {
+        uint8_t line = pgm_read_byte(&glyphFont[glyph * GLYPH_COLUMNS + column / textSize]);
+        int16_t pixelX = x + column;
+        if (pixelX < 0 || pixelX >= width)
+        {
+            continue;
+        }
+        for (uint8_t row = 0; row < GLYPH_HEIGHT * textSize; row++)
+        {
+            int16_t pixelY = y + row;
+            if ((line & (1 << (row / textSize))) && pixelY >= 0 && pixelY < height)
+            {
+                setIndexedPixel(&framebuffer[pixelY * INDEXED_CANVAS_ROW_BYTES(width)], pixelX, cachedIndex);
+            }
+        }
+    }
+}
+
+// ===== Functions Implementations =====
+
+bool canBlitText(uint8_t textSize)
+{
+    return textSize >= 1 && textSize <= GLYPH_BLITTER_MAX_TEXT_SIZE;
+}
+
+void blitText(uint8_t *framebuffer, int16_t width, int16_t height, int16_t &cursorX, int16_t &cursorY, const char *text, uint8_t textSize, uint8_t colorIndex)
+{
+    if (!glyphTablesPrepared)
+    {
+        prepareGlyphTables();
+    }
+    if (colorIndex != cachedIndex)
+    {
+        cachedIndex = colorIndex;
+        cachedIndexPair = colorIndex | (colorIndex << 4);
+    }
+
+    int16_t cellWidth = GLYPH_WIDTH * textSize;
+    int16_t cellHeight = GLYPH_HEIGHT * textSize;
+    for (; *text; text++)
+    {
+        if (*text == '\n')
+        {
+            cursorX = 0;
+            cursorY += cellHeight;
+            continue;
+        }
+        if (*text == '\r')
+        {
+            continue;
+        }
+        if (cursorX + cellWidth > width)
+        {
+            cursorX = 0;
+            cursorY += cellHeight;
+        }
+
+        uint8_t glyph = glyphIndex(*text);
+        if (cursorX >= 0 && cursorY >= 0 && cursorY + cellHeight <= height)
+        {
+            if (textSize == 1)
+            {
+                blitGlyph<1>(framebuffer, width, cursorX, cursorY, glyph);
+            }
+            else
+            {
+                blitGlyph<2>(framebuffer, width, cursorX, cursorY, glyph);
+            }
+        }
+        else if (cursorY < height && cursorY + cellHeight > 0)
+        {
+            blitClippedGlyph(framebuffer, width, height, cursorX, cursorY, glyph, textSize);
+        }
+        cursorX += cellWidth;
+    }
+}
@@ -0,0 +1,205 @@
+#include "index_cache.h"
+
+// ===== Internal Helpers =====
+
+// Compute the checksum of a header, over everything before the checksum itself
+static uint32_t indexCacheHeaderChecksum(const IndexCacheHeader &header)
+{
+    return calculateChecksum((const uint8_t *)&header, offsetof(IndexCacheHeader, headerChecksum));
+}
+
+// ===== Functions Implementations =====
+
+StorageError loadIndexCache(fs::FS &fs, const char *path, uint8_t lineWidth, TopicCatalog &catalog, uint16_t &cachedAmount)
+{
+    cachedAmount = 0;
+
+    File cacheFile = openStorageFile(fs, path);
+    if (!cacheFile || cacheFile.isDirectory())
+    {
+        return StorageError::OPEN_FAILED;
+    }
+
+    // Check the header before trusting any size in it
+    IndexCacheHeader header;
+    if (cacheFile.read((uint8_t *)&header, sizeof(header)) != sizeof(header))
+    {
+        return StorageError::READ_FAILED;
+    }
+    if (memcmp(header.magic, INDEX_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != INDEX_CACHE_VERSION ||
+        header.tableSize > INDEX_CACHE_MAX_TABLE_SIZE || header.topicAmount * sizeof(IndexCacheTopic) > header.tableSize)
+    {
+        return StorageError::BAD_FORMAT;
+    }
+    if (indexCacheHeaderChecksum(header) != header.headerChecksum)
+    {
+        return StorageError::CHECKSUM_MISMATCH;
+    }
+    // Lines wrapped at another width are of no use, they all have to be wrapped again
+    if (header.lineWidth != lineWidth)
+    {
+        return StorageError::NONE;
+    }
+
+    // The whole table area comes in with one read
+    uint8_t *table = allocateReadBuffer(header.tableSize);
+    if (!table)
+    {
+        return StorageError::READ_FAILED;
+    }
+    if (cacheFile.read(table, header.tableSize) != header.tableSize)
+    {
+        free(table);
+        return StorageError::READ_FAILED;
+    }
+    if (calculateChecksum(table, header.tableSize) != header.tableChecksum)
+    {
+        free(table);
+        return StorageError::CHECKSUM_MISMATCH;
+    }
+
+    StorageError error = StorageError::NONE;
+    for (uint16_t i = 0; i < header.topicAmount; i++)
+    {
+        IndexCacheTopic entry;
+        memcpy(&entry, &table[i * sizeof(IndexCacheTopic)], sizeof(entry));
+
+        if (entry.nameOffset >= header.tableSize || memchr(&table[entry.nameOffset], '\0', header.tableSize - entry.nameOffset) == nullptr)
+        {
+            error = StorageError::BAD_FORMAT;
+            break;
+        }
+
+        // Only a file with the same size and modification time as when it was wrapped can use its cached layout
+        int32_t topicIndex = findTopic(catalog, (const char *)&table[entry.nameOffset]);
+        if (topicIndex < 0)
+        {
+            continue;
+        }
+        const TopicEntry &topic = catalog.entries[topicIndex];
+        if (topic.textSize != entry.fileSize || topic.lastWrite != entry.lastWrite)
+        {
+            continue;
+        }
+
+        if (!unpackCheckpointTable(table, header.tableSize, entry.checkpointTableOffset, entry.lineAmount, header.lineWidth, catalog.layouts[topicIndex]))
+        {
+            error = StorageError::BAD_FORMAT;
+            break;
+        }
+        cachedAmount++;
+    }
+    free(table);
+    return error;
+}
+
+StorageError indexTopics(fs::FS &fs, const char *directory, uint8_t lineWidth, uint8_t *buffer, size_t bufferSize, TopicCatalog &catalog, uint16_t &indexedAmount)
+{
+    indexedAmount = 0;
+    StorageError firstError = StorageError::NONE;
+    for (uint16_t i = 0; i < countTopics(catalog); i++)
+    {
+        TopicLayout &layout = catalog.layouts[i];
+        if (isTopicLaidOut(layout, lineWidth))
+        {
+            continue;
+        }
+
+        // A topic that fails here is simply tried again when it is opened, so the others still get wrapped
+        StreamReader reader;
+        StorageError error = openTopicStreamReader(fs, directory, catalog, i, buffer, bufferSize, reader);
+        if (error == StorageError::NONE)
+        {
+            error = layoutTopic(reader, lineWidth, layout);
+        }
+        closeStreamReader(reader);
+
+        if (error == StorageError::NONE)
+        {
+            indexedAmount++;
+        }
+        else if (firstError == StorageError::NONE)
+        {
+            firstError = error;
+        }
+    }
+    return firstError;
+}
+
+StorageError saveIndexCache(fs::FS &fs, const char *path, uint8_t lineWidth, const TopicCatalog &catalog)
+{
+    // Lay out the table area: the topic table first, then every checkpoint table, then every name
+    uint16_t topicAmount = 0;
+    uint32_t checkpointSize = 0;
+    uint32_t nameSize = 0;
+    for (uint16_t i = 0; i < countTopics(catalog); i++)
+    {
+        if (isTopicLaidOut(catalog.layouts[i], lineWidth))
+        {
+            topicAmount++;
+            checkpointSize += checkpointTableSize(catalog.layouts[i]);
+            nameSize += strlen(topicName(catalog, i)) + 1;
+        }
+    }
+    uint32_t tableSize = topicAmount * sizeof(IndexCacheTopic) + checkpointSize + nameSize;
+    if (tableSize > INDEX_CACHE_MAX_TABLE_SIZE)
+    {
+        return StorageError::BAD_FORMAT;
+    }
+
+    // The header and table area are built together, so the file is written with one write
+    uint8_t *cache = allocateReadBuffer(sizeof(IndexCacheHeader) + tableSize);
+    if (!cache)
+    {
+        return StorageError::WRITE_FAILED;
+    }
+    uint8_t *table = &cache[sizeof(IndexCacheHeader)];
+    uint32_t checkpointTableOffset = topicAmount * sizeof(IndexCacheTopic);
+    uint32_t nameOffset = checkpointTableOffset + checkpointSize;
+    uint16_t entryIndex = 0;
+    for (uint16_t i = 0; i < countTopics(catalog); i++)
+    {
+        const TopicLayout &layout = catalog.layouts[i];
+        if (!isTopicLaidOut(layout, lineWidth))
+        {
+            continue;
+        }
+
+        IndexCacheTopic entry = {};
+        entry.nameOffset = nameOffset;
+        entry.checkpointTableOffset = checkpointTableOffset;
+        entry.lineAmount = countLayoutLines(layout);
+        entry.fileSize = catalog.entries[i].textSize;
+        entry.lastWrite = catalog.entries[i].lastWrite;
+        memcpy(&table[entryIndex++ * sizeof(IndexCacheTopic)], &entry, sizeof(entry));
+
+        packCheckpointTable(layout, &table[checkpointTableOffset]);
+        checkpointTableOffset += checkpointTableSize(layout);
+        const char *name = topicName(catalog, i);
+        size_t nameLength = strlen(name) + 1;
+        memcpy(&table[nameOffset], name, nameLength);
+        nameOffset += nameLength;
+    }
+
+    IndexCacheHeader header = {};
+    memcpy(header.magic, INDEX_CACHE_MAGIC, sizeof(header.magic));
+    header.version = INDEX_CACHE_VERSION;
+    header.lineWidth = lineWidth;
+    header.topicAmount = topicAmount;
+    header.tableSize = tableSize;
+    header.tableChecksum = calculateChecksum(table, tableSize);
+    header.headerChecksum = indexCacheHeaderChecksum(header);
+    memcpy(cache, &header, sizeof(header));
+
+    // A write that is cut off leaves a table that does not match its checksum, which is ignored at the next boot
+    File cacheFile = fs.open(path, FILE_WRITE);
+    if (!cacheFile)
+    {
+        free(cache);
+        return StorageError::OPEN_FAILED;
+    }
+    size_t written = cacheFile.write(cache, sizeof(IndexCacheHeader) + tableSize);
+    cacheFile.close();
+    free(cache);
+    return written == sizeof(IndexCacheHeader) + tableSize ? StorageError::NONE : StorageError::WRITE_FAILED;
+}
@@ -0,0 +1,186 @@
+#include "indexed_canvas.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <esp_heap_caps.h>
+#endif
+
+// ===== Internal Helpers =====
+
+// Squared distance between two RGB565 colors, with each channel scaled to six bits
+static uint32_t colorDistance(uint16_t first, uint16_t second)
+{
+    int16_t red = ((first >> 11) - (second >> 11)) * 2;
+    int16_t green = ((first >> 5) & 0x3F) - ((second >> 5) & 0x3F);
+    int16_t blue = ((first & 0x1F) - (second & 0x1F)) * 2;
+    return red * red + green * green + blue * blue;
+}
+
+// ===== Class Implementations =====
+
+IndexedCanvas::IndexedCanvas(int16_t w, int16_t h, Arduino_G *output) : Arduino_GFX(w, h), output(output)
+{
+}
+
+bool IndexedCanvas::begin(int32_t speed)
+{
+    if (!output->begin(speed))
+    {
+        return false;
+    }
+    if (!framebuffer)
+    {
+        framebuffer = allocateIndexedFramebuffer(WIDTH, HEIGHT);
+    }
+    return framebuffer != nullptr;
+}
+
+void IndexedCanvas::writePixelPreclipped(int16_t x, int16_t y, uint16_t color)
+{
+    setIndexedPixel(&framebuffer[y * INDEXED_CANVAS_ROW_BYTES(WIDTH)], x, colorIndex(color));
+}
+
+void IndexedCanvas::writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    uint8_t index = colorIndex(color);
+    for (int16_t row = y; row < y + h; row++)
+    {
+        fillIndexedPixels(&framebuffer[row * INDEXED_CANVAS_ROW_BYTES(WIDTH)], x, w, index);
+    }
+}
+
+uint8_t *IndexedCanvas::swapFramebuffer(uint8_t *otherFramebuffer)
+{
+    uint8_t *previousFramebuffer = framebuffer;
+    framebuffer = otherFramebuffer;
+    return previousFramebuffer;
+}
+
+uint8_t IndexedCanvas::colorIndex(uint16_t color)
+{
+    if (color == lastColor)
+    {
+        return lastIndex;
+    }
+
+    uint8_t closestIndex = 0;
+    uint32_t closestDistance = UINT32_MAX;
+    for (uint8_t i = 0; i < paletteAmount; i++)
+    {
+        uint32_t distance = colorDistance(palette[i], color);
+        if (distance < closestDistance)
+        {
+            closestDistance = distance;
+            closestIndex = i;
+        }
+    }
+
+    if (closestDistance != 0 && paletteAmount < INDEXED_CANVAS_PALETTE_SIZE)
+    {
+        // Only the pairs holding the new index change, so a frame being expanded on the other core is not affected
+        closestIndex = paletteAmount++;
+        palette[closestIndex] = color;
+        for (uint16_t pair = 0; pair < 256; pair++)
+        {
+            pairColors[pair] = palette[pair & 0x0F] | ((uint32_t)palette[pair >> 4] << 16);
+        }
+    }
+    lastColor = color;
+    lastIndex = closestIndex;
+    return closestIndex;
+}
+
+void IndexedCanvas::expandPixels(const uint8_t *row, int16_t x, int16_t w, uint16_t *destination) const
+{
+    if (w <= 0)
+    {
+        return;
+    }
+    if (x & 1)
+    {
+        *destination++ = palette[row[x >> 1] >> 4];
+        x++;
+        w--;
+    }
+
+    // Every byte becomes two pixels with a single lookup, written as one word when the destination allows it
+    const uint8_t *pairs = &row[x >> 1];
+    if (((uintptr_t)destination & 3) == 0)
+    {
+        uint32_t *words = (uint32_t *)destination;
+        for (int16_t i = 0; i < w / 2; i++)
+        {
+            words[i] = pairColors[pairs[i]];
+        }
+    }
+    else
+    {
+        for (int16_t i = 0; i < w / 2; i++)
+        {
+            destination[i * 2] = pairColors[pairs[i]];
+            destination[i * 2 + 1] = pairColors[pairs[i]] >> 16;
+        }
+    }
+    if (w & 1)
+    {
+        destination[w - 1] = palette[pairs[w / 2] & 0x0F];
+    }
+}
+
+// ===== Functions Implementations =====
+
+uint8_t *allocateIndexedFramebuffer(int16_t w, int16_t h)
+{
+    size_t size = (size_t)INDEXED_CANVAS_ROW_BYTES(w) * h;
+    uint8_t *framebuffer = nullptr;
+#ifdef ARDUINO_ARCH_ESP32
+    framebuffer = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
+    if (!framebuffer)
+    {
+        framebuffer = (uint8_t *)ps_malloc(size);
+    }
+    if (framebuffer)
+    {
+        memset(framebuffer, 0, size);
+    }
+    return framebuffer;
+}
+
+void fillIndexedPixels(uint8_t *row, int16_t x, int16_t w, uint8_t index)
+{
+    if (w <= 0)
+    {
+        return;
+    }
+    if (x & 1)
+    {
+        setIndexedPixel(row, x, index);
+        x++;
+        w--;
+    }
+    memset(&row[x >> 1], index | (index << 4), w >> 1);
+    if (w & 1)
+    {
+        setIndexedPixel(row, x + w - 1, index);
+    }
+}
+
+void copyIndexedPixels(uint8_t *destinationRow, const uint8_t *sourceRow, int16_t x, int16_t w)
+{
+    if (w <= 0)
+    {
+        return;
+    }
+    // The pixels sharing a byte with the run's edges are left alone
+    if (x & 1)
+    {
+        setIndexedPixel(destinationRow, x, sourceRow[x >> 1] >> 4);
+        x++;
+        w--;
+    }
+    memmove(&destinationRow[x >> 1], &sourceRow[x >> 1], w >> 1);
+    if (w & 1)
+    {
+        setIndexedPixel(destinationRow, x + w - 1, sourceRow[(x + w - 1) >> 1] & 0x0F);
+    }
+}
@@ -1,18 +1,65 @@
 #include <Arduino.h>
 
+#include "content_pack.h"
 #include "display_hal.h"
+#include "frame_timing.h"
+#include "index_cache.h"
+#include "qr_code.h"
+#include "storage_benchmark.h"
 #include "storage_hal.h"
+#include "text_layout.h"
+#include "topic_cache.h"
+#include "topic_catalog.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+#endif
 
 // ===== Definitions =====
 
 #define READ_DIRECTORY "/"
+#define CONTENT_PACK_PATH READ_DIRECTORY "content.pak"
+#define INDEX_CACHE_PATH READ_DIRECTORY "index.cache"
+#define STARTUP_TOPIC_LIST_AMOUNT 8 // Topics listed by name during startup, the rest is only counted
+#define STARTUP_ERROR_DELAY 2500    // Startup errors stay on screen this long, without errors the menu follows right away
+#define SERIAL_BAUD 115200
+#define PAGE_LABEL_SIZE 24         // "Page x/y" below the topics of the main screen
+
+// ===== Scroll Definitions =====
+
+#define SCROLL_FRAME_INTERVAL 16          // Milliseconds between the frames of a fling, a little over 60 per second
+#define SCROLL_FLING_TIME_CONSTANT 325.0f // Milliseconds in which a fling slows down to about a third of its speed
+#define SCROLL_FLING_STOP_VELOCITY 0.02f  // Pixels per millisecond below which a fling comes to rest
+
+// ===== QR Code Definitions =====
+
+#define QR_CODE_CACHE_AMOUNT 4 // Encoded QR codes kept, so scrolling over a code or coming back to it does not encode it again
+
+// ===== Markup Definitions =====
+
+#define TOPIC_RULE_HEIGHT 2 // Rows of a horizontal rule, in the middle of its line
+
+// ===== Boot Definitions =====
+
+#define BOOT_TASK_CORE 0 // The touch screen and SD card come up on this core while the display starts on the loop's core
+#define BOOT_TASK_PRIORITY 2
+#define BOOT_TOUCH_TASK_STACK_SIZE 4096
+#define BOOT_STORAGE_TASK_STACK_SIZE 8192
+#define SD_USAGE_TASK_PRIORITY 1 // Measuring the used space of the card can take seconds, it only runs when nothing else needs the core
+#define SD_USAGE_TASK_STACK_SIZE 4096
+#define SD_USAGE_IDLE_TIME 10000 // Milliseconds without touches before the used space is measured, the walk keeps the card busy for seconds
+#define SD_USAGE_POLL_INTERVAL 500 // Milliseconds between checks whether the device has become idle
 
 // ===== Enum Definitions =====
 
 enum class ScreenState
 {
   WAITING,
-  UPDATE
+  UPDATE,
+  UPDATE_INDICATOR,
+  UPDATE_SCROLL
 };
 enum class DeviceState
 {
@@ -20,19 +67,87 @@ enum class DeviceState
   DETAILS_SCREEN
 };
 
+// ===== Struct Definitions =====
+
+struct BootStep
+{
+  void (*function)();
+  const char *name;
+  uint32_t stackSize;
+  uint32_t doneBit; // Set in the boot event group once the step has finished
+};
+
+struct QrCodeCacheEntry
+{
+  uint16_t topicIndex;
+  uint32_t linkOffset;  // Offset of the QR code line in the text of the topic
+  uint32_t lastUse = 0; // Zero while the entry holds no code yet
+  QrCode code;          // Size zero when the link could not be encoded
+};
+
 // ===== Global Variables =====
 
-std::array<Topic, MAXIMUM_FILE_AMOUNT> topicArray;
-Topic selectedtopic;
-uint16_t topicLineCount = 0;
+TopicCatalog topicCatalog;
+uint16_t selectedTopicIndex = 0;
+uint8_t *topicReadBuffer = nullptr;
+StreamReader selectedTopicReader;
+bool selectedTopicCached = false; // The selected topic is read from the topic cache instead of from the card
+TopicLayout *selectedTopicLayout = nullptr;
+StorageError selectedTopicError = StorageError::NONE;
+uint32_t topicLineCount = 0;
+TopicViewport topicViewport; // The lines of the selected topic around what is shown, wrapped again when it scrolls away from them
+QrCodeCacheEntry qrCodeCache[QR_CODE_CACHE_AMOUNT];
+uint32_t qrCodeCacheUseCounter = 0;
 
 ScreenState currentScreenState = ScreenState::UPDATE;
 DeviceState currentDeviceState = DeviceState::MAIN_SCREEN;
 
-uint8_t currentScreenIndex = 0;
+uint16_t currentScreenIndex = 0;
+uint16_t previousScreenIndex = 0;
+
+int32_t topicScrollOffset = 0;      // Pixels the text of the selected topic is scrolled down
+int32_t shownTopicScrollOffset = 0; // Scroll offset of the text that is on the canvas
+float flingVelocity = 0;            // Pixels per millisecond the text keeps scrolling down at after a fling, zero when it is at rest
+float flingPosition = 0;            // Scroll offset of a fling with the fraction of a pixel it has moved beyond it
+unsigned long lastFlingTime = 0;
+bool scrollGestureActive = false; // The text is being dragged or flung, its frames are counted
+uint32_t scrollFrameCount = 0;
+unsigned long scrollStartTime = 0;
+
+bool touchInitialized = false;
+bool storageInitialized = false;
+StorageError contentPackError = StorageError::OPEN_FAILED;
+StorageError topicDirectoryError = StorageError::NONE;
+StorageError indexCacheError = StorageError::NONE;
+uint16_t cachedTopicAmount = 0;
+uint16_t indexedTopicAmount = 0;
+bool bootReported = false;
+volatile unsigned long lastTouchTime = 0; // millis() of the last touch on the screen, read by the used space task on the other core
+
+#ifdef ARDUINO_ARCH_ESP32
+EventGroupHandle_t bootEventGroup = nullptr;
+#endif
 
 // ===== Function Declarations =====
 
+// Start the touch screen and the SD card, each in a task on the other core when possible
+void startBootSteps();
+
+// Wait until the touch screen and the SD card have finished starting
+void waitForBootSteps();
+
+// Initialize the touch screen and its touch events
+void initializeTouchStep();
+
+// Mount the SD card and load the topics from it
+void initializeStorageStep();
+
+// Report the time from power on until the menu is on the panel, and start measuring the used space of the SD card
+void reportBootFinished();
+
+// Measure the used space of the SD card and report it over serial along with its bus clock, and its read throughput when the benchmark is compiled in
+void reportSDCardUsage();
+
 // Handles the different states of the device and determines the updating of the screen
 void stateHandler();
 
@@ -40,99 +155,225 @@ void stateHandler();
 void determineUpDownActionBasedOnDeviceState(ButtonPressed actionButton);
 
 // Dynamically moves through the index and cycles it around when the up or down buttons are pressed
-void moveThroughIndexAndCycle(ButtonPressed moveDirection, uint8_t maximum_index);
+void moveThroughIndexAndCycle(ButtonPressed moveDirection, uint16_t maximum_index);
+
+// Display the page of topics the selected topic is on, with an arrow pointing to the selected topic
+void showTopicOptions(uint16_t selectedIndex, const TopicCatalog &catalog);
+
+// Only move the arrow from the previously selected topic to the newly selected one, both on the same page
+void moveTopicIndicator(uint16_t previousIndex, uint16_t selectedIndex, const TopicCatalog &catalog);
 
-// Also moves through teh index, but limits it to the maximum value
-void moveThroughIndexAndLimit(ButtonPressed moveDirection, uint8_t maximum_index);
+// Calculate the vertical location of a topic option on the main screen
+uint16_t topicOptionLocation(uint16_t index, uint16_t topicAmount);
 
-// Display the different topics with an arrow pointing to the selected topic
-void showTopicOptions(uint8_t selectedIndex, std::array<Topic, MAXIMUM_FILE_AMOUNT> topicsArray);
+// Get the page of the main screen a topic is shown on
+uint16_t topicOptionPage(uint16_t index);
 
 // Display the different topics
-void showTopicDetails(uint8_t lineIndex, Topic selectedTopic);
+void showTopicDetails(int32_t scrollOffset, uint16_t topicIndex);
+
+// Scroll the text of the topic by moving the pixels already on screen, and only draw the band that scrolled into view
+void scrollTopicDetails(int32_t previousScrollOffset, int32_t scrollOffset);
+
+// Display the lines of the selected topic that cross a band of rows of the text area, cut off at the edges of the band
+void showTopicLines(int32_t scrollOffset, int16_t bandY, int16_t bandHeight);
+
+// Draw a line on screen of the selected topic at the given row by running its display list ops. A line that is part of
+// something taller only draws it when it is the first line of the band, otherwise the line above it already did
+void showTopicLine(uint32_t line, int16_t y, bool firstInBand, int16_t bandTop, int16_t bandBottom);
+
+// Draw the QR code a line on screen of the selected topic belongs to, with its top at the given row
+void showTopicQrCode(uint32_t line, int16_t y);
+
+// Draw the scrollbar next to the text, its thumb showing which part of the topic is in view. A topic that fits has none
+void showTopicScrollbar(int32_t scrollOffset);
+
+// Get the QR code of a QR code line of the selected topic, only encoding it when it is not in the QR code cache
+const QrCode &selectedTopicQrCode(const LineSpan &span);
+
+// Get the scroll offset at which the last line of the selected topic is at the bottom of the text area
+int32_t maximumTopicScrollOffset();
+
+// Scroll the text of the selected topic to an offset within its limits, and redraw it when it moved
+void scrollTopicTo(int32_t scrollOffset);
+
+// Drag the text of the selected topic along with a finger, and fling it when the finger lets go while moving
+void scrollTopicWithTouch(const TouchAction &action);
+
+// Page through the text of the selected topic with a tap on its upper or lower half, or jump with a tap on the scrollbar
+void tapTopicDetails(const TouchAction &action);
+
+// Move the text of the selected topic a page up or down, the line at the edge of the page stays in view
+void pageTopic(int8_t direction);
+
+// Move the text of the selected topic to a percentage of the way through it
+void jumpTopicToPercentage(uint8_t percentage);
+
+// Move a fling on by the time passed since its last frame, slowing it down until it comes to rest
+void stepTopicFling();
+
+// Count a frame drawn while the text is dragged or flung
+void countScrollFrame();
+
+// Report the frame rate of the last drag or fling over serial, once the text has come to rest
+void reportScrollFrameRate();
+
+// Open the topic at an index and lay out its text, unless its layout is still known from an earlier visit
+void selectTopic(uint16_t topicIndex);
+
+// Close the selected topic when going back to the menu, so the topic cache can evict it again
+void deselectTopic();
+
+// ===== Boot Steps =====
+
+BootStep bootSteps[] = {
+    {initializeTouchStep, "boot_touch", BOOT_TOUCH_TASK_STACK_SIZE, 1 << 0},
+    {initializeStorageStep, "boot_storage", BOOT_STORAGE_TASK_STACK_SIZE, 1 << 1}};
+
+#ifdef ARDUINO_ARCH_ESP32
+// Runs one boot step on the other core and signals when it is done
+void bootStepTask(void *parameter)
+{
+  const BootStep *step = (const BootStep *)parameter;
+  step->function();
+  xEventGroupSetBits(bootEventGroup, step->doneBit);
+  vTaskDelete(nullptr);
+}
+
+// Measures the used space of the SD card once, without holding up the menu. Walking the FAT holds the card for seconds,
+// so it waits until the topics around the menu are loaded and nobody has touched the screen for a while
+void sdCardUsageTask(void *parameter)
+{
+  while (!isTopicPrefetchIdle() || millis() - lastTouchTime < SD_USAGE_IDLE_TIME)
+  {
+    vTaskDelay(pdMS_TO_TICKS(SD_USAGE_POLL_INTERVAL));
+  }
+  reportSDCardUsage();
+  vTaskDelete(nullptr);
+}
+#endif
 
 // ===== Setup =====
 
 void setup()
 {
-  // Initialize the display
+  Serial.begin(SERIAL_BAUD);
+#ifdef FRAME_TIMING_ENABLED
+  initializeFrameTiming();
+#endif
+
+  // The touch screen and SD card start on the other core, the display comes up in the meantime
+  startBootSteps();
   initializeDisplay(250);
   displayStatusMessage("Initialize Display: ", "OK", GREEN);
+  waitForBootSteps();
+  bool startupFailed = false;
+  if (countTopics(topicCatalog) > 0)
+  {
+    initializeTopicCache(SD, READ_DIRECTORY, topicCatalog);
+  }
 
-  // Initialize the display touch screen
-  if (initializeTouchScreen())
+  // Show the result of initializing the display touch screen
+  if (touchInitialized)
   {
     displayStatusMessage("Initialize Touchscreen: ", "OK", GREEN);
   }
   else
   {
     displayStatusMessage("Initialize Touchscreen: ", "FAILED", RED);
+    startupFailed = true;
   }
 
-  // Initialize the SD card
-  if (initializeStorage())
+  // Show the result of initializing the SD card
+  if (storageInitialized)
   {
     displayStatusMessage("SD Card Mount: ", "OK", GREEN);
   }
   else
   {
     displayStatusMessage("SD Card Mount: ", "FAILED", RED);
+    startupFailed = true;
   }
 
   if (checkIfSDMounted())
   {
-    displayStatusMessage("SD Card Type: ", determineSDCardType(), CYAN);
+    displayStatusMessage("SD Card Type: ", determineSDCardType().c_str(), CYAN);
 
-    std::array<uint64_t, 3> stats = getSDCardStats();
-    displayStatusMessage("SD Card Size: ", (String)stats[0] + "MB", CYAN);
-    displayStatusMessage("SD Card Total Space: ", (String)stats[1] + "MB", CYAN);
-    displayStatusMessage("SD Card Used Space: ", (String)stats[2] + "MB", CYAN);
+    // The used space is left out, it is measured in the background once the menu is up
+    std::array<uint64_t, 2> stats = getSDCardStats();
+    displayStatusMessage("SD Card Size: ", ((String)stats[0] + "MB").c_str(), CYAN);
+    displayStatusMessage("SD Card Total Space: ", ((String)stats[1] + "MB").c_str(), CYAN);
+
+    if (contentPackError != StorageError::OPEN_FAILED)
+    {
+      displayStatusMessage("Content Pack: ", storageErrorToString(contentPackError), contentPackError == StorageError::NONE ? GREEN : RED);
+      startupFailed = startupFailed || contentPackError != StorageError::NONE;
+    }
 
-    // Load the topics from the SD card
-    topicArray = assembleTopicsFromDirectory(SD, READ_DIRECTORY);
     // Check if any errors are returned
-    if (topicArray[0].textFileName == "-1")
+    if (topicDirectoryError == StorageError::OPEN_FAILED)
     {
-      displayStatusMessage(topicArray[0].name + ": ", "FAILED", RED);
+      displayStatusMessage("Open Directory: ", "FAILED", RED);
+      startupFailed = true;
     }
-    else if (topicArray[0].textFileName == "-2")
+    else if (topicDirectoryError == StorageError::NOT_A_DIRECTORY)
     {
-      displayPrintln(topicArray[0].name, WHITE);
+      displayPrintln("Specified path is not a directory!", WHITE);
+      startupFailed = true;
     }
     else
     {
-      // Check if no topics were found
-      if (!topicArray[0].textFileName.isEmpty())
+      uint16_t topicAmount = countTopics(topicCatalog);
+      if (contentPackError != StorageError::NONE)
       {
-        displayStatusMessage("TXT File Read: ", "OK", GREEN);
+        // Check if no topics were found
+        if (topicAmount > 0)
+        {
+          displayStatusMessage("TXT File Read: ", "OK", GREEN);
+          displayStatusMessage("Topic Index: ", (String(cachedTopicAmount) + " cached, " + String(indexedTopicAmount) + " wrapped").c_str(), CYAN);
+          if (indexCacheError != StorageError::NONE)
+          {
+            // Not worth holding up the menu for, the topics are wrapped again at the next boot
+            displayStatusMessage("Index Cache Save: ", storageErrorToString(indexCacheError), RED);
+          }
+        }
+        else
+        {
+          displayStatusMessage("TXT File Read: ", "NONE FOUND", RED);
+          startupFailed = true;
+        }
       }
-      else
+      // List the found topics, a large catalog would not fit on the screen
+      displayPrintln(contentPackError == StorageError::NONE ? "Topics found: " : "TXT Files found: ", WHITE);
+      for (uint16_t i = 0; i < topicAmount && i < STARTUP_TOPIC_LIST_AMOUNT; i++)
       {
-        displayStatusMessage("TXT File Read: ", "NONE FOUND", RED);
+        displayPrintln(("  " + (contentPackError == StorageError::NONE ? String(topicName(topicCatalog, i)) : topicFileName(topicCatalog, i))).c_str(), CYAN);
       }
-      // List the found files
-      displayPrintln("TXT Files found: ", WHITE);
-      for (uint8_t i = 0; i < countAvailableTopics(topicArray); i++)
+      if (topicAmount > STARTUP_TOPIC_LIST_AMOUNT)
       {
-        displayPrintln("  " + topicArray[i].textFileName, CYAN);
+        displayPrintln(("  ... and " + String(topicAmount - STARTUP_TOPIC_LIST_AMOUNT) + " more").c_str(), CYAN);
       }
     }
   }
   else
   {
     displayPrintln("No SD Card Attached!", WHITE);
+    startupFailed = true;
   }
 
-  // Added delay so all info can be read
-  delay(2500);
+  // Only wait when something went wrong, so the error can be read before the menu replaces it
+  if (startupFailed)
+  {
+    delay(STARTUP_ERROR_DELAY);
+  }
 }
 
 // ===== Loop =====
 
 void loop()
 {
+  // Waiting for touch input happens in the state handler, it sleeps until a touch event arrives
   stateHandler();
-  delay(50);
 }
 
 // ===== Function Definitions =====
@@ -141,61 +382,182 @@ void stateHandler()
 {
   if (currentScreenState == ScreenState::UPDATE)
   {
+    FRAME_TIMING_SCOPE(TimingStage::SCREEN_UPDATE);
     if (currentDeviceState == DeviceState::MAIN_SCREEN)
     {
       displayDrawInterface(MAGENTA, WHITE, "Select");
-      showTopicOptions(currentScreenIndex, topicArray);
+      showTopicOptions(currentScreenIndex, topicCatalog);
     }
     else if (currentDeviceState == DeviceState::DETAILS_SCREEN)
     {
       displayDrawInterface(MAGENTA, WHITE, "Back");
-      showTopicDetails(currentScreenIndex, selectedtopic);
+      showTopicDetails(topicScrollOffset, selectedTopicIndex);
+      shownTopicScrollOffset = topicScrollOffset;
     }
 
     flushToDisplay();
     currentScreenState = ScreenState::WAITING;
+    if (!bootReported)
+    {
+      reportBootFinished();
+    }
+    if (currentDeviceState == DeviceState::MAIN_SCREEN)
+    {
+      // Load the selected topic and its neighbours in the background, so opening one rarely has to wait for the card
+      prefetchTopics(currentScreenIndex);
+    }
+  }
+  else if (currentScreenState == ScreenState::UPDATE_INDICATOR)
+  {
+    FRAME_TIMING_SCOPE(TimingStage::PARTIAL_UPDATE);
+    moveTopicIndicator(previousScreenIndex, currentScreenIndex, topicCatalog);
+    flushToDisplay();
+    currentScreenState = ScreenState::WAITING;
+    prefetchTopics(currentScreenIndex);
+  }
+  else if (currentScreenState == ScreenState::UPDATE_SCROLL)
+  {
+    FRAME_TIMING_SCOPE(TimingStage::PARTIAL_UPDATE);
+    scrollTopicDetails(shownTopicScrollOffset, topicScrollOffset);
+    shownTopicScrollOffset = topicScrollOffset;
+    flushToDisplay();
+    countScrollFrame();
+    currentScreenState = ScreenState::WAITING;
   }
   else if (currentScreenState == ScreenState::WAITING)
   {
-    ButtonPressed resultButton = readTouchScreen();
+    // While the text is flung the touch screen is only waited on until its next frame is due
+    uint32_t waitTime = UINT32_MAX;
+    if (flingVelocity != 0)
+    {
+      unsigned long sinceFrame = millis() - lastFlingTime;
+      waitTime = sinceFrame >= SCROLL_FRAME_INTERVAL ? 0 : SCROLL_FRAME_INTERVAL - sinceFrame;
+    }
+    TouchAction action = readTouchScreen(waitTime);
+    if (action.button != ButtonPressed::NONE || action.dragging || action.tapX >= 0)
+    {
+      lastTouchTime = millis();
+    }
+    if (currentDeviceState == DeviceState::DETAILS_SCREEN)
+    {
+      scrollTopicWithTouch(action);
+      tapTopicDetails(action);
+    }
+
+    ButtonPressed resultButton = action.button;
     if (resultButton != ButtonPressed::NONE)
     {
       if (resultButton == ButtonPressed::SELECT_BACK_BUTTON)
       {
-        if (currentDeviceState == DeviceState::MAIN_SCREEN)
+        // Without any topics there is nothing to select
+        if (currentDeviceState == DeviceState::MAIN_SCREEN && countTopics(topicCatalog) > 0)
         {
           currentDeviceState = DeviceState::DETAILS_SCREEN;
-          selectedtopic = topicArray[currentScreenIndex];
+          selectTopic(currentScreenIndex);
         }
         else if (currentDeviceState == DeviceState::DETAILS_SCREEN)
         {
           currentDeviceState = DeviceState::MAIN_SCREEN;
+          deselectTopic();
         }
         currentScreenIndex = 0;
+        topicScrollOffset = 0;
+        flingVelocity = 0;
+        currentScreenState = ScreenState::UPDATE;
       }
       else
       {
+        previousScreenIndex = currentScreenIndex;
         determineUpDownActionBasedOnDeviceState(resultButton);
+
+        // Nothing to redraw when the index is already at its limit, on the main screen only the indicator moves
+        // while it stays on the same page. The details screen scrolls its text itself
+        if (currentDeviceState == DeviceState::MAIN_SCREEN && currentScreenIndex != previousScreenIndex)
+        {
+          currentScreenState = topicOptionPage(currentScreenIndex) == topicOptionPage(previousScreenIndex) ? ScreenState::UPDATE_INDICATOR : ScreenState::UPDATE;
+        }
       }
+    }
+  }
+}
 
-      currentScreenState = ScreenState::UPDATE;
+void selectTopic(uint16_t topicIndex)
+{
+  FRAME_TIMING_SCOPE(TimingStage::TOPIC_SELECT);
+  TopicEntry &topic = topicCatalog.entries[topicIndex];
+  selectedTopicIndex = topicIndex;
+  selectedTopicLayout = &topicCatalog.layouts[topicIndex];
+
+  // Usually the topic is already in the cache, only topics too large for it are streamed from the card
+  CachedTopic cachedTopic;
+  selectedTopicCached = acquireCachedTopic(topicIndex, cachedTopic);
+  if (selectedTopicCached)
+  {
+    openMemoryStreamReader(cachedTopic.text, cachedTopic.size, selectedTopicReader);
+    selectedTopicError = StorageError::NONE;
+  }
+  else
+  {
+    selectedTopicError = openTopicStreamReader(SD, READ_DIRECTORY, topicCatalog, topicIndex, topicReadBuffer, STREAM_READER_BUFFER_SIZE, selectedTopicReader);
+  }
+
+  // Text from a content pack is checked once, a corrupt topic shows its error instead of garbage. Cached text was checked while it was loaded
+  if (selectedTopicError == StorageError::NONE && !topic.textVerified)
+  {
+    FRAME_TIMING_SCOPE(TimingStage::TOPIC_VERIFY);
+    if (selectedTopicCached)
+    {
+      selectedTopicError = cachedTopic.textMatches ? StorageError::NONE : StorageError::CHECKSUM_MISMATCH;
     }
+    else
+    {
+      selectedTopicError = verifyContentPackText(selectedTopicReader, topic.textChecksum);
+    }
+    topic.textVerified = selectedTopicError == StorageError::NONE;
+  }
+
+  // The layout is kept per topic, so a topic is only wrapped as a whole the first time it is opened
+  if (selectedTopicError == StorageError::NONE && !isTopicLaidOut(*selectedTopicLayout, DETAILS_LINE_WIDTH))
+  {
+    FRAME_TIMING_SCOPE(TimingStage::TOPIC_LAYOUT);
+    selectedTopicError = layoutTopic(selectedTopicReader, DETAILS_LINE_WIDTH, *selectedTopicLayout);
+  }
+  topicLineCount = selectedTopicError == StorageError::NONE ? countLayoutLines(*selectedTopicLayout) : 0;
+  openTopicViewport(*selectedTopicLayout, topicViewport);
+}
+
+void deselectTopic()
+{
+  closeStreamReader(selectedTopicReader);
+  if (selectedTopicCached)
+  {
+    releaseCachedTopic(selectedTopicIndex);
+    selectedTopicCached = false;
   }
 }
 
 void determineUpDownActionBasedOnDeviceState(ButtonPressed actionButton)
 {
-  if (currentDeviceState == DeviceState::MAIN_SCREEN)
+  if (currentDeviceState == DeviceState::MAIN_SCREEN && countTopics(topicCatalog) > 0)
   {
-    moveThroughIndexAndCycle(actionButton, countAvailableTopics(topicArray) - 1);
+    moveThroughIndexAndCycle(actionButton, countTopics(topicCatalog) - 1);
   }
   else if (currentDeviceState == DeviceState::DETAILS_SCREEN)
   {
-    moveThroughIndexAndLimit(actionButton, topicLineCount - DETAILS_LINE_AMOUNT);
+    // The buttons move the text by a whole line, a text left between lines by a drag snaps to the next line
+    flingVelocity = 0;
+    if (actionButton == ButtonPressed::DOWN_BUTTON)
+    {
+      scrollTopicTo((topicScrollOffset / DETAILS_LINE_HEIGHT + 1) * DETAILS_LINE_HEIGHT);
+    }
+    else if (actionButton == ButtonPressed::UP_BUTTON)
+    {
+      scrollTopicTo(((topicScrollOffset + DETAILS_LINE_HEIGHT - 1) / DETAILS_LINE_HEIGHT - 1) * DETAILS_LINE_HEIGHT);
+    }
   }
 }
 
-void moveThroughIndexAndCycle(ButtonPressed moveDirection, uint8_t maximum_index)
+void moveThroughIndexAndCycle(ButtonPressed moveDirection, uint16_t maximum_index)
 {
   if (moveDirection == ButtonPressed::DOWN_BUTTON)
   {
@@ -221,81 +583,473 @@ void moveThroughIndexAndCycle(ButtonPressed moveDirection, uint8_t maximum_index
   }
 }
 
-void moveThroughIndexAndLimit(ButtonPressed moveDirection, uint8_t maximum_index)
+void showTopicOptions(uint16_t selectedIndex, const TopicCatalog &catalog)
 {
-  if (moveDirection == ButtonPressed::DOWN_BUTTON)
+  uint16_t topicAmount = countTopics(catalog);
+
+  setTextSize(2);
+
+  if (topicAmount == 0)
   {
-    if (currentScreenIndex < maximum_index)
-    {
-      currentScreenIndex++;
-    }
+    setCursorLocation(MAIN_SCREEN_PADDING_SIZE, topicOptionLocation(0, 1));
+    displayPrintWithoutFlush("No topics found", WHITE);
+    return;
   }
-  else if (moveDirection == ButtonPressed::UP_BUTTON)
+
+  // Display only the topics on the page of the selected topic
+  uint16_t firstIndex = topicOptionPage(selectedIndex) * MAIN_MENU_ROW_AMOUNT;
+  uint16_t lastIndex = min((uint32_t)topicAmount, (uint32_t)firstIndex + MAIN_MENU_ROW_AMOUNT);
+  for (uint16_t i = firstIndex; i < lastIndex; i++)
   {
-    if (currentScreenIndex > 0)
-    {
-      currentScreenIndex--;
-    }
+    setCursorLocation(MAIN_SCREEN_PADDING_SIZE, topicOptionLocation(i, topicAmount));
+    displayPrintWithoutFlush(topicName(catalog, i), WHITE);
   }
+
+  // Show where the page is in the catalog when it does not fit on one page
+  if (topicAmount > MAIN_MENU_ROW_AMOUNT)
+  {
+    setTextSize(1);
+    setCursorLocation(MAIN_SCREEN_PADDING_SIZE, SCREEN_HEIGHT - MAIN_SCREEN_PADDING_SIZE / 2);
+    char pageLabel[PAGE_LABEL_SIZE];
+    snprintf(pageLabel, sizeof(pageLabel), "Page %u/%u", topicOptionPage(selectedIndex) + 1, topicOptionPage(topicAmount - 1) + 1);
+    displayPrintWithoutFlush(pageLabel, WHITE);
+    setTextSize(2);
+  }
+
+  // Display the indicator
+  setCursorLocation(MAIN_SCREEN_PADDING_SIZE / 2, topicOptionLocation(selectedIndex, topicAmount));
+  displayPrintWithoutFlush(">", WHITE);
 }
 
-void showTopicOptions(uint8_t selectedIndex, std::array<Topic, MAXIMUM_FILE_AMOUNT> topicsArray)
+void moveTopicIndicator(uint16_t previousIndex, uint16_t selectedIndex, const TopicCatalog &catalog)
 {
-  uint16_t divisionSize = (SCREEN_HEIGHT - MAIN_SCREEN_PADDING_SIZE * 2) / countAvailableTopics(topicsArray);
+  uint16_t topicAmount = countTopics(catalog);
 
   setTextSize(2);
 
-  // Display all the different topics available
-  for (uint8_t i = 0; i < countAvailableTopics(topicsArray); i++)
-  {
-    setCursorLocation(MAIN_SCREEN_PADDING_SIZE, MAIN_SCREEN_PADDING_SIZE + (divisionSize * i + 8)); // Add the 8 to compensate for the text size
-    displayPrintWithoutFlush(topicsArray[i].name, WHITE);
-  }
+  // Erase the old indicator, a character of size 2 is 12x16
+  clearDisplayRegion(MAIN_SCREEN_PADDING_SIZE / 2, topicOptionLocation(previousIndex, topicAmount), 12, 16);
 
-  // Display the indicator
-  setCursorLocation(MAIN_SCREEN_PADDING_SIZE / 2, MAIN_SCREEN_PADDING_SIZE + (divisionSize * selectedIndex + 8));
+  // Display the indicator at its new location
+  setCursorLocation(MAIN_SCREEN_PADDING_SIZE / 2, topicOptionLocation(selectedIndex, topicAmount));
   displayPrintWithoutFlush(">", WHITE);
 }
 
-void showTopicDetails(uint8_t lineIndex, Topic selectedTopic)
+uint16_t topicOptionLocation(uint16_t index, uint16_t topicAmount)
+{
+  // The rows are spread over the screen like a single page, also when there are more pages
+  uint16_t divisionSize = (SCREEN_HEIGHT - MAIN_SCREEN_PADDING_SIZE * 2) / min(topicAmount, (uint16_t)MAIN_MENU_ROW_AMOUNT);
+  return MAIN_SCREEN_PADDING_SIZE + (divisionSize * (index % MAIN_MENU_ROW_AMOUNT) + 8); // Add the 8 to compensate for the text size
+}
+
+uint16_t topicOptionPage(uint16_t index)
+{
+  return index / MAIN_MENU_ROW_AMOUNT;
+}
+
+void showTopicDetails(int32_t scrollOffset, uint16_t topicIndex)
 {
   // Display the title of the topic
   setTextSize(2);
   setCursorLocation(DETAILS_SCREEN_PADDING_SIZE, DETAILS_SCREEN_PADDING_SIZE);
-  displayPrintWithoutFlush(selectedTopic.name, WHITE);
+  displayPrintWithoutFlush(topicName(topicCatalog, topicIndex), WHITE);
 
-  String fileContents = readFile(SD, READ_DIRECTORY + selectedtopic.textFileName);
-  if (fileContents == "-1")
+  if (selectedTopicError != StorageError::NONE)
   {
-    displayStatusMessage("Open File: ", "FAILED", RED);
+    displayStatusMessage("Open File: ", storageErrorToString(selectedTopicError), RED);
   }
   else
   {
-    // First count the amount of lines based on the
-    topicLineCount = 0;
-    for (unsigned int i = 0; i < fileContents.length(); i++)
+    // Display the text of the topic, as far as it fills the text area
+    showTopicLines(scrollOffset, 0, DETAILS_TEXT_HEIGHT);
+    showTopicScrollbar(scrollOffset);
+  }
+}
+
+void scrollTopicDetails(int32_t previousScrollOffset, int32_t scrollOffset)
+{
+  int32_t difference = scrollOffset - previousScrollOffset;
+  int16_t bandHeight = min(abs(difference), (int32_t)DETAILS_TEXT_HEIGHT);
+  scrollDisplayRegion(DETAILS_SCREEN_PADDING_SIZE, DETAILS_TEXT_Y, DETAILS_TEXT_WIDTH, DETAILS_TEXT_HEIGHT, -difference);
+
+  // Scrolling down uncovers a band at the bottom, scrolling up at the top
+  if (difference > 0)
+  {
+    showTopicLines(scrollOffset, DETAILS_TEXT_HEIGHT - bandHeight, bandHeight);
+  }
+  else if (difference < 0)
+  {
+    showTopicLines(scrollOffset, 0, bandHeight);
+  }
+  showTopicScrollbar(scrollOffset);
+}
+
+void showTopicLines(int32_t scrollOffset, int16_t bandY, int16_t bandHeight)
+{
+  // Only the lines that cross the band are drawn, the viewport wraps and compiles them when they are not in its window yet
+  uint32_t firstLine = (scrollOffset + bandY) / DETAILS_LINE_HEIGHT;
+  uint32_t lastLine = (scrollOffset + bandY + bandHeight - 1) / DETAILS_LINE_HEIGHT;
+  if (moveTopicViewport(selectedTopicReader, topicViewport, firstLine, lastLine - firstLine + 1) != StorageError::NONE)
+  {
+    return;
+  }
+
+  setTextClipRows(DETAILS_TEXT_Y + bandY, bandHeight);
+  for (uint32_t line = firstLine; line <= lastLine && isLineInViewport(topicViewport, line); line++)
+  {
+    showTopicLine(line, DETAILS_TEXT_Y + line * DETAILS_LINE_HEIGHT - scrollOffset, line == firstLine, DETAILS_TEXT_Y + bandY, DETAILS_TEXT_Y + bandY + bandHeight);
+  }
+  setTextClipRows(0, SCREEN_HEIGHT);
+  setTextSize(1);
+}
+
+void showTopicLine(uint32_t line, int16_t y, bool firstInBand, int16_t bandTop, int16_t bandBottom)
+{
+  size_t opsLength;
+  const uint8_t *ops = viewportLineOps(topicViewport, line, opsLength);
+  const uint8_t *opsEnd = ops + opsLength;
+  uint16_t color = markupColor(MARKUP_TEXT_COLOR_INDEX);
+  setTextSize(1);
+  setCursorLocation(DETAILS_SCREEN_PADDING_SIZE, y);
+  while (ops < opsEnd)
+  {
+    switch ((DisplayOp)*ops++)
     {
-      if (fileContents[i] == '\n')
+    case DisplayOp::TEXT:
+      displayPrintWithoutFlush((const char *)ops, color);
+      ops += strlen((const char *)ops) + 1;
+      break;
+    case DisplayOp::COLOR:
+      color = markupColor(*ops++);
+      break;
+    case DisplayOp::SIZE:
+      setTextSize(*ops++);
+      break;
+    case DisplayOp::PART:
+      // The clip rows cut what is drawn from the lines above to the band
+      if (!firstInBand)
       {
-        topicLineCount++;
+        return;
       }
+      y -= *ops++ * DETAILS_LINE_HEIGHT;
+      setCursorLocation(DETAILS_SCREEN_PADDING_SIZE, y);
+      break;
+    case DisplayOp::RULE:
+    {
+      int16_t top = max((int16_t)(y + (DETAILS_LINE_HEIGHT - TOPIC_RULE_HEIGHT) / 2), bandTop);
+      int16_t bottom = min((int16_t)(y + (DETAILS_LINE_HEIGHT + TOPIC_RULE_HEIGHT) / 2), bandBottom);
+      if (bottom > top)
+      {
+        fillDisplayRegion(DETAILS_SCREEN_PADDING_SIZE, top, DETAILS_LINE_WIDTH * 6, bottom - top, color);
+      }
+      break;
+    }
+    case DisplayOp::QR_CODE:
+      showTopicQrCode(line, y);
+      break;
     }
+  }
+}
+
+void showTopicQrCode(uint32_t line, int16_t y)
+{
+  const LineSpan &span = viewportLineSpan(topicViewport, line);
+  const QrCode &code = selectedTopicQrCode(span);
+  if (code.size == 0)
+  {
+    setCursorLocation(DETAILS_SCREEN_PADDING_SIZE, y);
+    displayPrintWithoutFlush("[QR code: link could not be read]", RED);
+    return;
+  }
 
-    String splitLines[topicLineCount];
-    for (uint16_t i = 0; i < topicLineCount; i++)
+  // The largest scale that fits the lines of the code, centered in them
+  const int16_t codeHeight = LAYOUT_QR_CODE_LINE_AMOUNT * DETAILS_LINE_HEIGHT;
+  uint8_t scale = max(codeHeight / (code.size + 2 * QR_CODE_QUIET_ZONE), 1);
+  displayDrawQrCode(DETAILS_SCREEN_PADDING_SIZE, y + (codeHeight - qrCodePixelSize(code, scale)) / 2, code, scale);
+}
+
+void showTopicScrollbar(int32_t scrollOffset)
+{
+  clearDisplayRegion(DETAILS_SCROLLBAR_X, DETAILS_TEXT_Y, DETAILS_SCROLLBAR_WIDTH, DETAILS_TEXT_HEIGHT);
+  int32_t maximumOffset = maximumTopicScrollOffset();
+  if (maximumOffset == 0)
+  {
+    return;
+  }
+
+  // The thumb takes the share of the bar the text area takes of the whole topic, and moves along the rest of it
+  int64_t topicHeight = (int64_t)maximumOffset + DETAILS_TEXT_HEIGHT;
+  int16_t thumbHeight = max((int16_t)(DETAILS_TEXT_HEIGHT * DETAILS_TEXT_HEIGHT / topicHeight), (int16_t)DETAILS_SCROLLBAR_MIN_HEIGHT);
+  int16_t thumbY = (int64_t)(DETAILS_TEXT_HEIGHT - thumbHeight) * scrollOffset / maximumOffset;
+  fillDisplayRegion(DETAILS_SCROLLBAR_X, DETAILS_TEXT_Y + thumbY, DETAILS_SCROLLBAR_WIDTH, thumbHeight, DARKGREEN);
+}
+
+const QrCode &selectedTopicQrCode(const LineSpan &span)
+{
+  QrCodeCacheEntry *oldestEntry = &qrCodeCache[0];
+  for (QrCodeCacheEntry &entry : qrCodeCache)
+  {
+    if (entry.lastUse != 0 && entry.topicIndex == selectedTopicIndex && entry.linkOffset == span.offset)
+    {
+      entry.lastUse = ++qrCodeCacheUseCounter;
+      return entry.code;
+    }
+    if (entry.lastUse < oldestEntry->lastUse)
     {
-      // Add the current line to the array
-      splitLines[i] = fileContents.substring(0, fileContents.indexOf('\n'));
-      // Cut the added line off from the remaining string
-      fileContents = fileContents.substring(fileContents.indexOf('\n') + 1);
+      oldestEntry = &entry;
     }
+  }
 
-    // Display the text of the topic, for a set amount of lines or for the max amount of lines available
-    setTextSize(1);
-    for (uint8_t i = 0; i < DETAILS_LINE_AMOUNT && i < topicLineCount; i++)
+  // Not encoded yet, so it takes the place of the code that was used the longest ago
+  FRAME_TIMING_SCOPE(TimingStage::QR_ENCODE);
+  char link[STREAM_LINE_MAX_LENGTH];
+  size_t linkLength;
+  oldestEntry->topicIndex = selectedTopicIndex;
+  oldestEntry->linkOffset = span.offset;
+  oldestEntry->lastUse = ++qrCodeCacheUseCounter;
+  if (readQrCodeLink(selectedTopicReader, span, link, sizeof(link), linkLength) != StorageError::NONE || !encodeQrCode(link, linkLength, oldestEntry->code))
+  {
+    oldestEntry->code.size = 0;
+  }
+  return oldestEntry->code;
+}
+
+int32_t maximumTopicScrollOffset()
+{
+  // A topic shorter than the text area can not scroll at all
+  return max((int32_t)topicLineCount * DETAILS_LINE_HEIGHT - DETAILS_TEXT_HEIGHT, (int32_t)0);
+}
+
+void scrollTopicTo(int32_t scrollOffset)
+{
+  scrollOffset = min(max(scrollOffset, (int32_t)0), maximumTopicScrollOffset());
+  if (scrollOffset != topicScrollOffset)
+  {
+    topicScrollOffset = scrollOffset;
+    currentScreenState = ScreenState::UPDATE_SCROLL;
+  }
+}
+
+void scrollTopicWithTouch(const TouchAction &action)
+{
+  // A finger on the text catches a fling, and the text follows the finger while it drags
+  if (action.dragging)
+  {
+    flingVelocity = 0;
+  }
+  if (action.dragDistance != 0)
+  {
+    scrollGestureActive = true;
+    scrollTopicTo(topicScrollOffset - action.dragDistance);
+  }
+
+  // A finger moving up moves the text further down the topic
+  if (action.flingVelocity != 0)
+  {
+    scrollGestureActive = true;
+    flingVelocity = -action.flingVelocity;
+    flingPosition = topicScrollOffset;
+    lastFlingTime = millis();
+  }
+  else if (flingVelocity != 0 && millis() - lastFlingTime >= SCROLL_FRAME_INTERVAL)
+  {
+    stepTopicFling();
+  }
+
+  if (scrollGestureActive && !action.dragging && flingVelocity == 0 && currentScreenState == ScreenState::WAITING)
+  {
+    reportScrollFrameRate();
+  }
+}
+
+void tapTopicDetails(const TouchAction &action)
+{
+  if (action.tapX < 0 || action.tapY < DETAILS_TEXT_Y || action.tapY >= DETAILS_TEXT_Y + DETAILS_TEXT_HEIGHT)
+  {
+    return;
+  }
+
+  // The finger going down already caught a fling
+  if (action.tapX >= DETAILS_SCROLLBAR_TOUCH_X)
+  {
+    // The height between the end zones maps to the percentages rounded to the nearest, the end zones to the start and end
+    int32_t tapPosition = action.tapY - DETAILS_TEXT_Y - DETAILS_SCROLLBAR_END_ZONE;
+    int32_t tapRange = DETAILS_TEXT_HEIGHT - 1 - 2 * DETAILS_SCROLLBAR_END_ZONE;
+    jumpTopicToPercentage(min(max((tapPosition * 100 + tapRange / 2) / tapRange, (int32_t)0), (int32_t)100));
+  }
+  else
+  {
+    pageTopic(action.tapY < DETAILS_TEXT_Y + DETAILS_TEXT_HEIGHT / 2 ? -1 : 1);
+  }
+}
+
+void pageTopic(int8_t direction)
+{
+  // Like the buttons a page moves by whole lines, one line less than the text area holds
+  flingVelocity = 0;
+  if (direction > 0)
+  {
+    scrollTopicTo((topicScrollOffset / DETAILS_LINE_HEIGHT + DETAILS_LINE_AMOUNT - 1) * DETAILS_LINE_HEIGHT);
+  }
+  else
+  {
+    scrollTopicTo(((topicScrollOffset + DETAILS_LINE_HEIGHT - 1) / DETAILS_LINE_HEIGHT - (DETAILS_LINE_AMOUNT - 1)) * DETAILS_LINE_HEIGHT);
+  }
+}
+
+void jumpTopicToPercentage(uint8_t percentage)
+{
+  // Only the lines around the new offset are wrapped, however far into the topic it is
+  flingVelocity = 0;
+  int32_t scrollOffset = (int64_t)maximumTopicScrollOffset() * min(percentage, (uint8_t)100) / 100;
+  scrollTopicTo(scrollOffset / DETAILS_LINE_HEIGHT * DETAILS_LINE_HEIGHT);
+}
+
+void stepTopicFling()
+{
+  // The speed decays exponentially, the distance is what that speed covers over the time passed
+  unsigned long now = millis();
+  float decay = expf(-(float)(now - lastFlingTime) / SCROLL_FLING_TIME_CONSTANT);
+  flingPosition += flingVelocity * SCROLL_FLING_TIME_CONSTANT * (1 - decay);
+  flingVelocity *= decay;
+  lastFlingTime = now;
+
+  // The fling stops at either end of the topic instead of bouncing
+  int32_t maximumOffset = maximumTopicScrollOffset();
+  if (flingPosition <= 0 || flingPosition >= maximumOffset || fabsf(flingVelocity) < SCROLL_FLING_STOP_VELOCITY)
+  {
+    flingVelocity = 0;
+  }
+  scrollTopicTo(lroundf(flingPosition));
+}
+
+void countScrollFrame()
+{
+  if (!scrollGestureActive)
+  {
+    return;
+  }
+  if (scrollFrameCount == 0)
+  {
+    scrollStartTime = millis();
+  }
+  scrollFrameCount++;
+}
+
+void reportScrollFrameRate()
+{
+  // The first frame starts the clock, so the rate is over the frames that came after it
+  unsigned long elapsed = millis() - scrollStartTime;
+  if (scrollFrameCount > 1 && elapsed > 0)
+  {
+    Serial.printf("Scroll: %u frames in %lu ms, %lu fps\r\n", (unsigned int)scrollFrameCount, elapsed, (scrollFrameCount - 1) * 1000UL / elapsed);
+  }
+  scrollGestureActive = false;
+  scrollFrameCount = 0;
+}
+
+void startBootSteps()
+{
+#ifdef ARDUINO_ARCH_ESP32
+  bootEventGroup = xEventGroupCreate();
+#endif
+  for (BootStep &step : bootSteps)
+  {
+#ifdef ARDUINO_ARCH_ESP32
+    if (bootEventGroup &&
+        xTaskCreatePinnedToCore(bootStepTask, step.name, step.stackSize, &step, BOOT_TASK_PRIORITY, nullptr, BOOT_TASK_CORE) == pdPASS)
     {
-      setCursorLocation(DETAILS_SCREEN_PADDING_SIZE, DETAILS_SCREEN_PADDING_SIZE + 29 + i * 8);
-      displayPrintWithoutFlush(splitLines[currentScreenIndex + i], WHITE);
+      continue;
     }
+#endif
+    // Without a task the step simply runs right away
+    step.function();
+#ifdef ARDUINO_ARCH_ESP32
+    if (bootEventGroup)
+    {
+      xEventGroupSetBits(bootEventGroup, step.doneBit);
+    }
+#endif
+  }
+}
+
+void waitForBootSteps()
+{
+#ifdef ARDUINO_ARCH_ESP32
+  if (!bootEventGroup)
+  {
+    return;
   }
+  uint32_t allDoneBits = 0;
+  for (const BootStep &step : bootSteps)
+  {
+    allDoneBits |= step.doneBit;
+  }
+  xEventGroupWaitBits(bootEventGroup, allDoneBits, pdFALSE, pdTRUE, portMAX_DELAY);
+#endif
+}
+
+void initializeTouchStep()
+{
+  touchInitialized = initializeTouchScreen();
+}
+
+void initializeStorageStep()
+{
+  storageInitialized = initializeStorage();
+  if (!checkIfSDMounted())
+  {
+    return;
+  }
+
+  // Topics are streamed through this buffer, so reading them never needs more memory than this
+  topicReadBuffer = allocateReadBuffer(STREAM_READER_BUFFER_SIZE);
+
+  // Load the topics from the content pack, and only scan the directory for text files when there is none
+  contentPackError = loadContentPack(SD, CONTENT_PACK_PATH, topicCatalog);
+  if (contentPackError != StorageError::NONE)
+  {
+    topicDirectoryError = assembleTopicsFromDirectory(SD, READ_DIRECTORY, topicCatalog);
+  }
+  if (contentPackError == StorageError::NONE || topicDirectoryError != StorageError::NONE)
+  {
+    return;
+  }
+
+  // Text files that did not change since the last boot get their layout from the index cache, only the others are
+  // wrapped here, so opening any topic later never has to go through its whole file
+  loadIndexCache(SD, INDEX_CACHE_PATH, DETAILS_LINE_WIDTH, topicCatalog, cachedTopicAmount);
+  indexTopics(SD, READ_DIRECTORY, DETAILS_LINE_WIDTH, topicReadBuffer, STREAM_READER_BUFFER_SIZE, topicCatalog, indexedTopicAmount);
+  if (indexedTopicAmount > 0)
+  {
+    indexCacheError = saveIndexCache(SD, INDEX_CACHE_PATH, DETAILS_LINE_WIDTH, topicCatalog);
+  }
+}
+
+void reportBootFinished()
+{
+  bootReported = true;
+  waitForDisplayFlush();
+  Serial.printf("Boot to menu: %lu ms\r\n", millis());
+
+  if (!checkIfSDMounted())
+  {
+    return;
+  }
+#ifdef ARDUINO_ARCH_ESP32
+  if (xTaskCreatePinnedToCore(sdCardUsageTask, "sd_usage", SD_USAGE_TASK_STACK_SIZE, nullptr, SD_USAGE_TASK_PRIORITY, nullptr, BOOT_TASK_CORE) == pdPASS)
+  {
+    return;
+  }
+#endif
+  reportSDCardUsage();
+}
+
+void reportSDCardUsage()
+{
+  Serial.printf("SD Card Clock: %luMHz\r\n", (unsigned long)(storageBusFrequency() / 1000000));
+  Serial.printf("SD Card Used Space: %lluMB\r\n", (unsigned long long)getSDCardUsedSpace());
+#ifdef STORAGE_BENCHMARK_ENABLED
+  runStorageBenchmark(SD, READ_DIRECTORY);
+#endif
 }
\ No newline at end of file
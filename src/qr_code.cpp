@@ -0,0 +1,604 @@
+#include "qr_code.h"
+#include "indexed_canvas.h"
+
+// The encoding follows ISO/IEC 18004: the text goes into data codewords, which are split into blocks that each get
+// Reed-Solomon error correction codewords. The interleaved codewords are placed around the function patterns, and the
+// mask that leaves the fewest patterns a scanner could trip over is applied.
+
+// ===== Encoding Definitions =====
+
+#define QR_CODE_MAX_BLOCKS 5            // Error correction blocks of the largest code
+#define QR_CODE_MAX_BLOCK_ECC_LENGTH 26 // Error correction codewords per block of the largest code
+#define QR_CODE_FORMAT_LEVEL_BITS 0     // Level M in the format information
+#define QR_CODE_MODE_BYTE 0x4
+#define QR_CODE_PAD_FIRST 0xEC          // Padding codewords that fill the data after the text, taking turns
+#define QR_CODE_PAD_SECOND 0x11
+#define QR_CODE_MASK_AMOUNT 8
+#define QR_CODE_PENALTY_RUN 3           // Penalty for five modules in a row of the same color, plus one for every further module
+#define QR_CODE_PENALTY_BLOCK 3         // Penalty for every 2x2 block of the same color
+#define QR_CODE_PENALTY_FINDER 40       // Penalty for every stretch that looks like a finder pattern
+#define QR_CODE_PENALTY_BALANCE 10      // Penalty for every 5% the dark modules are away from half
+
+// ===== Internal Tables =====
+
+// Error correction codewords per block and amount of blocks at level M, by version
+static const uint8_t eccCodewordsPerBlock[QR_CODE_MAX_VERSION + 1] = {0, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26};
+static const uint8_t eccBlockAmounts[QR_CODE_MAX_VERSION + 1] = {0, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5};
+
+// ===== Struct Definitions =====
+
+// Codewords being built up a bit at a time, most significant bit first
+struct QrBitBuffer
+{
+    uint8_t *bytes;
+    uint16_t bitLength;
+};
+
+// ===== Internal Helpers =====
+
+// Set a module of a code to dark or light
+static void setQrModule(QrCode &code, uint8_t x, uint8_t y, bool dark)
+{
+    if (dark)
+    {
+        code.modules[y][x >> 3] |= 1 << (x & 7);
+    }
+    else
+    {
+        code.modules[y][x >> 3] &= ~(1 << (x & 7));
+    }
+}
+
+// Set a module that belongs to a function pattern, and remember it is one so no data is placed there
+static void setFunctionModule(QrCode &code, QrCode &functionModules, uint8_t x, uint8_t y, bool dark)
+{
+    setQrModule(code, x, y, dark);
+    setQrModule(functionModules, x, y, true);
+}
+
+// Count the modules of a version that are left for codewords once the function patterns are placed
+static uint16_t countRawDataModules(uint8_t version)
+{
+    uint16_t result = (16 * version + 128) * version + 64;
+    if (version >= 2)
+    {
+        uint8_t alignmentAmount = version / 7 + 2;
+        result -= (25 * alignmentAmount - 10) * alignmentAmount - 55;
+        if (version >= 7)
+        {
+            result -= 36;
+        }
+    }
+    return result;
+}
+
+// Count the data codewords a version holds at level M
+static uint16_t countDataCodewords(uint8_t version)
+{
+    return countRawDataModules(version) / 8 - eccCodewordsPerBlock[version] * eccBlockAmounts[version];
+}
+
+// Append the lowest bits of a value to the buffer
+static void appendBits(QrBitBuffer &buffer, uint32_t value, uint8_t bitAmount)
+{
+    for (int8_t bit = bitAmount - 1; bit >= 0; bit--, buffer.bitLength++)
+    {
+        if ((value >> bit) & 1)
+        {
+            buffer.bytes[buffer.bitLength >> 3] |= 0x80 >> (buffer.bitLength & 7);
+        }
+    }
+}
+
+// Multiply in GF(2^8) modulo x^8 + x^4 + x^3 + x^2 + 1
+static uint8_t multiplyGaloisField(uint8_t x, uint8_t y)
+{
+    uint16_t product = 0;
+    for (int8_t bit = 7; bit >= 0; bit--)
+    {
+        product = (product << 1) ^ ((product >> 7) * 0x11D);
+        product ^= ((y >> bit) & 1) * x;
+    }
+    return product;
+}
+
+// Compute the Reed-Solomon generator polynomial of a degree, without its leading term, highest power first
+static void computeReedSolomonDivisor(uint8_t degree, uint8_t *divisor)
+{
+    memset(divisor, 0, degree);
+    divisor[degree - 1] = 1;
+    uint8_t root = 1;
+    for (uint8_t i = 0; i < degree; i++)
+    {
+        for (uint8_t j = 0; j < degree; j++)
+        {
+            divisor[j] = multiplyGaloisField(divisor[j], root);
+            if (j + 1 < degree)
+            {
+                divisor[j] ^= divisor[j + 1];
+            }
+        }
+        root = multiplyGaloisField(root, 0x02);
+    }
+}
+
+// Compute the error correction codewords of a block, the remainder of its data divided by the generator polynomial
+static void computeReedSolomonRemainder(const uint8_t *data, uint16_t length, const uint8_t *divisor, uint8_t degree, uint8_t *remainder)
+{
+    memset(remainder, 0, degree);
+    for (uint16_t i = 0; i < length; i++)
+    {
+        uint8_t factor = data[i] ^ remainder[0];
+        memmove(remainder, remainder + 1, degree - 1);
+        remainder[degree - 1] = 0;
+        for (uint8_t j = 0; j < degree; j++)
+        {
+            remainder[j] ^= multiplyGaloisField(divisor[j], factor);
+        }
+    }
+}
+
+// Split the data codewords into blocks, add the error correction of each block and interleave them all
+static uint16_t addErrorCorrection(uint8_t version, const uint8_t *data, uint8_t *codewords)
+{
+    uint8_t blockAmount = eccBlockAmounts[version];
+    uint8_t eccLength = eccCodewordsPerBlock[version];
+    uint16_t rawCodewords = countRawDataModules(version) / 8;
+    uint8_t shortBlockAmount = blockAmount - rawCodewords % blockAmount;
+    uint8_t shortBlockDataLength = rawCodewords / blockAmount - eccLength;
+
+    uint8_t divisor[QR_CODE_MAX_BLOCK_ECC_LENGTH];
+    uint8_t ecc[QR_CODE_MAX_BLOCKS][QR_CODE_MAX_BLOCK_ECC_LENGTH];
+    uint16_t blockStarts[QR_CODE_MAX_BLOCKS];
+    computeReedSolomonDivisor(eccLength, divisor);
+    uint16_t blockStart = 0;
+    for (uint8_t block = 0; block < blockAmount; block++)
+    {
+        // The last blocks hold one data codeword more than the short ones
+        uint8_t blockLength = shortBlockDataLength + (block < shortBlockAmount ? 0 : 1);
+        blockStarts[block] = blockStart;
+        computeReedSolomonRemainder(&data[blockStart], blockLength, divisor, eccLength, ecc[block]);
+        blockStart += blockLength;
+    }
+
+    // First the data of every block a codeword at a time, then their error correction the same way
+    uint16_t length = 0;
+    for (uint8_t i = 0; i <= shortBlockDataLength; i++)
+    {
+        for (uint8_t block = 0; block < blockAmount; block++)
+        {
+            if (i < shortBlockDataLength || block >= shortBlockAmount)
+            {
+                codewords[length++] = data[blockStarts[block] + i];
+            }
+        }
+    }
+    for (uint8_t i = 0; i < eccLength; i++)
+    {
+        for (uint8_t block = 0; block < blockAmount; block++)
+        {
+            codewords[length++] = ecc[block][i];
+        }
+    }
+    return length;
+}
+
+// Draw a finder pattern with its separator around a center, cut off at the edges of the code
+static void drawFinderPattern(QrCode &code, QrCode &functionModules, int16_t centerX, int16_t centerY)
+{
+    for (int16_t dy = -4; dy <= 4; dy++)
+    {
+        for (int16_t dx = -4; dx <= 4; dx++)
+        {
+            int16_t x = centerX + dx;
+            int16_t y = centerY + dy;
+            uint8_t distance = max(abs(dx), abs(dy));
+            if (x >= 0 && x < code.size && y >= 0 && y < code.size)
+            {
+                setFunctionModule(code, functionModules, x, y, distance != 2 && distance != 4);
+            }
+        }
+    }
+}
+
+// Draw an alignment pattern around a center
+static void drawAlignmentPattern(QrCode &code, QrCode &functionModules, uint8_t centerX, uint8_t centerY)
+{
+    for (int8_t dy = -2; dy <= 2; dy++)
+    {
+        for (int8_t dx = -2; dx <= 2; dx++)
+        {
+            setFunctionModule(code, functionModules, centerX + dx, centerY + dy, max(abs(dx), abs(dy)) != 1);
+        }
+    }
+}
+
+// Draw both copies of the format information, which tells the scanner the level and mask
+static void drawFormatBits(QrCode &code, QrCode &functionModules, uint8_t mask)
+{
+    uint16_t data = QR_CODE_FORMAT_LEVEL_BITS << 3 | mask;
+    uint16_t remainder = data;
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        remainder = (remainder << 1) ^ ((remainder >> 9) * 0x537);
+    }
+    uint16_t bits = (data << 10 | remainder) ^ 0x5412;
+
+    // Around the finder pattern at the top left
+    for (uint8_t i = 0; i <= 5; i++)
+    {
+        setFunctionModule(code, functionModules, 8, i, (bits >> i) & 1);
+    }
+    setFunctionModule(code, functionModules, 8, 7, (bits >> 6) & 1);
+    setFunctionModule(code, functionModules, 8, 8, (bits >> 7) & 1);
+    setFunctionModule(code, functionModules, 7, 8, (bits >> 8) & 1);
+    for (uint8_t i = 9; i < 15; i++)
+    {
+        setFunctionModule(code, functionModules, 14 - i, 8, (bits >> i) & 1);
+    }
+
+    // Split over the other two finder patterns, with the module that is always dark
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        setFunctionModule(code, functionModules, code.size - 1 - i, 8, (bits >> i) & 1);
+    }
+    for (uint8_t i = 8; i < 15; i++)
+    {
+        setFunctionModule(code, functionModules, 8, code.size - 15 + i, (bits >> i) & 1);
+    }
+    setFunctionModule(code, functionModules, 8, code.size - 8, true);
+}
+
+// Draw the finder, timing and alignment patterns, space for the format and the version information from version 7
+static void drawFunctionPatterns(QrCode &code, QrCode &functionModules, uint8_t version)
+{
+    for (uint8_t i = 0; i < code.size; i++)
+    {
+        setFunctionModule(code, functionModules, 6, i, i % 2 == 0);
+        setFunctionModule(code, functionModules, i, 6, i % 2 == 0);
+    }
+    drawFinderPattern(code, functionModules, 3, 3);
+    drawFinderPattern(code, functionModules, code.size - 4, 3);
+    drawFinderPattern(code, functionModules, 3, code.size - 4);
+
+    // Alignment patterns sit on a grid, except where they would overlap the finder patterns
+    if (version >= 2)
+    {
+        uint8_t alignmentAmount = version / 7 + 2;
+        uint8_t step = (version * 4 + alignmentAmount * 2 + 1) / (alignmentAmount * 2 - 2) * 2;
+        uint8_t positions[QR_CODE_MAX_VERSION / 7 + 2];
+        positions[0] = 6;
+        for (uint8_t i = alignmentAmount - 1, position = code.size - 7; i >= 1; i--, position -= step)
+        {
+            positions[i] = position;
+        }
+        for (uint8_t i = 0; i < alignmentAmount; i++)
+        {
+            for (uint8_t j = 0; j < alignmentAmount; j++)
+            {
+                bool besideFinder = (i == 0 && j == 0) || (i == 0 && j == alignmentAmount - 1) || (i == alignmentAmount - 1 && j == 0);
+                if (!besideFinder)
+                {
+                    drawAlignmentPattern(code, functionModules, positions[i], positions[j]);
+                }
+            }
+        }
+    }
+
+    drawFormatBits(code, functionModules, 0);
+    if (version >= 7)
+    {
+        uint32_t remainder = version;
+        for (uint8_t i = 0; i < 12; i++)
+        {
+            remainder = (remainder << 1) ^ ((remainder >> 11) * 0x1F25);
+        }
+        uint32_t bits = (uint32_t)version << 12 | remainder;
+        for (uint8_t i = 0; i < 18; i++)
+        {
+            bool dark = (bits >> i) & 1;
+            uint8_t a = code.size - 11 + i % 3;
+            uint8_t b = i / 3;
+            setFunctionModule(code, functionModules, a, b, dark);
+            setFunctionModule(code, functionModules, b, a, dark);
+        }
+    }
+}
+
+// Place the codewords in two module wide columns zigzagging up and down from the right, around the function patterns
+static void drawCodewords(QrCode &code, const QrCode &functionModules, const uint8_t *codewords, uint16_t length)
+{
+    uint32_t bit = 0;
+    for (int16_t right = code.size - 1; right >= 1; right -= 2)
+    {
+        // The vertical timing pattern takes a whole column
+        if (right == 6)
+        {
+            right = 5;
+        }
+        bool upward = ((right + 1) & 2) == 0;
+        for (uint8_t vertical = 0; vertical < code.size; vertical++)
+        {
+            uint8_t y = upward ? code.size - 1 - vertical : vertical;
+            for (uint8_t j = 0; j < 2; j++)
+            {
+                uint8_t x = right - j;
+                if (!isQrCodeModuleDark(functionModules, x, y) && bit < length * 8u)
+                {
+                    setQrModule(code, x, y, (codewords[bit >> 3] >> (7 - (bit & 7))) & 1);
+                    bit++;
+                }
+            }
+        }
+    }
+}
+
+// Flip the data modules a mask pattern selects, applying the same mask again undoes it
+static void applyMask(QrCode &code, const QrCode &functionModules, uint8_t mask)
+{
+    for (uint8_t y = 0; y < code.size; y++)
+    {
+        for (uint8_t x = 0; x < code.size; x++)
+        {
+            bool flip;
+            switch (mask)
+            {
+            case 0:
+                flip = (x + y) % 2 == 0;
+                break;
+            case 1:
+                flip = y % 2 == 0;
+                break;
+            case 2:
+                flip = x % 3 == 0;
+                break;
+            case 3:
+                flip = (x + y) % 3 == 0;
+                break;
+            case 4:
+                flip = (x / 3 + y / 2) % 2 == 0;
+                break;
+            case 5:
+                flip = x * y % 2 + x * y % 3 == 0;
+                break;
+            case 6:
+                flip = (x * y % 2 + x * y % 3) % 2 == 0;
+                break;
+            default:
+                flip = ((x + y) % 2 + x * y % 3) % 2 == 0;
+                break;
+            }
+            if (flip && !isQrCodeModuleDark(functionModules, x, y))
+            {
+                code.modules[y][x >> 3] ^= 1 << (x & 7);
+            }
+        }
+    }
+}
+
+// Push the length of a finished run into the history of the latest runs, a first light run also covers the light border
+static void addRunToHistory(uint16_t runLength, uint16_t *runHistory, uint8_t size)
+{
+    if (runHistory[0] == 0)
+    {
+        runLength += size;
+    }
+    memmove(&runHistory[1], &runHistory[0], 6 * sizeof(uint16_t));
+    runHistory[0] = runLength;
+}
+
+// Count the finder-like patterns, dark-light-dark-dark-dark-light-dark at 1:1:3:1:1 with light on either side, the history ends in
+static uint8_t countFinderLikePatterns(const uint16_t *runHistory)
+{
+    uint16_t unit = runHistory[1];
+    bool core = unit > 0 && runHistory[2] == unit && runHistory[3] == unit * 3 && runHistory[4] == unit && runHistory[5] == unit;
+    return (core && runHistory[0] >= unit * 4 && runHistory[6] >= unit ? 1 : 0) + (core && runHistory[6] >= unit * 4 && runHistory[0] >= unit ? 1 : 0);
+}
+
+// Score a row or column, given as a module lookup along it, for long runs and finder-like patterns
+template <typename ModuleAt>
+static uint32_t scoreLine(uint8_t size, ModuleAt moduleAt)
+{
+    uint32_t penalty = 0;
+    bool runDark = false;
+    uint16_t runLength = 0;
+    uint16_t runHistory[7] = {};
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (moduleAt(i) == runDark)
+        {
+            runLength++;
+            if (runLength == 5)
+            {
+                penalty += QR_CODE_PENALTY_RUN;
+            }
+            else if (runLength > 5)
+            {
+                penalty++;
+            }
+        }
+        else
+        {
+            addRunToHistory(runLength, runHistory, size);
+            if (!runDark)
+            {
+                penalty += countFinderLikePatterns(runHistory) * QR_CODE_PENALTY_FINDER;
+            }
+            runDark = !runDark;
+            runLength = 1;
+        }
+    }
+
+    // The light border past the end closes the last runs
+    if (runDark)
+    {
+        addRunToHistory(runLength, runHistory, size);
+        runLength = 0;
+    }
+    addRunToHistory(runLength + size, runHistory, size);
+    return penalty + countFinderLikePatterns(runHistory) * QR_CODE_PENALTY_FINDER;
+}
+
+// Score how hard a masked code is to scan, lower is better
+static uint32_t scoreMaskedCode(const QrCode &code)
+{
+    uint32_t penalty = 0;
+    for (uint8_t i = 0; i < code.size; i++)
+    {
+        penalty += scoreLine(code.size, [&code, i](uint8_t x) { return isQrCodeModuleDark(code, x, i); });
+        penalty += scoreLine(code.size, [&code, i](uint8_t y) { return isQrCodeModuleDark(code, i, y); });
+    }
+
+    uint32_t darkAmount = 0;
+    for (uint8_t y = 0; y < code.size; y++)
+    {
+        for (uint8_t x = 0; x < code.size; x++)
+        {
+            bool dark = isQrCodeModuleDark(code, x, y);
+            darkAmount += dark;
+            if (x + 1 < code.size && y + 1 < code.size && dark == isQrCodeModuleDark(code, x + 1, y) && dark == isQrCodeModuleDark(code, x, y + 1) &&
+                dark == isQrCodeModuleDark(code, x + 1, y + 1))
+            {
+                penalty += QR_CODE_PENALTY_BLOCK;
+            }
+        }
+    }
+    uint32_t total = (uint32_t)code.size * code.size;
+    uint32_t balanceSteps = (abs((int32_t)(darkAmount * 20) - (int32_t)(total * 10)) + total - 1) / total - 1;
+    return penalty + balanceSteps * QR_CODE_PENALTY_BALANCE;
+}
+
+// Fill a span of a pixel row, cut off to the columns that may be drawn in
+static void fillPixelSpan(uint8_t *row, int16_t start, int16_t end, int16_t left, int16_t right, uint8_t index)
+{
+    start = max(start, left);
+    end = min(end, right);
+    fillIndexedPixels(row, start, end - start, index);
+}
+
+// ===== Functions Implementations =====
+
+bool encodeQrCode(const char *text, size_t length, QrCode &code)
+{
+    code.size = 0;
+
+    // The smallest version whose data codewords hold the mode, the length and the text
+    uint8_t version = QR_CODE_MIN_VERSION;
+    while (version <= QR_CODE_MAX_VERSION && 4 + (version <= 9 ? 8 : 16) + length * 8 > countDataCodewords(version) * 8u)
+    {
+        version++;
+    }
+    if (version > QR_CODE_MAX_VERSION)
+    {
+        return false;
+    }
+
+    uint8_t data[QR_CODE_MAX_CODEWORDS] = {};
+    uint16_t dataLength = countDataCodewords(version);
+    QrBitBuffer buffer = {data, 0};
+    appendBits(buffer, QR_CODE_MODE_BYTE, 4);
+    appendBits(buffer, length, version <= 9 ? 8 : 16);
+    for (size_t i = 0; i < length; i++)
+    {
+        appendBits(buffer, (uint8_t)text[i], 8);
+    }
+
+    // A terminator of up to four zero bits, then whole bytes of padding
+    buffer.bitLength = min((uint16_t)(buffer.bitLength + 4), (uint16_t)(dataLength * 8));
+    buffer.bitLength = (buffer.bitLength + 7) & ~7;
+    for (uint8_t pad = QR_CODE_PAD_FIRST; buffer.bitLength < dataLength * 8; pad ^= QR_CODE_PAD_FIRST ^ QR_CODE_PAD_SECOND)
+    {
+        appendBits(buffer, pad, 8);
+    }
+
+    uint8_t codewords[QR_CODE_MAX_CODEWORDS];
+    uint16_t codewordAmount = addErrorCorrection(version, data, codewords);
+
+    code.size = 17 + 4 * version;
+    memset(code.modules, 0, sizeof(code.modules));
+    QrCode functionModules;
+    functionModules.size = code.size;
+    memset(functionModules.modules, 0, sizeof(functionModules.modules));
+    drawFunctionPatterns(code, functionModules, version);
+    drawCodewords(code, functionModules, codewords, codewordAmount);
+
+    // Try every mask and keep the one that scores best
+    uint8_t bestMask = 0;
+    uint32_t bestPenalty = UINT32_MAX;
+    for (uint8_t mask = 0; mask < QR_CODE_MASK_AMOUNT; mask++)
+    {
+        applyMask(code, functionModules, mask);
+        drawFormatBits(code, functionModules, mask);
+        uint32_t penalty = scoreMaskedCode(code);
+        if (penalty < bestPenalty)
+        {
+            bestPenalty = penalty;
+            bestMask = mask;
+        }
+        applyMask(code, functionModules, mask);
+    }
+    applyMask(code, functionModules, bestMask);
+    drawFormatBits(code, functionModules, bestMask);
+    return true;
+}
+
+bool isQrCodeModuleDark(const QrCode &code, uint8_t x, uint8_t y)
+{
+    return (code.modules[y][x >> 3] >> (x & 7)) & 1;
+}
+
+int16_t qrCodePixelSize(const QrCode &code, uint8_t scale)
+{
+    return (code.size + 2 * QR_CODE_QUIET_ZONE) * scale;
+}
+
+void blitQrCode(uint8_t *framebuffer, int16_t width, int16_t height, int16_t x, int16_t y, const QrCode &code, uint8_t scale, uint8_t darkIndex, uint8_t lightIndex)
+{
+    int16_t pixelSize = qrCodePixelSize(code, scale);
+    int16_t left = max(x, (int16_t)0);
+    int16_t right = min((int16_t)(x + pixelSize), width);
+    if (code.size == 0 || right <= left)
+    {
+        return;
+    }
+
+    int16_t modulesX = x + QR_CODE_QUIET_ZONE * scale;
+    for (int16_t moduleRow = -QR_CODE_QUIET_ZONE; moduleRow < code.size + QR_CODE_QUIET_ZONE; moduleRow++)
+    {
+        int16_t rowTop = y + (moduleRow + QR_CODE_QUIET_ZONE) * scale;
+        int16_t firstRow = max(rowTop, (int16_t)0);
+        int16_t endRow = min((int16_t)(rowTop + scale), height);
+        if (firstRow >= endRow)
+        {
+            continue;
+        }
+
+        // Expand the module row into its first pixel row a run of same colored modules at a time
+        uint8_t *row = &framebuffer[firstRow * INDEXED_CANVAS_ROW_BYTES(width)];
+        if (moduleRow < 0 || moduleRow >= code.size)
+        {
+            fillPixelSpan(row, x, x + pixelSize, left, right, lightIndex);
+        }
+        else
+        {
+            fillPixelSpan(row, x, modulesX, left, right, lightIndex);
+            uint8_t runStart = 0;
+            for (uint8_t column = 1; column <= code.size; column++)
+            {
+                bool runDark = isQrCodeModuleDark(code, runStart, moduleRow);
+                if (column == code.size || isQrCodeModuleDark(code, column, moduleRow) != runDark)
+                {
+                    fillPixelSpan(row, modulesX + runStart * scale, modulesX + column * scale, left, right, runDark ? darkIndex : lightIndex);
+                    runStart = column;
+                }
+            }
+            fillPixelSpan(row, modulesX + code.size * scale, x + pixelSize, left, right, lightIndex);
+        }
+
+        // The other pixel rows of the module row are the same
+        for (int16_t copyRow = firstRow + 1; copyRow < endRow; copyRow++)
+        {
+            copyIndexedPixels(&framebuffer[copyRow * INDEXED_CANVAS_ROW_BYTES(width)], row, left, right - left);
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#include "storage_benchmark.h"
+
+#ifdef STORAGE_BENCHMARK_ENABLED
+
+#include "storage_hal.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+// ===== Internal Helpers =====
+
+// Microseconds from a free running clock, the real time also on the host where millis() follows the virtual clock
+static uint32_t readBenchmarkClock()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    return (uint32_t)esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Next number of a xorshift sequence, enough to spread reads over a file
+static uint32_t nextRandom(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Print the throughput of reading an amount of bytes in some time, and the time per read when they were read at random places
+static void printBenchmarkResult(const char *name, uint64_t byteAmount, uint32_t duration, uint32_t readAmount)
+{
+    duration = max(duration, (uint32_t)1);
+    Serial.printf("  %-24s %8llu bytes %10lu us %8lu kB/s", name, (unsigned long long)byteAmount, (unsigned long)duration,
+                  (unsigned long)(byteAmount * 1000000 / 1024 / duration));
+    if (readAmount > 0)
+    {
+        Serial.printf(" %8lu us per read", (unsigned long)(duration / readAmount));
+    }
+    Serial.printf("\r\n");
+}
+
+// Find the largest file of a directory, the benchmark needs one larger than the read ahead to mean anything
+static String findLargestFile(fs::FS &fs, const char *dirname, uint32_t &fileSize)
+{
+    String path;
+    fileSize = 0;
+    File root = fs.open(dirname);
+    if (!root || !root.isDirectory())
+    {
+        return path;
+    }
+    File file = root.openNextFile();
+    while (file)
+    {
+        if (!file.isDirectory() && file.size() > fileSize)
+        {
+            fileSize = file.size();
+            path = file.path();
+        }
+        file = root.openNextFile();
+    }
+    return path;
+}
+
+// Read the start of a file in order, a sector at a time through a file opened the way any file is
+static void benchmarkSequentialSectors(fs::FS &fs, const String &path, uint32_t length, uint8_t *buffer)
+{
+    File file = fs.open(path);
+    if (!file)
+    {
+        return;
+    }
+    uint64_t byteAmount = 0;
+    uint32_t start = readBenchmarkClock();
+    while (byteAmount < length)
+    {
+        size_t readAmount = file.read(buffer, STORAGE_SECTOR_SIZE);
+        if (readAmount == 0)
+        {
+            break;
+        }
+        byteAmount += readAmount;
+    }
+    printBenchmarkResult("sequential sectors", byteAmount, readBenchmarkClock() - start, 0);
+}
+
+// Read the start of a file in order through a stream reader
+static void benchmarkSequentialStream(fs::FS &fs, const String &path, uint32_t length, uint8_t *buffer)
+{
+    StreamReader reader;
+    if (openStreamReaderRange(fs, path, 0, length, buffer, STREAM_READER_BUFFER_SIZE, reader) != StorageError::NONE)
+    {
+        return;
+    }
+    uint64_t byteAmount = 0;
+    uint32_t start = readBenchmarkClock();
+    const uint8_t *data;
+    size_t dataLength;
+    while (readStreamChunk(reader, data, dataLength) == StorageError::NONE)
+    {
+        byteAmount += dataLength;
+    }
+    printBenchmarkResult("sequential stream", byteAmount, readBenchmarkClock() - start, 0);
+    closeStreamReader(reader);
+}
+
+// Read single sectors at random places in a file
+static void benchmarkRandomSectors(fs::FS &fs, const String &path, uint32_t fileSize, uint8_t *buffer)
+{
+    File file = fs.open(path);
+    if (!file)
+    {
+        return;
+    }
+    uint32_t sectorAmount = max(fileSize / STORAGE_SECTOR_SIZE, (uint32_t)1);
+    uint32_t state = STORAGE_BENCHMARK_SEED;
+    uint64_t byteAmount = 0;
+    uint32_t start = readBenchmarkClock();
+    for (uint16_t i = 0; i < STORAGE_BENCHMARK_RANDOM_READ_AMOUNT; i++)
+    {
+        if (!file.seek((nextRandom(state) % sectorAmount) * STORAGE_SECTOR_SIZE))
+        {
+            break;
+        }
+        byteAmount += file.read(buffer, STORAGE_SECTOR_SIZE);
+    }
+    printBenchmarkResult("random sectors", byteAmount, readBenchmarkClock() - start, STORAGE_BENCHMARK_RANDOM_READ_AMOUNT);
+}
+
+// Read whole blocks at random places in a file through a stream reader, the places are the same as for the sectors
+static void benchmarkRandomStream(fs::FS &fs, const String &path, uint32_t fileSize, uint8_t *buffer)
+{
+    StreamReader reader;
+    if (openStreamReader(fs, path, buffer, STREAM_READER_BUFFER_SIZE, reader) != StorageError::NONE)
+    {
+        return;
+    }
+    uint32_t sectorAmount = max(fileSize / STORAGE_SECTOR_SIZE, (uint32_t)1);
+    uint32_t state = STORAGE_BENCHMARK_SEED;
+    uint64_t byteAmount = 0;
+    uint32_t start = readBenchmarkClock();
+    const uint8_t *data;
+    size_t dataLength;
+    for (uint16_t i = 0; i < STORAGE_BENCHMARK_RANDOM_READ_AMOUNT; i++)
+    {
+        uint32_t position = (nextRandom(state) % sectorAmount) * STORAGE_SECTOR_SIZE;
+        if (seekStreamReader(reader, position - position % STREAM_READER_BLOCK_SIZE) != StorageError::NONE ||
+            readStreamChunk(reader, data, dataLength) != StorageError::NONE)
+        {
+            break;
+        }
+        byteAmount += dataLength;
+    }
+    printBenchmarkResult("random stream blocks", byteAmount, readBenchmarkClock() - start, STORAGE_BENCHMARK_RANDOM_READ_AMOUNT);
+    closeStreamReader(reader);
+}
+
+// ===== Functions Implementations =====
+
+void runStorageBenchmark(fs::FS &fs, const char *dirname)
+{
+    uint32_t fileSize;
+    String path = findLargestFile(fs, dirname, fileSize);
+    if (path.length() == 0)
+    {
+        Serial.printf("Storage benchmark: no file to read in %s\r\n", dirname);
+        return;
+    }
+    uint8_t *buffer = allocateReadBuffer(STREAM_READER_BUFFER_SIZE);
+    if (!buffer)
+    {
+        Serial.printf("Storage benchmark: no memory for the read buffer\r\n");
+        return;
+    }
+
+    uint32_t sequentialLength = min(fileSize, (uint32_t)STORAGE_BENCHMARK_SEQUENTIAL_SIZE);
+    Serial.printf("Storage benchmark: %s, %lu bytes, bus at %lu MHz\r\n", path.c_str(), (unsigned long)fileSize,
+                  (unsigned long)(storageBusFrequency() / 1000000));
+    benchmarkSequentialSectors(fs, path, sequentialLength, buffer);
+    benchmarkSequentialStream(fs, path, sequentialLength, buffer);
+    benchmarkRandomSectors(fs, path, fileSize, buffer);
+    benchmarkRandomStream(fs, path, fileSize, buffer);
+    free(buffer);
+}
+
+#endif
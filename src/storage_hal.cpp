@@ -1,8 +1,202 @@
 #include "storage_hal.h"
+#include "compressed_text.h"
 
 // ===== Storage Configuration =====
 
 static SPIClass SPIStorage(HSPI);
+static uint32_t storageFrequency = 0;
+
+// ===== Internal Helpers =====
+
+// Mount the card at a bus clock and read its first sector, which ends in the boot signature whether it holds a partition
+// table or the boot sector of the file system. The read goes through the CRC checks of the card's transfers at that clock
+static bool mountStorage(uint32_t frequency)
+{
+    if (!SD.begin(STORAGE_CS, SPIStorage, frequency))
+    {
+        return false;
+    }
+    uint8_t sector[STORAGE_SECTOR_SIZE];
+    File root = SD.open("/");
+    if (!root || !root.isDirectory() || !SD.readRAW(sector, 0) || sector[STORAGE_SECTOR_SIZE - 2] != 0x55 || sector[STORAGE_SECTOR_SIZE - 1] != 0xAA)
+    {
+        SD.end();
+        return false;
+    }
+    return true;
+}
+
+// Split the buffer of a reader into slots of a block each, all of them empty
+static void startStreamSlots(StreamReader &reader, size_t slotSize)
+{
+    reader.slotSize = slotSize;
+    reader.slotAmount = min(reader.bufferSize / slotSize, (size_t)STREAM_READER_CACHE_BLOCK_AMOUNT);
+    reader.nextSlot = 0;
+    reader.readAheadBlock = UINT32_MAX;
+    for (uint32_t &block : reader.slotBlocks)
+    {
+        block = UINT32_MAX;
+    }
+}
+
+// Get the block of the file a stream position is in. The blocks of a plain file start at multiples of the block size in the
+// file, so they cover whole sectors also when the stream is a part of the file
+static uint32_t streamBlock(const StreamReader &reader, uint32_t position)
+{
+    if (reader.blockSize > 0)
+    {
+        return position / reader.blockSize;
+    }
+    return ((uint64_t)reader.rangeStart + position) / reader.slotSize;
+}
+
+// Get the stream position a block starts at, the first block of a part of a file starts with the part
+static uint32_t streamBlockStart(const StreamReader &reader, uint32_t block)
+{
+    if (reader.blockSize > 0)
+    {
+        return block * reader.blockSize;
+    }
+    uint64_t fileOffset = (uint64_t)block * reader.slotSize;
+    return fileOffset > reader.rangeStart ? min(fileOffset - reader.rangeStart, (uint64_t)UINT32_MAX) : 0;
+}
+
+// Get where the bytes of the block in a slot are, the first block of a part of a file is kept where it would be in the file
+static uint8_t *slotData(const StreamReader &reader, uint8_t slot)
+{
+    uint32_t skipped = 0;
+    if (reader.blockSize == 0 && (uint64_t)reader.slotBlocks[slot] * reader.slotSize < reader.rangeStart)
+    {
+        skipped = reader.rangeStart % reader.slotSize;
+    }
+    return &reader.buffer[slot * reader.slotSize + skipped];
+}
+
+// Find the slot holding a block, -1 when it was not read or was pushed out since
+static int8_t findStreamSlot(const StreamReader &reader, uint32_t block)
+{
+    for (uint8_t slot = 0; slot < reader.slotAmount; slot++)
+    {
+        if (reader.slotBlocks[slot] == block)
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// Read blocks of a plain file into slots next to each other with a single read, so the card gets one multi-sector read for
+// all of them. The file is only moved when the read does not continue where the last one ended
+static StorageError readStreamBlocks(StreamReader &reader, uint32_t block, uint8_t blockAmount, uint8_t &slot)
+{
+    if (reader.nextSlot + blockAmount > reader.slotAmount)
+    {
+        reader.nextSlot = 0;
+    }
+    slot = reader.nextSlot;
+    reader.nextSlot = (slot + blockAmount) % reader.slotAmount;
+    for (uint8_t i = 0; i < blockAmount; i++)
+    {
+        reader.slotBlocks[slot + i] = UINT32_MAX;
+    }
+
+    uint32_t start = streamBlockStart(reader, block);
+    uint32_t end = min(streamBlockStart(reader, block + blockAmount), reader.rangeLength);
+    if (block != reader.readAheadBlock && !reader.file.seek(reader.rangeStart + start))
+    {
+        reader.readAheadBlock = UINT32_MAX;
+        return StorageError::SEEK_FAILED;
+    }
+    reader.slotBlocks[slot] = block;
+    size_t readAmount = reader.file.read(slotData(reader, slot), end - start);
+    reader.readAheadBlock = readAmount == end - start ? block + blockAmount : UINT32_MAX;
+    if (readAmount == 0)
+    {
+        reader.slotBlocks[slot] = UINT32_MAX;
+        return StorageError::END_OF_FILE;
+    }
+
+    // A read that came up short at the end of the file leaves the slots after it empty
+    for (uint8_t i = 0; i < blockAmount; i++)
+    {
+        uint32_t blockStart = streamBlockStart(reader, block + i) - start;
+        if (blockStart >= readAmount)
+        {
+            break;
+        }
+        reader.slotBlocks[slot + i] = block + i;
+        reader.slotLengths[slot + i] = min(streamBlockStart(reader, block + i + 1) - start, (uint32_t)readAmount) - blockStart;
+    }
+    return StorageError::NONE;
+}
+
+// Decompress a block of a compressed stream into the next slot
+static StorageError readCompressedStreamBlock(StreamReader &reader, uint32_t block, uint8_t &slot)
+{
+    slot = reader.nextSlot;
+    reader.nextSlot = (slot + 1) % reader.slotAmount;
+    reader.slotBlocks[slot] = UINT32_MAX;
+    size_t textLength;
+    StorageError error = decompressTextBlock(reader.file, reader.blockSize, reader.rangeLength, block, &reader.buffer[slot * reader.slotSize], textLength);
+    if (error != StorageError::NONE)
+    {
+        return error;
+    }
+    reader.slotBlocks[slot] = block;
+    reader.slotLengths[slot] = textLength;
+    return StorageError::NONE;
+}
+
+// Make the block holding the next position of the stream the one being read, once everything before that position in it has
+// been read. After a seek the position can be anywhere in the block. Blocks still in a slot are not read again
+static StorageError refillStreamBuffer(StreamReader &reader)
+{
+    if (reader.inMemory)
+    {
+        return reader.bufferPosition < reader.bufferLength ? StorageError::NONE : StorageError::END_OF_FILE;
+    }
+    if (!reader.file)
+    {
+        return StorageError::READ_FAILED;
+    }
+    if (reader.bufferPosition < reader.bufferLength)
+    {
+        return StorageError::NONE;
+    }
+
+    uint32_t position = reader.bufferStart + reader.bufferPosition;
+    if (position >= reader.rangeLength)
+    {
+        return StorageError::END_OF_FILE;
+    }
+    uint32_t block = streamBlock(reader, position);
+    int8_t slot = findStreamSlot(reader, block);
+    if (slot < 0)
+    {
+        // Reading on where the last read ended means the file is read in order, so the blocks after it are read along
+        uint8_t readSlot;
+        StorageError error;
+        if (reader.blockSize > 0)
+        {
+            error = readCompressedStreamBlock(reader, block, readSlot);
+        }
+        else
+        {
+            error = readStreamBlocks(reader, block, block == reader.readAheadBlock ? min((uint8_t)STREAM_READER_READ_AHEAD_AMOUNT, reader.slotAmount) : 1, readSlot);
+        }
+        if (error != StorageError::NONE)
+        {
+            return error;
+        }
+        slot = readSlot;
+    }
+
+    reader.bufferData = slotData(reader, slot);
+    reader.bufferStart = streamBlockStart(reader, block);
+    reader.bufferLength = reader.slotLengths[slot];
+    reader.bufferPosition = position - reader.bufferStart;
+    return reader.bufferPosition < reader.bufferLength ? StorageError::NONE : StorageError::END_OF_FILE;
+}
 
 // ===== Functions Implementations =====
 
@@ -11,11 +205,24 @@ bool initializeStorage()
     // Initialize the SPI communication bus
     SPIStorage.begin(STORAGE_SCK, STORAGE_MISO, STORAGE_MOSI, STORAGE_CS);
 
-    if (!SD.begin(STORAGE_CS, SPIStorage))
+    // Long wires and some cards do not keep up with the fastest clock, every step down halves it
+    for (uint32_t frequency = STORAGE_SPI_FREQUENCY;; frequency = max(frequency / 2, (uint32_t)STORAGE_SPI_MIN_FREQUENCY))
     {
-        return false;
+        if (mountStorage(frequency))
+        {
+            storageFrequency = frequency;
+            return true;
+        }
+        if (frequency <= STORAGE_SPI_MIN_FREQUENCY)
+        {
+            return false;
+        }
     }
-    return true;
+}
+
+uint32_t storageBusFrequency()
+{
+    return storageFrequency;
 }
 
 bool checkIfSDMounted()
@@ -47,85 +254,256 @@ String determineSDCardType()
     }
 }
 
-std::array<uint64_t, 3> getSDCardStats()
+std::array<uint64_t, 2> getSDCardStats()
 {
     uint64_t cardSize = SD.cardSize() / (1024 * 1024);
     uint64_t totalSpace = SD.totalBytes() / (1024 * 1024);
-    uint64_t usedSpace = SD.usedBytes() / (1024 * 1024);
 
-    return {cardSize, totalSpace, usedSpace};
+    return {cardSize, totalSpace};
+}
+
+uint64_t getSDCardUsedSpace()
+{
+    return SD.usedBytes() / (1024 * 1024);
+}
+
+uint8_t *allocateReadBuffer(size_t size)
+{
+    uint8_t *buffer = (uint8_t *)ps_malloc(size);
+    if (!buffer)
+    {
+        buffer = (uint8_t *)malloc(size);
+    }
+    return buffer;
+}
+
+const char *storageErrorToString(StorageError error)
+{
+    switch (error)
+    {
+    case StorageError::NONE:
+        return "OK";
+    case StorageError::OPEN_FAILED:
+        return "OPEN FAILED";
+    case StorageError::NOT_A_DIRECTORY:
+        return "NOT A DIRECTORY";
+    case StorageError::READ_FAILED:
+        return "READ FAILED";
+    case StorageError::SEEK_FAILED:
+        return "SEEK FAILED";
+    case StorageError::END_OF_FILE:
+        return "END OF FILE";
+    case StorageError::BAD_FORMAT:
+        return "BAD FORMAT";
+    case StorageError::CHECKSUM_MISMATCH:
+        return "CHECKSUM MISMATCH";
+    case StorageError::WRITE_FAILED:
+        return "WRITE FAILED";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+File openStorageFile(fs::FS &fs, const String &path)
+{
+    File file = fs.open(path);
+#if defined(ARDUINO_ARCH_ESP32) && defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+    // The default read buffer of a file is 128 bytes, which splits every read into reads of single sectors. Only the
+    // 3.x core can change it, with the 2.x core a block still reaches the card a sector at a time
+    if (file)
+    {
+        file.setBufferSize(STREAM_READER_BLOCK_SIZE);
+    }
+#endif
+    return file;
 }
 
-std::array<Topic, MAXIMUM_FILE_AMOUNT> assembleTopicsFromDirectory(fs::FS &fs, const char *dirname)
+StorageError openStreamReader(fs::FS &fs, String path, uint8_t *buffer, size_t bufferSize, StreamReader &reader)
 {
-    std::array<Topic, MAXIMUM_FILE_AMOUNT> resultArray;
-    uint8_t arrayPosition = 0;
+    return openStreamReaderRange(fs, path, 0, UINT32_MAX, buffer, bufferSize, reader);
+}
 
-    File root = fs.open(dirname);
-    if (!root) // TODO: fix by passing an error to the main and filling the array through a pointer
+StorageError openStreamReaderRange(fs::FS &fs, String path, uint32_t rangeStart, uint32_t rangeLength, uint8_t *buffer, size_t bufferSize, StreamReader &reader)
+{
+    closeStreamReader(reader);
+    reader.buffer = buffer;
+    reader.bufferSize = bufferSize;
+    reader.rangeStart = rangeStart;
+    reader.rangeLength = rangeLength;
+
+    if (!buffer || bufferSize == 0)
+    {
+        return StorageError::READ_FAILED;
+    }
+    reader.file = openStorageFile(fs, path);
+    if (!reader.file)
     {
-        Topic errorFeedbackTopic = Topic();
-        errorFeedbackTopic.textFileName = "-1";
-        errorFeedbackTopic.name = "Open Directory";
-        resultArray[0] = errorFeedbackTopic;
+        return StorageError::OPEN_FAILED;
+    }
+    // The file is moved to the part with the first read, walking the cluster chain of a large file only once
+    startStreamSlots(reader, min(bufferSize, (size_t)STREAM_READER_BLOCK_SIZE));
+    return StorageError::NONE;
+}
+
+StorageError openCompressedStreamReader(fs::FS &fs, String path, uint8_t *buffer, size_t bufferSize, StreamReader &reader)
+{
+    closeStreamReader(reader);
+    reader.buffer = buffer;
+    reader.bufferSize = bufferSize;
+    reader.rangeStart = 0;
 
-        return resultArray;
+    if (!buffer || bufferSize == 0)
+    {
+        return StorageError::READ_FAILED;
+    }
+    reader.file = openStorageFile(fs, path);
+    if (!reader.file)
+    {
+        return StorageError::OPEN_FAILED;
+    }
+    CompressedTextHeader header;
+    StorageError error = readCompressedTextHeader(reader.file, header);
+    if (error == StorageError::NONE && header.blockSize > bufferSize)
+    {
+        // The buffer is all the memory decompression gets, so a whole block has to fit in it
+        error = StorageError::BAD_FORMAT;
     }
-    if (!root.isDirectory())
+    if (error != StorageError::NONE)
     {
-        Topic errorFeedbackTopic = Topic();
-        errorFeedbackTopic.textFileName = "-2";
-        errorFeedbackTopic.name = "Specified path is not a directory!";
-        resultArray[0] = errorFeedbackTopic;
+        reader.file.close();
+        return error;
+    }
+    reader.rangeLength = header.textSize;
+    reader.blockSize = header.blockSize;
+    startStreamSlots(reader, header.blockSize);
+    return StorageError::NONE;
+}
+
+void openMemoryStreamReader(const uint8_t *data, size_t length, StreamReader &reader)
+{
+    closeStreamReader(reader);
+    // The reader only writes into its buffer when refilling it from a file, which a memory stream never does
+    reader.buffer = (uint8_t *)data;
+    reader.bufferSize = length;
+    reader.bufferData = data;
+    reader.bufferLength = length;
+    reader.rangeStart = 0;
+    reader.rangeLength = length;
+    reader.inMemory = true;
+}
 
-        return resultArray;
+void closeStreamReader(StreamReader &reader)
+{
+    reader.file.close();
+    reader.inMemory = false;
+    reader.blockSize = 0;
+    reader.bufferData = nullptr;
+    reader.bufferStart = 0;
+    reader.bufferLength = 0;
+    reader.bufferPosition = 0;
+    reader.slotAmount = 0;
+}
+
+StorageError readStreamChunk(StreamReader &reader, const uint8_t *&data, size_t &length)
+{
+    StorageError error = refillStreamBuffer(reader);
+    if (error != StorageError::NONE)
+    {
+        return error;
     }
 
-    File file = root.openNextFile();
-    while (file)
+    data = &reader.bufferData[reader.bufferPosition];
+    length = reader.bufferLength - reader.bufferPosition;
+    reader.bufferPosition = reader.bufferLength;
+    return StorageError::NONE;
+}
+
+StorageError readStream(StreamReader &reader, uint8_t *destination, size_t length, size_t &readAmount)
+{
+    readAmount = 0;
+    while (readAmount < length)
     {
-        if (!file.isDirectory())
+        StorageError error = refillStreamBuffer(reader);
+        if (error != StorageError::NONE)
         {
-            String stringName = (String)file.name();
-            if (stringName.endsWith(".txt"))
-            {
-                auto newTopic = Topic();
-                newTopic.name = stringName.substring(0, stringName.indexOf(".txt"));
-                newTopic.textFileName = file.name();
-                resultArray[arrayPosition] = newTopic;
-                arrayPosition++;
-            }
+            return readAmount > 0 && error == StorageError::END_OF_FILE ? StorageError::NONE : error;
         }
-        file = root.openNextFile();
+
+        size_t copyAmount = min(length - readAmount, reader.bufferLength - reader.bufferPosition);
+        memcpy(&destination[readAmount], &reader.bufferData[reader.bufferPosition], copyAmount);
+        reader.bufferPosition += copyAmount;
+        readAmount += copyAmount;
     }
-    return resultArray;
+    return StorageError::NONE;
 }
 
-uint8_t countAvailableTopics(std::array<Topic, MAXIMUM_FILE_AMOUNT> topicsArray)
+StorageError readStreamLine(StreamReader &reader, char *line, size_t lineSize, size_t &lineLength)
 {
-    // If the array is not completely filled, return the found index where it is empty, this is then the count of filled objects
-    for (uint8_t i = 0; i < MAXIMUM_FILE_AMOUNT; i++)
+    lineLength = 0;
+    bool readAnything = false;
+    while (true)
     {
-        if (topicsArray[i].textFileName.isEmpty())
+        StorageError error = refillStreamBuffer(reader);
+        if (error == StorageError::END_OF_FILE && readAnything)
         {
-            return i;
+            break;
+        }
+        if (error != StorageError::NONE)
+        {
+            line[0] = '\0';
+            return error;
         }
-    }
 
-    return MAXIMUM_FILE_AMOUNT;
+        char character = reader.bufferData[reader.bufferPosition++];
+        readAnything = true;
+        if (character == '\n')
+        {
+            break;
+        }
+        if (character != '\r' && lineLength < lineSize - 1)
+        {
+            line[lineLength++] = character;
+        }
+    }
+    line[lineLength] = '\0';
+    return StorageError::NONE;
 }
 
-String readFile(fs::FS &fs, String path)
+StorageError seekStreamReader(StreamReader &reader, uint32_t position)
 {
-    // Open up the file, and if the file does not want to open, return -1 to indicate error
-    File file = fs.open(path);
-    if (!file)
+    if (reader.inMemory)
+    {
+        if (position > reader.bufferLength)
+        {
+            return StorageError::SEEK_FAILED;
+        }
+        reader.bufferPosition = position;
+        return StorageError::NONE;
+    }
+    if (!reader.file)
+    {
+        return StorageError::SEEK_FAILED;
+    }
+
+    // Positions already in the block being read need no access to the card at all
+    if (position >= reader.bufferStart && position < reader.bufferStart + reader.bufferLength)
     {
-        return "-1";
+        reader.bufferPosition = position - reader.bufferStart;
+        return StorageError::NONE;
     }
-    // Read the actual file contents
-    String completeFileContents = file.readString();
-    file.close();
 
-    return completeFileContents;
+    // The block of the position is found when the stream refills, in a slot or on the card, and the file is only moved then
+    if (position > reader.rangeLength)
+    {
+        return StorageError::SEEK_FAILED;
+    }
+    reader.bufferStart = position;
+    reader.bufferLength = 0;
+    reader.bufferPosition = 0;
+    return StorageError::NONE;
+}
+
+uint32_t streamReaderPosition(const StreamReader &reader)
+{
+    return reader.bufferStart + reader.bufferPosition;
 }
@@ -0,0 +1,591 @@
+#include "text_layout.h"
+#include "frame_timing.h"
+
+#include <algorithm>
+
+// ===== Struct Definitions =====
+
+// Where wrapping is in the text, and where the lines on screen it passes go to
+struct LineWrapper
+{
+    uint8_t lineWidth;
+    uint8_t columnLimit;         // Width the current line of the file is wrapped at, less than the line width for a heading
+    uint32_t line;               // Line on screen the next span becomes
+    uint32_t position;           // Offset of the next character
+    uint32_t lineStart;          // Offset where the current line on screen starts
+    uint32_t lineColumns;        // Characters on the current line on screen so far
+    int32_t lastSpace;           // Offset of the last space on the current line on screen, where it can be wrapped
+    int32_t lastCarriageReturn;  // Offset of the last carriage return, it takes a column when it is wrapped to the next line with a word
+    bool carriageReturn;         // A carriage return right before the newline is not part of the line
+    bool lineStartClean;         // Wrapping the current line on screen again from its start gives the same lines
+    uint32_t paragraphStart;     // Offset where the current line of the file starts
+    uint32_t paragraphFirstLine; // First line on screen of the current line of the file
+    char prefix[sizeof(LAYOUT_QR_CODE_PREFIX) - 1]; // Start of the line of the file, while it can still be a prefix that styles it
+    uint8_t prefixLength;
+    ParagraphStyle style;        // Style of the line of the file as far as its prefix is known
+    bool styleKnown;             // The style of the line of the file can not change anymore
+    uint8_t color;               // Markup color in effect at the next character
+    uint8_t lineStartColor;      // Markup color in effect at the start of the current line on screen
+    uint8_t lastSpaceColor;      // Markup color in effect right after the last space
+    uint32_t lastSpaceHidden;    // Bytes of tags since the last space, which take no columns
+    int32_t tagStart;            // Offset of the start of a tag whose end has not come yet, -1 outside of a tag
+    char tagName[MARKUP_TAG_NAME_MAX_LENGTH];
+    uint8_t tagNameLength;
+    uint32_t lastResumeLine;     // Last line kept as a resume point, or where filling the window started
+    TopicLayout *layout;         // Gets the checkpoints while a whole topic is laid out
+    TopicViewport *viewport;     // Gets its window and resume points while a window is filled
+    uint32_t stopLine;           // Filling a window stops at this line, once no QR code can take the lines before it back
+};
+
+// ===== Internal Helpers =====
+
+// Start a line of the file at an offset, nothing is known about its style yet
+static void startParagraph(LineWrapper &wrapper, uint32_t position)
+{
+    wrapper.paragraphStart = position;
+    wrapper.paragraphFirstLine = wrapper.line;
+    wrapper.prefixLength = 0;
+    wrapper.style = ParagraphStyle::TEXT;
+    wrapper.styleKnown = false;
+    wrapper.columnLimit = wrapper.lineWidth;
+    wrapper.color = MARKUP_DEFAULT_COLOR;
+    wrapper.lineStartColor = MARKUP_DEFAULT_COLOR;
+    wrapper.lineStart = position;
+    wrapper.lineColumns = 0;
+    wrapper.lastSpace = -1;
+    wrapper.carriageReturn = false;
+    wrapper.lineStartClean = true;
+}
+
+// Start wrapping at a line on screen that starts at an offset, within a line of the file when it is not the start of one
+static void startLineWrapper(LineWrapper &wrapper, uint8_t lineWidth, const LayoutCheckpoint &start, bool paragraphStart)
+{
+    wrapper = {};
+    wrapper.lineWidth = lineWidth;
+    wrapper.line = start.line;
+    wrapper.position = start.offset;
+    wrapper.lastCarriageReturn = -1;
+    wrapper.tagStart = -1;
+    startParagraph(wrapper, start.offset);
+    wrapper.styleKnown = !paragraphStart; // Checkpoints within a line of the file are only kept when it is plain text
+    wrapper.lastResumeLine = start.line;
+}
+
+// Keep a checkpoint when it is far enough from the one before it, thinning them out to every other one when the topic has
+// no room for more
+static void addCheckpoint(TopicLayout &layout, uint32_t line, uint32_t offset)
+{
+    std::vector<LayoutCheckpoint> &checkpoints = layout.checkpoints;
+    if (line - (checkpoints.empty() ? 0 : checkpoints.back().line) < layout.checkpointInterval)
+    {
+        return;
+    }
+    if (checkpoints.size() == LAYOUT_CHECKPOINT_MAX_AMOUNT)
+    {
+        for (size_t i = 0; i < LAYOUT_CHECKPOINT_MAX_AMOUNT / 2; i++)
+        {
+            checkpoints[i] = checkpoints[i * 2 + 1];
+        }
+        checkpoints.resize(LAYOUT_CHECKPOINT_MAX_AMOUNT / 2);
+        layout.checkpointInterval *= 2;
+        if (line - checkpoints.back().line < layout.checkpointInterval)
+        {
+            return;
+        }
+    }
+    checkpoints.push_back({line, offset});
+}
+
+// Keep a resume point in a viewport, in place of the one farthest from its window when it has no room for more
+static void addResumePoint(TopicViewport &viewport, uint32_t line, uint32_t offset)
+{
+    uint8_t index = 0;
+    while (index < viewport.resumePointAmount && viewport.resumePoints[index].line < line)
+    {
+        index++;
+    }
+    if (index < viewport.resumePointAmount && viewport.resumePoints[index].line == line)
+    {
+        return;
+    }
+    if (viewport.resumePointAmount == LAYOUT_RESUME_POINT_AMOUNT)
+    {
+        // The points are in order, so the farthest one is at either end. A new point farther than that is not kept
+        uint32_t window = viewport.windowFirstLine;
+        uint32_t firstDistance = window - min(window, viewport.resumePoints[0].line);
+        uint32_t lastDistance = max(window, viewport.resumePoints[LAYOUT_RESUME_POINT_AMOUNT - 1].line) - window;
+        if (firstDistance > lastDistance)
+        {
+            if (index == 0)
+            {
+                return;
+            }
+            memmove(&viewport.resumePoints[0], &viewport.resumePoints[1], (LAYOUT_RESUME_POINT_AMOUNT - 1) * sizeof(LayoutCheckpoint));
+            index--;
+        }
+        else if (index == LAYOUT_RESUME_POINT_AMOUNT)
+        {
+            return;
+        }
+        viewport.resumePointAmount--;
+    }
+    memmove(&viewport.resumePoints[index + 1], &viewport.resumePoints[index], (viewport.resumePointAmount - index) * sizeof(LayoutCheckpoint));
+    viewport.resumePoints[index] = {line, offset};
+    viewport.resumePointAmount++;
+}
+
+// Pass on a line on screen, to the window it falls in or as a place wrapping can start over at
+static void addLineSpan(LineWrapper &wrapper, uint32_t offset, uint32_t length, uint8_t part)
+{
+    TopicViewport *viewport = wrapper.viewport;
+    if (viewport && wrapper.line >= viewport->windowFirstLine && wrapper.line < viewport->windowFirstLine + LAYOUT_WINDOW_LINE_AMOUNT)
+    {
+        LineSpan &span = viewport->windowSpans[wrapper.line - viewport->windowFirstLine];
+        span.offset = offset;
+        span.length = length;
+        span.part = part;
+        span.color = wrapper.lineStartColor;
+        span.style = wrapper.style;
+    }
+
+    // Within a line of the file wrapping can only start over in plain text without a color in effect
+    bool plainText = wrapper.styleKnown && wrapper.style == ParagraphStyle::TEXT && wrapper.lineStartColor == MARKUP_DEFAULT_COLOR;
+    bool resumable = part == 0 && wrapper.lineStartClean && (offset == wrapper.paragraphStart || plainText);
+    if (resumable && wrapper.layout)
+    {
+        addCheckpoint(*wrapper.layout, wrapper.line, offset);
+    }
+    else if (resumable && viewport && wrapper.line - wrapper.lastResumeLine >= LAYOUT_RESUME_POINT_INTERVAL)
+    {
+        addResumePoint(*viewport, wrapper.line, offset);
+        wrapper.lastResumeLine = wrapper.line;
+    }
+    wrapper.line++;
+}
+
+// Pass on a line on screen of text, a line of a heading takes up more than one
+static void addTextLine(LineWrapper &wrapper, uint32_t offset, uint32_t length)
+{
+    uint8_t lineAmount = wrapper.style == ParagraphStyle::HEADING ? MARKUP_HEADING_TEXT_SIZE : 1;
+    for (uint8_t part = 0; part < lineAmount; part++)
+    {
+        addLineSpan(wrapper, offset, length, part);
+    }
+}
+
+// Check if the start of the line of the file is all of a prefix
+static bool matchesPrefix(const LineWrapper &wrapper, const char *prefix)
+{
+    return wrapper.prefixLength == strlen(prefix) && strncmp(wrapper.prefix, prefix, wrapper.prefixLength) == 0;
+}
+
+// Check if the start of the line of the file can still become a prefix
+static bool startsPrefix(const LineWrapper &wrapper, const char *prefix)
+{
+    return wrapper.prefixLength <= strlen(prefix) && strncmp(wrapper.prefix, prefix, wrapper.prefixLength) == 0;
+}
+
+// Match a character at the start of a line of the file against the prefixes that style it. Returns true when the character
+// completes a heading prefix, which is not shown, so the line on screen starts after it
+static bool matchParagraphPrefix(LineWrapper &wrapper, uint32_t position, char character)
+{
+    // The QR code prefix is the longest, once it is complete the line stays a QR code until it turns out too long for one
+    if (wrapper.styleKnown || wrapper.prefixLength == sizeof(wrapper.prefix))
+    {
+        return false;
+    }
+    wrapper.prefix[wrapper.prefixLength++] = character;
+    bool heading = matchesPrefix(wrapper, MARKUP_HEADING_PREFIX);
+    if (heading || matchesPrefix(wrapper, MARKUP_SUBHEADING_PREFIX))
+    {
+        wrapper.style = heading ? ParagraphStyle::HEADING : ParagraphStyle::SUBHEADING;
+        wrapper.styleKnown = true;
+        wrapper.columnLimit = heading ? max(wrapper.lineWidth / MARKUP_HEADING_TEXT_SIZE, 1) : wrapper.lineWidth;
+        wrapper.lineStart = position + 1;
+        wrapper.lineColumns = 0;
+        wrapper.lastSpace = -1;
+        return true;
+    }
+    wrapper.styleKnown = !startsPrefix(wrapper, LAYOUT_QR_CODE_PREFIX) && !startsPrefix(wrapper, MARKUP_HEADING_PREFIX) &&
+                         !startsPrefix(wrapper, MARKUP_SUBHEADING_PREFIX) && !startsPrefix(wrapper, MARKUP_RULE_LINE);
+    return false;
+}
+
+// Check if a line of the file becomes a QR code, a link too long for one stays text so it can still be read
+static bool isQrCodeParagraph(const LineWrapper &wrapper, uint32_t paragraphLength)
+{
+    uint8_t prefixLength = strlen(LAYOUT_QR_CODE_PREFIX);
+    return matchesPrefix(wrapper, LAYOUT_QR_CODE_PREFIX) && paragraphLength - prefixLength <= QR_CODE_MAX_TEXT_LENGTH;
+}
+
+// Replace the lines a QR code line was wrapped into with the lines on screen the QR code takes up
+static void replaceWithQrCode(LineWrapper &wrapper)
+{
+    wrapper.line = wrapper.paragraphFirstLine;
+    wrapper.lineStartClean = true;
+    wrapper.style = ParagraphStyle::QR_CODE;
+    wrapper.lineStartColor = MARKUP_DEFAULT_COLOR;
+    for (uint8_t i = 0; i < LAYOUT_QR_CODE_LINE_AMOUNT; i++)
+    {
+        addLineSpan(wrapper, wrapper.paragraphStart, 0, i);
+    }
+}
+
+// End the line of the file at a position, the line on screen it ends with gets the style its prefix turned out to give it
+static void endParagraph(LineWrapper &wrapper, uint32_t position, bool lastLine)
+{
+    uint32_t paragraphLength = position - wrapper.paragraphStart - (wrapper.carriageReturn ? 1 : 0);
+    if (matchesPrefix(wrapper, MARKUP_RULE_LINE) && paragraphLength == strlen(MARKUP_RULE_LINE))
+    {
+        wrapper.style = ParagraphStyle::RULE;
+    }
+    if (lastLine)
+    {
+        addTextLine(wrapper, wrapper.lineStart, position - wrapper.lineStart - (wrapper.carriageReturn ? 1 : 0));
+    }
+    if (isQrCodeParagraph(wrapper, paragraphLength))
+    {
+        replaceWithQrCode(wrapper);
+    }
+}
+
+// Wrap one character that is shown, or a carriage return
+static void wrapCharacter(LineWrapper &wrapper, uint32_t position, char character)
+{
+    wrapper.carriageReturn = character == '\r';
+    if (wrapper.carriageReturn)
+    {
+        wrapper.lastCarriageReturn = position;
+        return;
+    }
+    if (matchParagraphPrefix(wrapper, position, character))
+    {
+        return;
+    }
+
+    // The line is full, so it has to be wrapped before this character
+    if (wrapper.lineColumns == wrapper.columnLimit)
+    {
+        if (character == ' ')
+        {
+            // Wrap on this space, it is not shown on either line
+            addTextLine(wrapper, wrapper.lineStart, position - wrapper.lineStart);
+            wrapper.lineStart = position + 1;
+            wrapper.lineStartColor = wrapper.color;
+            wrapper.lineColumns = 0;
+            wrapper.lastSpace = -1;
+            wrapper.lineStartClean = true;
+            return;
+        }
+        else if (wrapper.lastSpace >= 0)
+        {
+            // Wrap on the last space, the start of the word moves to the next line
+            addTextLine(wrapper, wrapper.lineStart, wrapper.lastSpace - wrapper.lineStart);
+            wrapper.lineStart = wrapper.lastSpace + 1;
+            wrapper.lineStartColor = wrapper.lastSpaceColor;
+            wrapper.lineColumns = position - wrapper.lineStart - wrapper.lastSpaceHidden;
+            wrapper.lastSpace = -1;
+            wrapper.lineStartClean = wrapper.lastCarriageReturn < (int32_t)wrapper.lineStart;
+        }
+        else
+        {
+            // A word longer than the line is cut
+            addTextLine(wrapper, wrapper.lineStart, position - wrapper.lineStart);
+            wrapper.lineStart = position;
+            wrapper.lineStartColor = wrapper.color;
+            wrapper.lineColumns = 0;
+            wrapper.lineStartClean = true;
+        }
+    }
+
+    if (character == ' ')
+    {
+        wrapper.lastSpace = position;
+        wrapper.lastSpaceColor = wrapper.color;
+        wrapper.lastSpaceHidden = 0;
+    }
+    wrapper.lineColumns++;
+}
+
+// Wrap the characters of a tag that turned out not to be one, they are shown like any others
+static void wrapFailedTag(LineWrapper &wrapper)
+{
+    uint32_t position = wrapper.tagStart;
+    wrapper.tagStart = -1;
+    wrapCharacter(wrapper, position, MARKUP_TAG_START);
+    for (uint8_t i = 0; i < wrapper.tagNameLength; i++)
+    {
+        wrapCharacter(wrapper, position + 1 + i, wrapper.tagName[i]);
+    }
+}
+
+// Follow a character through a tag, returns false when the character is not part of one after all
+static bool wrapTagCharacter(LineWrapper &wrapper, char character)
+{
+    uint8_t color;
+    if (character == MARKUP_TAG_END && findMarkupColor(wrapper.tagName, wrapper.tagNameLength, color))
+    {
+        wrapper.color = color;
+        wrapper.lastSpaceHidden += wrapper.tagNameLength + 2;
+        wrapper.tagStart = -1;
+        return true;
+    }
+    if (character != MARKUP_TAG_END && isMarkupTagCharacter(character) && wrapper.tagNameLength < MARKUP_TAG_NAME_MAX_LENGTH)
+    {
+        wrapper.tagName[wrapper.tagNameLength++] = character;
+        return true;
+    }
+    wrapFailedTag(wrapper);
+    return false;
+}
+
+// Check if a window being filled has all of its lines, which no QR code can take back anymore
+static bool isWindowFilled(const LineWrapper &wrapper)
+{
+    return wrapper.viewport && wrapper.line >= wrapper.stopLine && (wrapper.styleKnown || wrapper.position == wrapper.paragraphStart);
+}
+
+// Wrap the text from where the wrapper is until the end of the stream, or until the window it fills is complete
+static StorageError wrapText(StreamReader &reader, LineWrapper &wrapper)
+{
+    // Go through the file a buffer at a time, lines can continue from one buffer into the next
+    StorageError error;
+    const uint8_t *data;
+    size_t length;
+    while ((error = readStreamChunk(reader, data, length)) == StorageError::NONE)
+    {
+        for (size_t i = 0; i < length; i++, wrapper.position++)
+        {
+            if (isWindowFilled(wrapper))
+            {
+                return StorageError::NONE;
+            }
+
+            uint32_t position = wrapper.position;
+            char character = data[i];
+            if (wrapper.tagStart >= 0 && wrapTagCharacter(wrapper, character))
+            {
+                continue;
+            }
+            if (character == '\n')
+            {
+                endParagraph(wrapper, position, true);
+                startParagraph(wrapper, position + 1);
+                continue;
+            }
+            if (character == MARKUP_TAG_START)
+            {
+                // Whether or not it is a tag, the line of the file no longer starts with a prefix, unless it is already a QR code's
+                wrapper.styleKnown = wrapper.styleKnown || !matchesPrefix(wrapper, LAYOUT_QR_CODE_PREFIX);
+                wrapper.tagStart = position;
+                wrapper.tagNameLength = 0;
+                continue;
+            }
+            wrapCharacter(wrapper, position, character);
+        }
+    }
+    if (error != StorageError::END_OF_FILE)
+    {
+        return error;
+    }
+
+    // A last line without a newline still counts as a line
+    if (wrapper.tagStart >= 0)
+    {
+        wrapFailedTag(wrapper);
+    }
+    endParagraph(wrapper, wrapper.position, wrapper.lineStart < wrapper.position);
+    return StorageError::NONE;
+}
+
+// Find the closest place before a line on screen that wrapping can start at
+static LayoutCheckpoint findWrapStart(const TopicViewport &viewport, uint32_t line)
+{
+    const std::vector<LayoutCheckpoint> &checkpoints = viewport.layout->checkpoints;
+    LayoutCheckpoint start = {0, 0};
+    auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), line,
+                                  [](uint32_t value, const LayoutCheckpoint &checkpoint) { return value < checkpoint.line; });
+    if (after != checkpoints.begin())
+    {
+        start = *(after - 1);
+    }
+    for (uint8_t i = 0; i < viewport.resumePointAmount && viewport.resumePoints[i].line <= line; i++)
+    {
+        if (viewport.resumePoints[i].line > start.line)
+        {
+            start = viewport.resumePoints[i];
+        }
+    }
+    return start;
+}
+
+// Compile the lines of the window of a viewport into its display list, reading the text of each line once. When the ops do
+// not all fit, the window is cut short after the last range of lines asked for, or starts over at its first line
+static StorageError compileViewportWindow(StreamReader &reader, TopicViewport &viewport, uint32_t firstLine, uint32_t endLine)
+{
+    uint16_t opsLength = 0;
+    for (uint16_t i = 0; i < viewport.windowLineAmount; i++)
+    {
+        const LineSpan &span = viewport.windowSpans[i];
+        char text[STREAM_LINE_MAX_LENGTH];
+        size_t textLength = 0;
+        if (span.length > 0)
+        {
+            StorageError error = seekStreamReader(reader, span.offset);
+            if (error == StorageError::NONE)
+            {
+                error = readStream(reader, (uint8_t *)text, min((size_t)span.length, sizeof(text)), textLength);
+            }
+            if (error != StorageError::NONE)
+            {
+                viewport.windowLineAmount = 0;
+                return error;
+            }
+        }
+
+        size_t lineOpsLength;
+        viewport.lineOps[i] = opsLength;
+        if (!compileDisplayLine(text, textLength, span.style, span.part, span.color, &viewport.displayList[opsLength], LAYOUT_DISPLAY_LIST_SIZE - opsLength, lineOpsLength))
+        {
+            if (viewport.windowFirstLine + i >= endLine || viewport.windowFirstLine >= firstLine)
+            {
+                viewport.windowLineAmount = i;
+                break;
+            }
+
+            // The lines before the range are dropped, a screen of lines always fits
+            uint16_t dropAmount = firstLine - viewport.windowFirstLine;
+            memmove(&viewport.windowSpans[0], &viewport.windowSpans[dropAmount], (viewport.windowLineAmount - dropAmount) * sizeof(LineSpan));
+            viewport.windowFirstLine = firstLine;
+            viewport.windowLineAmount -= dropAmount;
+            return compileViewportWindow(reader, viewport, firstLine, endLine);
+        }
+        opsLength += lineOpsLength;
+    }
+    viewport.lineOps[viewport.windowLineAmount] = opsLength;
+    return StorageError::NONE;
+}
+
+// ===== Functions Implementations =====
+
+StorageError layoutTopic(StreamReader &reader, uint8_t lineWidth, TopicLayout &layout)
+{
+    layout.checkpoints.clear();
+    layout.checkpointInterval = LAYOUT_CHECKPOINT_FIRST_INTERVAL;
+    layout.lineAmount = 0;
+    layout.lineWidth = 0;
+
+    StorageError error = seekStreamReader(reader, 0);
+    if (error != StorageError::NONE)
+    {
+        return error;
+    }
+
+    LineWrapper wrapper;
+    startLineWrapper(wrapper, lineWidth, {0, 0}, true);
+    wrapper.layout = &layout;
+    error = wrapText(reader, wrapper);
+    if (error != StorageError::NONE)
+    {
+        layout.checkpoints.clear();
+        return error;
+    }
+    layout.checkpoints.shrink_to_fit();
+    layout.lineAmount = wrapper.line;
+    layout.lineWidth = lineWidth;
+    return StorageError::NONE;
+}
+
+bool isTopicLaidOut(const TopicLayout &layout, uint8_t lineWidth)
+{
+    return layout.lineWidth == lineWidth;
+}
+
+uint32_t countLayoutLines(const TopicLayout &layout)
+{
+    return layout.lineAmount;
+}
+
+void openTopicViewport(const TopicLayout &layout, TopicViewport &viewport)
+{
+    viewport.layout = &layout;
+    viewport.windowFirstLine = 0;
+    viewport.windowLineAmount = 0;
+    viewport.resumePointAmount = 0;
+}
+
+StorageError moveTopicViewport(StreamReader &reader, TopicViewport &viewport, uint32_t firstLine, uint8_t lineAmount)
+{
+    FRAME_TIMING_SCOPE(TimingStage::LINE_READ);
+    uint32_t endLine = min(firstLine + lineAmount, countLayoutLines(*viewport.layout));
+    if (firstLine >= endLine || (firstLine >= viewport.windowFirstLine && endLine <= viewport.windowFirstLine + viewport.windowLineAmount))
+    {
+        return StorageError::NONE;
+    }
+
+    // Going back keeps the lines above the range in the window, going forward or jumping the lines below it
+    uint32_t windowFirstLine = firstLine;
+    if (viewport.windowLineAmount > 0 && firstLine < viewport.windowFirstLine)
+    {
+        windowFirstLine = endLine > LAYOUT_WINDOW_LINE_AMOUNT ? endLine - LAYOUT_WINDOW_LINE_AMOUNT : 0;
+    }
+    viewport.windowFirstLine = windowFirstLine;
+    viewport.windowLineAmount = 0;
+
+    // Starting within a line of the file, the character before tells if it is the start of one after all
+    LayoutCheckpoint start = findWrapStart(viewport, windowFirstLine);
+    bool paragraphStart = start.offset == 0;
+    StorageError error = seekStreamReader(reader, paragraphStart ? 0 : start.offset - 1);
+    if (error == StorageError::NONE && !paragraphStart)
+    {
+        uint8_t previous;
+        size_t readAmount;
+        error = readStream(reader, &previous, 1, readAmount);
+        paragraphStart = readAmount == 1 && previous == '\n';
+    }
+    if (error != StorageError::NONE)
+    {
+        return error;
+    }
+
+    LineWrapper wrapper;
+    startLineWrapper(wrapper, viewport.layout->lineWidth, start, paragraphStart);
+    wrapper.viewport = &viewport;
+    wrapper.stopLine = windowFirstLine + LAYOUT_WINDOW_LINE_AMOUNT;
+    error = wrapText(reader, wrapper);
+    if (error != StorageError::NONE)
+    {
+        return error;
+    }
+    viewport.windowLineAmount = wrapper.line > windowFirstLine ? min(wrapper.line - windowFirstLine, (uint32_t)LAYOUT_WINDOW_LINE_AMOUNT) : 0;
+    return compileViewportWindow(reader, viewport, firstLine, endLine);
+}
+
+bool isLineInViewport(const TopicViewport &viewport, uint32_t line)
+{
+    return line >= viewport.windowFirstLine && line < viewport.windowFirstLine + viewport.windowLineAmount;
+}
+
+const LineSpan &viewportLineSpan(const TopicViewport &viewport, uint32_t line)
+{
+    return viewport.windowSpans[line - viewport.windowFirstLine];
+}
+
+const uint8_t *viewportLineOps(const TopicViewport &viewport, uint32_t line, size_t &opsLength)
+{
+    uint32_t index = line - viewport.windowFirstLine;
+    opsLength = viewport.lineOps[index + 1] - viewport.lineOps[index];
+    return &viewport.displayList[viewport.lineOps[index]];
+}
+
+StorageError readQrCodeLink(StreamReader &reader, const LineSpan &span, char *link, size_t linkSize, size_t &linkLength)
+{
+    StorageError error = seekStreamReader(reader, span.offset + strlen(LAYOUT_QR_CODE_PREFIX));
+    if (error != StorageError::NONE)
+    {
+        link[0] = '\0';
+        linkLength = 0;
+        return error;
+    }
+    return readStreamLine(reader, link, linkSize, linkLength);
+}
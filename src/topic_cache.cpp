@@ -0,0 +1,361 @@
+#include "topic_cache.h"
+#include "compressed_text.h"
+#include "content_pack.h"
+#include "frame_timing.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
+
+// ===== Struct Definitions =====
+
+struct TopicCacheEntry
+{
+    uint8_t *text = nullptr; // Null while the entry is free
+    uint32_t size = 0;
+    uint32_t lastUse = 0;
+    uint16_t topicIndex = 0;
+    uint8_t pinCount = 0; // Acquired topics are never evicted
+    bool textMatches = false;
+};
+
+// ===== Topic Cache Storage =====
+
+TopicCacheEntry topicCacheEntries[TOPIC_CACHE_MAX_ENTRIES];
+uint32_t topicCacheBytes = 0;
+uint32_t topicCacheUseCounter = 0;
+int32_t topicCacheLoadingIndex = -1; // Topic the storage task is reading right now, -1 when it is idle
+
+fs::FS *topicCacheFs = nullptr;
+const char *topicCacheDirectory = nullptr;
+const TopicCatalog *topicCacheCatalog = nullptr;
+
+#ifdef ARDUINO_ARCH_ESP32
+SemaphoreHandle_t topicCacheMutex = nullptr;
+SemaphoreHandle_t topicLoadedSemaphore = nullptr; // Given after every background load, for anyone waiting on one
+QueueHandle_t topicPrefetchQueue = nullptr;       // Holds only the latest topic to prefetch around
+bool topicCacheTaskRunning = false;
+bool topicPrefetchPending = false; // A prefetch request is waiting or being read, only changed with the cache locked
+bool topicPrefetchedOnce = false;  // The storage task has finished at least one prefetch request
+#define TOPIC_CACHE_LOCK() xSemaphoreTake(topicCacheMutex, portMAX_DELAY)
+#define TOPIC_CACHE_UNLOCK() xSemaphoreGive(topicCacheMutex)
+#else
+#define TOPIC_CACHE_LOCK()
+#define TOPIC_CACHE_UNLOCK()
+#endif
+
+// ===== Internal Helpers =====
+
+// Check if a topic is small enough to be kept in the cache
+static bool topicFitsCache(uint16_t topicIndex)
+{
+    return topicCacheCatalog->entries[topicIndex].textSize <= TOPIC_CACHE_MAX_TOPIC_SIZE;
+}
+
+// Find the cache entry of a topic, -1 when it is not cached. Only call with the cache locked
+static int8_t findTopicCacheEntry(uint16_t topicIndex)
+{
+    for (uint8_t i = 0; i < TOPIC_CACHE_MAX_ENTRIES; i++)
+    {
+        if (topicCacheEntries[i].text && topicCacheEntries[i].topicIndex == topicIndex)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Read the whole text of a topic into PSRAM in one go, decompressing it when its file is compressed, and check it against its checksum when it comes from a content pack
+static bool readTopicText(uint16_t topicIndex, uint8_t *&text, bool &textMatches)
+{
+    FRAME_TIMING_SCOPE(TimingStage::TOPIC_LOAD);
+    const TopicEntry &entry = topicCacheCatalog->entries[topicIndex];
+    File file = openStorageFile(*topicCacheFs, String(topicCacheDirectory) + topicFileName(*topicCacheCatalog, topicIndex));
+    if (!file || (entry.textOffset > 0 && !file.seek(entry.textOffset)))
+    {
+        return false;
+    }
+
+    // Internal RAM is too scarce to cache in, without PSRAM every topic is streamed
+    text = (uint8_t *)ps_malloc(max(entry.textSize, (uint32_t)1));
+    if (!text)
+    {
+        return false;
+    }
+    // A compressed file is decompressed straight into the cache, block by block
+    bool textRead = entry.textCompressed ? decompressText(file, text, entry.textSize) == StorageError::NONE : file.read(text, entry.textSize) == entry.textSize;
+    if (!textRead)
+    {
+        free(text);
+        return false;
+    }
+    textMatches = topicCacheCatalog->packFileName.isEmpty() || calculateChecksum(text, entry.textSize) == entry.textChecksum;
+    return true;
+}
+
+// Put a topic that was just read into the cache, evicting the least recently used topics that are not acquired to make room.
+// The cache takes over the text, and frees it when there is no room. Returns the entry, -1 when there was no room.
+// Only call with the cache locked
+static int8_t storeTopicCacheEntry(uint16_t topicIndex, uint8_t *text, bool textMatches)
+{
+    uint32_t size = topicCacheCatalog->entries[topicIndex].textSize;
+
+    // The storage task and a waiting reader can both have read the same topic, the first one stays
+    int8_t existing = findTopicCacheEntry(topicIndex);
+    if (existing >= 0)
+    {
+        free(text);
+        return existing;
+    }
+
+    int8_t freeEntry = -1;
+    while (true)
+    {
+        int8_t oldestEntry = -1;
+        freeEntry = -1;
+        for (uint8_t i = 0; i < TOPIC_CACHE_MAX_ENTRIES; i++)
+        {
+            const TopicCacheEntry &entry = topicCacheEntries[i];
+            if (!entry.text)
+            {
+                freeEntry = i;
+            }
+            else if (entry.pinCount == 0 && (oldestEntry < 0 || entry.lastUse < topicCacheEntries[oldestEntry].lastUse))
+            {
+                oldestEntry = i;
+            }
+        }
+        if (freeEntry >= 0 && topicCacheBytes + size <= TOPIC_CACHE_SIZE)
+        {
+            break;
+        }
+        if (oldestEntry < 0)
+        {
+            free(text);
+            return -1;
+        }
+        free(topicCacheEntries[oldestEntry].text);
+        topicCacheEntries[oldestEntry].text = nullptr;
+        topicCacheBytes -= topicCacheEntries[oldestEntry].size;
+    }
+
+    TopicCacheEntry &entry = topicCacheEntries[freeEntry];
+    entry.text = text;
+    entry.size = size;
+    entry.lastUse = ++topicCacheUseCounter;
+    entry.topicIndex = topicIndex;
+    entry.pinCount = 0;
+    entry.textMatches = textMatches;
+    topicCacheBytes += size;
+    return freeEntry;
+}
+
+// Make sure a topic is in the cache, reading it when it is not
+static void prefetchTopic(uint16_t topicIndex)
+{
+    if (!topicFitsCache(topicIndex))
+    {
+        return;
+    }
+
+    TOPIC_CACHE_LOCK();
+    int8_t entry = findTopicCacheEntry(topicIndex);
+    if (entry >= 0)
+    {
+        topicCacheEntries[entry].lastUse = ++topicCacheUseCounter;
+        TOPIC_CACHE_UNLOCK();
+        return;
+    }
+    topicCacheLoadingIndex = topicIndex;
+    TOPIC_CACHE_UNLOCK();
+
+    // The card is read without holding the lock, so acquiring another topic never waits for it
+    uint8_t *text;
+    bool textMatches;
+    bool textRead = readTopicText(topicIndex, text, textMatches);
+
+    TOPIC_CACHE_LOCK();
+    topicCacheLoadingIndex = -1;
+    if (textRead)
+    {
+        storeTopicCacheEntry(topicIndex, text, textMatches);
+    }
+    TOPIC_CACHE_UNLOCK();
+#ifdef ARDUINO_ARCH_ESP32
+    xSemaphoreGive(topicLoadedSemaphore);
+#endif
+}
+
+// Load a topic first and then its neighbours in the menu, closest first and wrapping around like the menu does.
+// Stops early when a newer request comes in, the user has already moved on
+static void prefetchTopicsAround(uint16_t topicIndex)
+{
+    uint16_t topicAmount = countTopics(*topicCacheCatalog);
+    for (uint16_t distance = 0; distance <= TOPIC_PREFETCH_DISTANCE && distance < topicAmount; distance++)
+    {
+        for (int8_t direction = 1; direction >= -1; direction -= 2)
+        {
+#ifdef ARDUINO_ARCH_ESP32
+            if (uxQueueMessagesWaiting(topicPrefetchQueue) > 0)
+            {
+                return;
+            }
+#endif
+            prefetchTopic((topicIndex + topicAmount + direction * distance) % topicAmount);
+            if (distance == 0)
+            {
+                break;
+            }
+        }
+    }
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+// Waits for prefetch requests and reads their topics into the cache, so the loop never has to wait on the card for them
+static void topicCacheTask(void *parameter)
+{
+    uint16_t topicIndex;
+    while (true)
+    {
+        if (xQueueReceive(topicPrefetchQueue, &topicIndex, portMAX_DELAY) == pdTRUE)
+        {
+            prefetchTopicsAround(topicIndex);
+
+            // A request that came in while this one was read is still pending
+            TOPIC_CACHE_LOCK();
+            topicPrefetchPending = uxQueueMessagesWaiting(topicPrefetchQueue) > 0;
+            topicPrefetchedOnce = true;
+            TOPIC_CACHE_UNLOCK();
+        }
+    }
+}
+#endif
+
+// ===== Functions Implementations =====
+
+void initializeTopicCache(fs::FS &fs, const char *directory, const TopicCatalog &catalog)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    topicCacheMutex = xSemaphoreCreateMutex();
+    topicLoadedSemaphore = xSemaphoreCreateBinary();
+    topicPrefetchQueue = xQueueCreate(1, sizeof(uint16_t));
+    if (!topicCacheMutex || !topicLoadedSemaphore || !topicPrefetchQueue)
+    {
+        // Without its lock the cache stays off and every topic is streamed
+        return;
+    }
+#endif
+    topicCacheFs = &fs;
+    topicCacheDirectory = directory;
+    topicCacheCatalog = &catalog;
+#ifdef ARDUINO_ARCH_ESP32
+    topicCacheTaskRunning = xTaskCreatePinnedToCore(topicCacheTask, "topic_cache", TOPIC_CACHE_TASK_STACK_SIZE, nullptr, TOPIC_CACHE_TASK_PRIORITY, nullptr, TOPIC_CACHE_TASK_CORE) == pdPASS;
+#endif
+}
+
+void prefetchTopics(uint16_t topicIndex)
+{
+    if (!topicCacheCatalog || topicIndex >= countTopics(*topicCacheCatalog))
+    {
+        return;
+    }
+#ifdef ARDUINO_ARCH_ESP32
+    if (topicCacheTaskRunning)
+    {
+        TOPIC_CACHE_LOCK();
+        topicPrefetchPending = true;
+        xQueueOverwrite(topicPrefetchQueue, &topicIndex);
+        TOPIC_CACHE_UNLOCK();
+    }
+#else
+    // Without a storage task the topics are simply loaded right away
+    prefetchTopicsAround(topicIndex);
+#endif
+}
+
+bool acquireCachedTopic(uint16_t topicIndex, CachedTopic &topic)
+{
+    if (!topicCacheCatalog || topicIndex >= countTopics(*topicCacheCatalog) || !topicFitsCache(topicIndex))
+    {
+        return false;
+    }
+
+    int8_t entry;
+    while (true)
+    {
+        TOPIC_CACHE_LOCK();
+        entry = findTopicCacheEntry(topicIndex);
+        bool loading = topicCacheLoadingIndex == topicIndex;
+        if (entry >= 0 || !loading)
+        {
+            break;
+        }
+        TOPIC_CACHE_UNLOCK();
+
+        // The storage task is already reading this topic, reading it a second time would only be slower
+#ifdef ARDUINO_ARCH_ESP32
+        xSemaphoreTake(topicLoadedSemaphore, pdMS_TO_TICKS(TOPIC_CACHE_LOAD_WAIT_TIME));
+#endif
+    }
+
+    if (entry < 0)
+    {
+        // Neither cached nor on its way, so it is read right here
+        TOPIC_CACHE_UNLOCK();
+        uint8_t *text;
+        bool textMatches;
+        if (!readTopicText(topicIndex, text, textMatches))
+        {
+            return false;
+        }
+        TOPIC_CACHE_LOCK();
+        entry = storeTopicCacheEntry(topicIndex, text, textMatches);
+        if (entry < 0)
+        {
+            TOPIC_CACHE_UNLOCK();
+            return false;
+        }
+    }
+
+    TopicCacheEntry &cacheEntry = topicCacheEntries[entry];
+    cacheEntry.pinCount++;
+    cacheEntry.lastUse = ++topicCacheUseCounter;
+    topic.text = cacheEntry.text;
+    topic.size = cacheEntry.size;
+    topic.textMatches = cacheEntry.textMatches;
+    TOPIC_CACHE_UNLOCK();
+    return true;
+}
+
+void releaseCachedTopic(uint16_t topicIndex)
+{
+    if (!topicCacheCatalog)
+    {
+        return;
+    }
+    TOPIC_CACHE_LOCK();
+    int8_t entry = findTopicCacheEntry(topicIndex);
+    if (entry >= 0 && topicCacheEntries[entry].pinCount > 0)
+    {
+        topicCacheEntries[entry].pinCount--;
+    }
+    TOPIC_CACHE_UNLOCK();
+}
+
+bool isTopicPrefetchIdle()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (topicCacheTaskRunning)
+    {
+        TOPIC_CACHE_LOCK();
+        bool idle = topicPrefetchedOnce && !topicPrefetchPending;
+        TOPIC_CACHE_UNLOCK();
+        return idle;
+    }
+#endif
+    // Without a storage task topics are loaded right when they are asked for, nothing is left to wait on
+    return true;
+}
@@ -0,0 +1,174 @@
+#include "topic_catalog.h"
+#include "compressed_text.h"
+
+#include <algorithm>
+
+// ===== Internal Helpers =====
+
+// Compare two names ignoring case, names that only differ in case keep a fixed order
+static bool topicNameIsBefore(const char *first, const char *second)
+{
+    int difference = strcasecmp(first, second);
+    return difference != 0 ? difference < 0 : strcmp(first, second) < 0;
+}
+
+// ===== Functions Implementations =====
+
+void clearTopicCatalog(TopicCatalog &catalog)
+{
+    std::vector<TopicEntry>().swap(catalog.entries);
+    std::vector<TopicLayout>().swap(catalog.layouts);
+    std::vector<char>().swap(catalog.nameArena);
+    catalog.packFileName = "";
+}
+
+bool addTopic(TopicCatalog &catalog, const char *name, size_t nameLength, uint32_t textOffset, uint32_t textSize, uint32_t textChecksum)
+{
+    if (catalog.entries.size() >= TOPIC_CATALOG_MAX_AMOUNT)
+    {
+        return false;
+    }
+
+    TopicEntry entry;
+    entry.nameOffset = catalog.nameArena.size();
+    entry.textOffset = textOffset;
+    entry.textSize = textSize;
+    entry.textChecksum = textChecksum;
+    catalog.nameArena.insert(catalog.nameArena.end(), name, name + nameLength);
+    catalog.nameArena.push_back('\0');
+    catalog.entries.push_back(entry);
+    catalog.layouts.emplace_back();
+    return true;
+}
+
+void sortTopicCatalog(TopicCatalog &catalog)
+{
+    // Sort an order of indices first, so the entries and their layouts can be moved into place together
+    std::vector<uint16_t> order(catalog.entries.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&catalog](uint16_t first, uint16_t second)
+                     { return topicNameIsBefore(topicName(catalog, first), topicName(catalog, second)); });
+
+    std::vector<TopicEntry> sortedEntries;
+    std::vector<TopicLayout> sortedLayouts;
+    sortedEntries.reserve(order.size());
+    sortedLayouts.reserve(order.size());
+    for (uint16_t index : order)
+    {
+        sortedEntries.push_back(catalog.entries[index]);
+        sortedLayouts.push_back(std::move(catalog.layouts[index]));
+    }
+    catalog.entries.swap(sortedEntries);
+    catalog.layouts.swap(sortedLayouts);
+}
+
+uint16_t countTopics(const TopicCatalog &catalog)
+{
+    return catalog.entries.size();
+}
+
+const char *topicName(const TopicCatalog &catalog, uint16_t index)
+{
+    return &catalog.nameArena[catalog.entries[index].nameOffset];
+}
+
+int32_t findTopic(const TopicCatalog &catalog, const char *name)
+{
+    // The catalog is sorted, so a binary search finds the first topic that is not before the name
+    size_t low = 0;
+    size_t high = catalog.entries.size();
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (topicNameIsBefore(topicName(catalog, middle), name))
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    if (low < catalog.entries.size() && strcmp(topicName(catalog, low), name) == 0)
+    {
+        return low;
+    }
+    return -1;
+}
+
+String topicFileName(const TopicCatalog &catalog, uint16_t index)
+{
+    if (!catalog.packFileName.isEmpty())
+    {
+        return catalog.packFileName;
+    }
+    return String(topicName(catalog, index)) + (catalog.entries[index].textCompressed ? COMPRESSED_TEXT_FILE_EXTENSION : TOPIC_FILE_EXTENSION);
+}
+
+StorageError openTopicStreamReader(fs::FS &fs, const char *directory, const TopicCatalog &catalog, uint16_t index, uint8_t *buffer, size_t bufferSize, StreamReader &reader)
+{
+    const TopicEntry &topic = catalog.entries[index];
+    String path = directory + topicFileName(catalog, index);
+    if (topic.textCompressed)
+    {
+        return openCompressedStreamReader(fs, path, buffer, bufferSize, reader);
+    }
+    return openStreamReaderRange(fs, path, topic.textOffset, topic.textSize, buffer, bufferSize, reader);
+}
+
+StorageError assembleTopicsFromDirectory(fs::FS &fs, const char *dirname, TopicCatalog &catalog)
+{
+    clearTopicCatalog(catalog);
+
+    File root = fs.open(dirname);
+    if (!root)
+    {
+        return StorageError::OPEN_FAILED;
+    }
+    if (!root.isDirectory())
+    {
+        return StorageError::NOT_A_DIRECTORY;
+    }
+
+    static_assert(sizeof(TOPIC_FILE_EXTENSION) == sizeof(COMPRESSED_TEXT_FILE_EXTENSION), "Both topic file extensions have the same length");
+    const size_t extensionLength = strlen(TOPIC_FILE_EXTENSION);
+    File file = root.openNextFile();
+    while (file)
+    {
+        if (!file.isDirectory())
+        {
+            const char *fileName = file.name();
+            size_t fileNameLength = strlen(fileName);
+            const char *extension = fileNameLength > extensionLength ? &fileName[fileNameLength - extensionLength] : "";
+            bool compressed = strcmp(extension, COMPRESSED_TEXT_FILE_EXTENSION) == 0;
+            if (compressed || strcmp(extension, TOPIC_FILE_EXTENSION) == 0)
+            {
+                // Only the header of a compressed file is read here. One with a broken header keeps its file size and shows its error when opened
+                uint32_t textSize = file.size();
+                CompressedTextHeader header;
+                if (compressed && readCompressedTextHeader(file, header) == StorageError::NONE)
+                {
+                    textSize = header.textSize;
+                }
+                if (!addTopic(catalog, fileName, fileNameLength - extensionLength, 0, textSize, 0))
+                {
+                    break;
+                }
+                // Together with the size this tells if an indexed copy of its layout still fits the file
+                catalog.entries.back().lastWrite = file.getLastWrite();
+                catalog.entries.back().textCompressed = compressed;
+            }
+        }
+        file = root.openNextFile();
+    }
+
+    // Directory order depends on when the files were written, sorting makes the menu the same on every card
+    sortTopicCatalog(catalog);
+    catalog.entries.shrink_to_fit();
+    catalog.layouts.shrink_to_fit();
+    catalog.nameArena.shrink_to_fit();
+    return StorageError::NONE;
+}
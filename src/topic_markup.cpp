@@ -0,0 +1,189 @@
+#include "topic_markup.h"
+
+#include <Arduino_GFX_Library.h>
+
+// ===== Struct Definitions =====
+
+struct MarkupColor
+{
+    const char *name;
+    uint16_t color;
+};
+
+// ===== Markup Colors =====
+
+// The text color comes first, so a display list index of zero is plain text. The canvas has a palette of 16 colors, which
+// these share with the interface
+static const MarkupColor markupColors[] = {
+    {"white", WHITE}, {"red", RED}, {"green", GREEN}, {"blue", BLUE}, {"cyan", CYAN},
+    {"magenta", MAGENTA}, {"yellow", YELLOW}, {"orange", ORANGE}, {"darkgreen", DARKGREEN}};
+
+#define MARKUP_HEADING_COLOR_INDEX 6    // Yellow
+#define MARKUP_SUBHEADING_COLOR_INDEX 4 // Cyan
+#define MARKUP_RULE_COLOR_INDEX 8       // Dark green, like the scrollbar
+
+// ===== Internal Helpers =====
+
+// Add an op without an operand to a display list, when there is room for it
+static bool addDisplayOp(uint8_t *ops, size_t opsSize, size_t &opsLength, DisplayOp op)
+{
+    if (opsLength + 1 > opsSize)
+    {
+        return false;
+    }
+    ops[opsLength++] = (uint8_t)op;
+    return true;
+}
+
+// Add an op with an operand to a display list, when there is room for it
+static bool addDisplayOp(uint8_t *ops, size_t opsSize, size_t &opsLength, DisplayOp op, uint8_t operand)
+{
+    if (opsLength + 2 > opsSize)
+    {
+        return false;
+    }
+    ops[opsLength++] = (uint8_t)op;
+    ops[opsLength++] = operand;
+    return true;
+}
+
+// Add a run of characters to draw, a zero in the text would end it early and is drawn as an unknown character instead
+static bool addDisplayText(uint8_t *ops, size_t opsSize, size_t &opsLength, const char *text, size_t textLength)
+{
+    if (textLength == 0)
+    {
+        return true;
+    }
+    if (opsLength + textLength + 2 > opsSize)
+    {
+        return false;
+    }
+    ops[opsLength++] = (uint8_t)DisplayOp::TEXT;
+    for (size_t i = 0; i < textLength; i++)
+    {
+        ops[opsLength++] = text[i] != '\0' ? text[i] : '?';
+    }
+    ops[opsLength++] = '\0';
+    return true;
+}
+
+// Get the length of a tag at the start of the text along with its color, zero when the text does not start with a whole tag
+static size_t parseMarkupTag(const char *text, size_t textLength, uint8_t &color)
+{
+    if (textLength == 0 || text[0] != MARKUP_TAG_START)
+    {
+        return 0;
+    }
+    size_t nameLength = 0;
+    while (1 + nameLength < textLength && nameLength <= MARKUP_TAG_NAME_MAX_LENGTH && isMarkupTagCharacter(text[1 + nameLength]))
+    {
+        nameLength++;
+    }
+    if (1 + nameLength >= textLength || text[1 + nameLength] != MARKUP_TAG_END || !findMarkupColor(&text[1], nameLength, color))
+    {
+        return 0;
+    }
+    return nameLength + 2;
+}
+
+// Get the color a paragraph style draws its text in
+static uint8_t paragraphColor(ParagraphStyle style)
+{
+    switch (style)
+    {
+    case ParagraphStyle::HEADING:
+        return MARKUP_HEADING_COLOR_INDEX;
+    case ParagraphStyle::SUBHEADING:
+        return MARKUP_SUBHEADING_COLOR_INDEX;
+    case ParagraphStyle::RULE:
+        return MARKUP_RULE_COLOR_INDEX;
+    default:
+        return MARKUP_TEXT_COLOR_INDEX;
+    }
+}
+
+// ===== Functions Implementations =====
+
+bool isMarkupTagCharacter(char character)
+{
+    return (character >= 'a' && character <= 'z') || character == MARKUP_TAG_RESET[0];
+}
+
+bool findMarkupColor(const char *name, size_t nameLength, uint8_t &color)
+{
+    if (nameLength == strlen(MARKUP_TAG_RESET) && strncmp(name, MARKUP_TAG_RESET, nameLength) == 0)
+    {
+        color = MARKUP_DEFAULT_COLOR;
+        return true;
+    }
+    for (uint8_t i = 0; i < sizeof(markupColors) / sizeof(markupColors[0]); i++)
+    {
+        if (strlen(markupColors[i].name) == nameLength && strncmp(name, markupColors[i].name, nameLength) == 0)
+        {
+            color = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t markupColor(uint8_t color)
+{
+    return color < sizeof(markupColors) / sizeof(markupColors[0]) ? markupColors[color].color : WHITE;
+}
+
+bool compileDisplayLine(const char *text, size_t textLength, ParagraphStyle style, uint8_t part, uint8_t color, uint8_t *ops, size_t opsSize, size_t &opsLength)
+{
+    opsLength = 0;
+    if (part > 0 && !addDisplayOp(ops, opsSize, opsLength, DisplayOp::PART, part))
+    {
+        return false;
+    }
+    if (style == ParagraphStyle::QR_CODE)
+    {
+        return addDisplayOp(ops, opsSize, opsLength, DisplayOp::QR_CODE);
+    }
+    if (style == ParagraphStyle::HEADING && !addDisplayOp(ops, opsSize, opsLength, DisplayOp::SIZE, MARKUP_HEADING_TEXT_SIZE))
+    {
+        return false;
+    }
+
+    // Color ops are only added where the color changes, the line starts in the text color
+    uint8_t defaultColor = paragraphColor(style);
+    uint8_t currentColor = MARKUP_TEXT_COLOR_INDEX;
+    uint8_t lineColor = color == MARKUP_DEFAULT_COLOR ? defaultColor : color;
+    if (lineColor != currentColor && !addDisplayOp(ops, opsSize, opsLength, DisplayOp::COLOR, lineColor))
+    {
+        return false;
+    }
+    currentColor = lineColor;
+    if (style == ParagraphStyle::RULE)
+    {
+        return addDisplayOp(ops, opsSize, opsLength, DisplayOp::RULE);
+    }
+
+    size_t runStart = 0;
+    for (size_t i = 0; i < textLength;)
+    {
+        uint8_t tagColor;
+        size_t tagLength = text[i] == MARKUP_TAG_START ? parseMarkupTag(&text[i], textLength - i, tagColor) : 0;
+        if (tagLength == 0)
+        {
+            i++;
+            continue;
+        }
+        if (!addDisplayText(ops, opsSize, opsLength, &text[runStart], i - runStart))
+        {
+            return false;
+        }
+        tagColor = tagColor == MARKUP_DEFAULT_COLOR ? defaultColor : tagColor;
+        if (tagColor != currentColor && !addDisplayOp(ops, opsSize, opsLength, DisplayOp::COLOR, tagColor))
+        {
+            return false;
+        }
+        currentColor = tagColor;
+        i += tagLength;
+        runStart = i;
+    }
+    return addDisplayText(ops, opsSize, opsLength, &text[runStart], textLength - runStart);
+}
@@ -0,0 +1,249 @@
+// Compressed text files round-trip through decompressText. The files are built by a plain greedy encoder of the format in
+// compressed_text.h, kept apart from the topic compressor's hash chains so the decoder is checked against a second encoder
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "../test_support.h"
+#include "compressed_text.h"
+
+// ===== Test Definitions =====
+
+#define TEST_FILE_PATH "/topic" COMPRESSED_TEXT_FILE_EXTENSION
+#define TEST_BLOCK_SIZE COMPRESSED_TEXT_BLOCK_SIZE
+
+// ===== Test Helpers =====
+
+// Append the bytes of a value to a growing file
+template <typename T>
+static void appendBytes(std::vector<uint8_t> &destination, const T &value)
+{
+    const uint8_t *bytes = (const uint8_t *)&value;
+    destination.insert(destination.end(), bytes, bytes + sizeof(T));
+}
+
+// Compress one block, taking the longest earlier repeat in the block at every position
+static std::vector<uint8_t> encodeBlock(const uint8_t *text, size_t length)
+{
+    std::vector<uint8_t> output;
+    size_t flagsPosition = 0;
+    uint8_t flagBit = 8;
+    size_t position = 0;
+    while (position < length)
+    {
+        if (flagBit == 8)
+        {
+            flagsPosition = output.size();
+            output.push_back(0);
+            flagBit = 0;
+        }
+
+        size_t bestLength = 0;
+        size_t bestDistance = 0;
+        size_t maximumLength = min((size_t)COMPRESSED_TEXT_MAX_MATCH, length - position);
+        for (size_t distance = 1; distance <= position && distance <= COMPRESSED_TEXT_MAX_DISTANCE; distance++)
+        {
+            size_t matchLength = 0;
+            while (matchLength < maximumLength && text[position - distance + matchLength] == text[position + matchLength])
+            {
+                matchLength++;
+            }
+            if (matchLength > bestLength)
+            {
+                bestLength = matchLength;
+                bestDistance = distance;
+            }
+        }
+
+        if (bestLength >= COMPRESSED_TEXT_MIN_MATCH)
+        {
+            output.push_back((bestDistance - 1) & 0xFF);
+            output.push_back((((bestDistance - 1) >> 8) << 4) | (bestLength - COMPRESSED_TEXT_MIN_MATCH));
+            position += bestLength;
+        }
+        else
+        {
+            output[flagsPosition] |= 1 << flagBit;
+            output.push_back(text[position]);
+            position++;
+        }
+        flagBit++;
+    }
+    return output;
+}
+
+// Build a whole compressed text file from blocks compressed before: the header, the block table and every block
+static std::vector<uint8_t> assembleFile(uint32_t textSize, const std::vector<std::vector<uint8_t>> &blocks)
+{
+    CompressedTextHeader header = {};
+    memcpy(header.magic, COMPRESSED_TEXT_MAGIC, sizeof(header.magic));
+    header.version = COMPRESSED_TEXT_VERSION;
+    header.blockSize = TEST_BLOCK_SIZE;
+    header.textSize = textSize;
+    header.headerChecksum = compressedTextHeaderChecksum(header);
+
+    std::vector<uint8_t> file;
+    appendBytes(file, header);
+    uint32_t offset = sizeof(header) + (blocks.size() + 1) * sizeof(uint32_t);
+    for (const std::vector<uint8_t> &block : blocks)
+    {
+        appendBytes(file, offset);
+        offset += block.size();
+    }
+    appendBytes(file, offset);
+    for (const std::vector<uint8_t> &block : blocks)
+    {
+        file.insert(file.end(), block.begin(), block.end());
+    }
+    return file;
+}
+
+// Compress a whole text into a compressed text file
+static std::vector<uint8_t> encodeText(const std::vector<uint8_t> &text)
+{
+    std::vector<std::vector<uint8_t>> blocks;
+    for (size_t blockStart = 0; blockStart < text.size(); blockStart += TEST_BLOCK_SIZE)
+    {
+        blocks.push_back(encodeBlock(&text[blockStart], min((size_t)TEST_BLOCK_SIZE, text.size() - blockStart)));
+    }
+    return assembleFile(text.size(), blocks);
+}
+
+// Write a compressed text file to the card directory and decompress it back through the firmware's decoder
+static StorageError decompressFile(const std::vector<uint8_t> &contents, uint32_t textSize, std::vector<uint8_t> &text)
+{
+    writeTestFile(testCardPath(TEST_FILE_PATH), contents.data(), contents.size());
+
+    File file = testFs.open(TEST_FILE_PATH);
+    TEST_ASSERT_TRUE(file);
+    text.assign(textSize, 0);
+    StorageError error = decompressText(file, text.data(), textSize);
+    file.close();
+    return error;
+}
+
+// Compress a text, decompress it again and check nothing changed on the way
+static void assertRoundTrip(const std::vector<uint8_t> &text)
+{
+    std::vector<uint8_t> decompressed;
+    TEST_ASSERT_STORAGE_ERROR(StorageError::NONE, decompressFile(encodeText(text), text.size(), decompressed));
+    TEST_ASSERT_EQUAL_MEMORY(text.data(), decompressed.data(), text.size());
+}
+
+// Lines of words that repeat often but not in a fixed pattern, like the text of a topic
+static std::vector<uint8_t> makeTopicText(size_t size)
+{
+    static const char *words[] = {"portfolio ", "project ", "display ", "the ", "card ", "touch ", "screen\n", "of "};
+    std::vector<uint8_t> text;
+    uint32_t seed = 1;
+    while (text.size() < size)
+    {
+        seed = seed * 1103515245 + 12345;
+        const char *word = words[(seed >> 16) % 8];
+        text.insert(text.end(), word, word + strlen(word));
+    }
+    text.resize(size);
+    return text;
+}
+
+// ===== Tests =====
+
+void setUp()
+{
+    clearTestCard();
+}
+
+void tearDown()
+{
+    removeTestCard();
+}
+
+void test_text_with_a_partial_last_block_round_trips()
+{
+    assertRoundTrip(makeTopicText(3 * TEST_BLOCK_SIZE + 1000));
+}
+
+void test_text_of_whole_blocks_round_trips()
+{
+    assertRoundTrip(makeTopicText(2 * TEST_BLOCK_SIZE));
+}
+
+void test_text_shorter_than_a_match_round_trips()
+{
+    assertRoundTrip({'a', 'b'});
+}
+
+void test_overlapping_matches_round_trip()
+{
+    // A run of one byte is a single literal followed by matches one byte back, each copying what it writes itself
+    std::vector<uint8_t> text(1000, 'x');
+    text.insert(text.end(), {'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b'});
+    assertRoundTrip(text);
+}
+
+void test_matches_far_back_in_the_block_round_trip()
+{
+    // Bytes that hardly repeat except for the start of the block at its end, so the match needs the high bits of its distance
+    std::vector<uint8_t> text(TEST_BLOCK_SIZE);
+    uint32_t seed = 7;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        text[i] = seed >> 24;
+    }
+    std::copy(text.begin(), text.begin() + COMPRESSED_TEXT_MAX_MATCH, text.end() - COMPRESSED_TEXT_MAX_MATCH);
+    std::vector<uint8_t> block = encodeBlock(text.data(), text.size());
+    TEST_ASSERT_EQUAL((TEST_BLOCK_SIZE - COMPRESSED_TEXT_MAX_MATCH - 1) >> 8, block.back() >> 4);
+    assertRoundTrip(text);
+}
+
+void test_match_before_the_start_of_a_block_is_rejected()
+{
+    // A match as the very first item of a block has no text to copy from
+    std::vector<uint8_t> block = {0x00, 0x00, 0x00};
+    std::vector<uint8_t> text;
+    TEST_ASSERT_STORAGE_ERROR(StorageError::BAD_FORMAT, decompressFile(assembleFile(COMPRESSED_TEXT_MIN_MATCH, {block}), COMPRESSED_TEXT_MIN_MATCH, text));
+}
+
+void test_match_past_the_end_of_a_block_is_rejected()
+{
+    // Three literals, then a match of the longest length for a block that only has two bytes left
+    std::vector<uint8_t> block = {0x07, 'a', 'b', 'c', 0x02, 0x0F};
+    std::vector<uint8_t> text;
+    TEST_ASSERT_STORAGE_ERROR(StorageError::BAD_FORMAT, decompressFile(assembleFile(5, {block}), 5, text));
+}
+
+void test_cut_off_block_is_rejected()
+{
+    std::vector<uint8_t> text = makeTopicText(TEST_BLOCK_SIZE + 100);
+    std::vector<std::vector<uint8_t>> blocks = {encodeBlock(text.data(), TEST_BLOCK_SIZE), encodeBlock(&text[TEST_BLOCK_SIZE], 100)};
+    blocks[0].pop_back();
+    std::vector<uint8_t> decompressed;
+    TEST_ASSERT_STORAGE_ERROR(StorageError::BAD_FORMAT, decompressFile(assembleFile(text.size(), blocks), text.size(), decompressed));
+}
+
+void test_block_with_bytes_after_its_text_is_rejected()
+{
+    std::vector<uint8_t> text = makeTopicText(TEST_BLOCK_SIZE + 100);
+    std::vector<std::vector<uint8_t>> blocks = {encodeBlock(text.data(), TEST_BLOCK_SIZE), encodeBlock(&text[TEST_BLOCK_SIZE], 100)};
+    blocks[0].push_back(0xFF);
+    std::vector<uint8_t> decompressed;
+    TEST_ASSERT_STORAGE_ERROR(StorageError::BAD_FORMAT, decompressFile(assembleFile(text.size(), blocks), text.size(), decompressed));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_text_with_a_partial_last_block_round_trips);
+    RUN_TEST(test_text_of_whole_blocks_round_trips);
+    RUN_TEST(test_text_shorter_than_a_match_round_trips);
+    RUN_TEST(test_overlapping_matches_round_trip);
+    RUN_TEST(test_matches_far_back_in_the_block_round_trip);
+    RUN_TEST(test_match_before_the_start_of_a_block_is_rejected);
+    RUN_TEST(test_match_past_the_end_of_a_block_is_rejected);
+    RUN_TEST(test_cut_off_block_is_rejected);
+    RUN_TEST(test_block_with_bytes_after_its_text_is_rejected);
+    return UNITY_END();
+}
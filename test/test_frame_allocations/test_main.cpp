@@ -0,0 +1,110 @@
+// Steady-state frames draw from fixed buffers: once the menu is up, moving the indicator and scrolling a topic must not
+// allocate. Runs the firmware itself against a card directory and a touch script, and checks the host's allocation counter
+
+#include <Arduino.h>
+#include <Arduino_GFX_Library.h>
+#include <unity.h>
+
+#include <filesystem>
+#include <string>
+
+#include "../test_support.h"
+
+// ===== Test Definitions =====
+
+#define TEST_TOUCH_SCRIPT TEST_SD_ROOT "_touches"
+#define TEST_TOPIC_LINE_AMOUNT 200 // Several screens, so scrolling has to wrap the text around the window again
+
+#define TEST_MENU_READY_TIME 2500     // The menu is on the panel and its topics are loaded ahead
+#define TEST_INDICATOR_DONE_TIME 3900 // After moving the indicator down twice and up once
+#define TEST_TOPIC_OPEN_TIME 4900     // After selecting the topic under the indicator, loading it may allocate
+#define TEST_SCROLL_DONE_TIME 8000    // After scrolling with the buttons and dragging the text
+
+// Down, down, up, select, then scroll down twice, up once, drag the text up and fling it back down
+static const char *testTouchScript =
+    "3000 100 440 250\n"
+    "3300 100 440 250\n"
+    "3600 100 440 30\n"
+    "4000 100 440 136\n"
+    "5000 100 440 250\n"
+    "5300 100 440 250\n"
+    "5600 100 440 30\n"
+    "6000 400 200 220 200 80\n"
+    "6800 150 200 80 200 240\n";
+
+// ===== Test Helpers =====
+
+// A topic of numbered lines long enough to wrap
+static std::string makeTopicText(const char *name)
+{
+    std::string text;
+    for (uint32_t line = 0; line < TEST_TOPIC_LINE_AMOUNT; line++)
+    {
+        text += std::string(name) + " line " + std::to_string(line) + ", with enough words after it to wrap at least once on the details screen\n";
+    }
+    return text;
+}
+
+// Run the firmware until the virtual clock reaches a time
+static void runUntil(unsigned long time)
+{
+    while (millis() < time)
+    {
+        loop();
+    }
+}
+
+// ===== Tests =====
+
+void setUp()
+{
+    clearTestCard();
+}
+
+void tearDown()
+{
+    removeTestCard();
+    std::filesystem::remove(TEST_TOUCH_SCRIPT);
+}
+
+void test_allocations_are_counted()
+{
+    unsigned long allocations = hostHeapAllocations();
+    String text("a string long enough to be stored on the heap");
+    TEST_ASSERT_TRUE(text.length() > 0);
+    TEST_ASSERT_TRUE(hostHeapAllocations() > allocations);
+}
+
+void test_steady_state_frames_do_not_allocate()
+{
+    writeTestFile(testCardPath("/Alpha.txt"), makeTopicText("Alpha"));
+    writeTestFile(testCardPath("/Beta.txt"), makeTopicText("Beta"));
+    writeTestFile(testCardPath("/Gamma.txt"), makeTopicText("Gamma"));
+    writeTestFile(TEST_TOUCH_SCRIPT, testTouchScript);
+    setenv("PORTFOLIO_SD_ROOT", TEST_SD_ROOT, 1);
+    setenv("PORTFOLIO_TOUCH_SCRIPT", TEST_TOUCH_SCRIPT, 1);
+
+    setup();
+    runUntil(TEST_MENU_READY_TIME);
+
+    unsigned long allocations = hostHeapAllocations();
+    uint32_t frames = hostPanelStats().frames;
+    runUntil(TEST_INDICATOR_DONE_TIME);
+    TEST_ASSERT_TRUE_MESSAGE(hostPanelStats().frames > frames, "Moving the indicator drew nothing");
+    TEST_ASSERT_EQUAL_MESSAGE(allocations, hostHeapAllocations(), "Moving the indicator allocated");
+
+    runUntil(TEST_TOPIC_OPEN_TIME);
+    allocations = hostHeapAllocations();
+    frames = hostPanelStats().frames;
+    runUntil(TEST_SCROLL_DONE_TIME);
+    TEST_ASSERT_TRUE_MESSAGE(hostPanelStats().frames > frames, "Scrolling drew nothing");
+    TEST_ASSERT_EQUAL_MESSAGE(allocations, hostHeapAllocations(), "Scrolling the topic allocated");
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_allocations_are_counted);
+    RUN_TEST(test_steady_state_frames_do_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,60 @@
+// Replays a recorded touch trace against a small card and checks every frame the panel got against the golden hashes of the
+// run that recorded them. The card is copied fresh for every run: the first boot writes the index cache onto it, which
+// changes the boot screen of every boot after it
+
+#include <Arduino.h>
+#include <Arduino_GFX_Library.h>
+#include <bb_captouch.h>
+#include <unity.h>
+
+#include <filesystem>
+#include <string>
+
+#include "../test_support.h"
+
+// ===== Test Definitions =====
+
+#define TEST_DATA_DIRECTORY std::filesystem::path(__FILE__).parent_path()
+#define TEST_CARD_DIRECTORY (TEST_DATA_DIRECTORY / "card")      // Topics the trace was recorded with
+#define TEST_TRACE_PATH (TEST_DATA_DIRECTORY / "trace.log")     // Serial log of a TOUCH_TRACE_RECORD build
+#define TEST_GOLDEN_PATH (TEST_DATA_DIRECTORY / "trace.golden") // Hash of every transfer, recorded when it is missing
+
+// ===== Tests =====
+
+void setUp()
+{
+    clearTestCard();
+    std::filesystem::copy(TEST_CARD_DIRECTORY, TEST_SD_ROOT, std::filesystem::copy_options::recursive);
+}
+
+void tearDown()
+{
+    removeTestCard();
+}
+
+void test_trace_replays_to_the_golden_frames()
+{
+    bool recording = !std::filesystem::exists(TEST_GOLDEN_PATH);
+    setenv("PORTFOLIO_SD_ROOT", TEST_SD_ROOT, 1);
+    setenv("PORTFOLIO_TOUCH_TRACE", TEST_TRACE_PATH.c_str(), 1);
+    setenv("PORTFOLIO_GOLDEN_HASHES", TEST_GOLDEN_PATH.c_str(), 1);
+
+    setup();
+    while (!hostTouchScriptFinished())
+    {
+        loop();
+    }
+
+    HostPanelStats stats = hostPanelStats();
+    TEST_ASSERT_FALSE_MESSAGE(recording, "No golden hashes to compare with, recorded them from this run");
+    TEST_ASSERT_TRUE_MESSAGE(stats.goldenCompared, "The golden hashes could not be read");
+    TEST_ASSERT_EQUAL_MESSAGE(0, stats.firstGoldenMismatch, "First transfer that left another frame than the golden run");
+    TEST_ASSERT_EQUAL_MESSAGE(stats.goldenFrames, stats.frames, "Transfers in the golden run");
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_replays_to_the_golden_frames);
+    return UNITY_END();
+}
@@ -0,0 +1,175 @@
+// The stream reader keeps the last blocks it read in slots of its buffer and reads ahead while a file is read in order.
+// Checks which reads reach the card, through the host's file statistics, and that the bytes read back are the file's
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+
+#include "../test_support.h"
+#include "storage_hal.h"
+
+// ===== Test Definitions =====
+
+#define TEST_FILE_PATH "/stream.bin"
+#define TEST_FILE_BLOCK_AMOUNT 10 // Whole blocks in the file, a partial one follows them
+#define TEST_FILE_TAIL_SIZE 100   // Bytes of the partial block at the end
+#define TEST_FILE_SIZE (TEST_FILE_BLOCK_AMOUNT * STREAM_READER_BLOCK_SIZE + TEST_FILE_TAIL_SIZE)
+
+// ===== Test Storage =====
+
+static uint8_t readerBuffer[STREAM_READER_BUFFER_SIZE];
+static StreamReader reader;
+static HostFileStats statsBefore;
+
+// ===== Test Helpers =====
+
+// Byte of the test file at a position, differs between blocks so a block read into the wrong place is noticed
+static uint8_t fileByte(uint32_t position)
+{
+    return (position * 7 + position / STREAM_READER_BLOCK_SIZE * 13) & 0xFF;
+}
+
+// Reads that reached the card since the test started
+static uint32_t readsSinceStart()
+{
+    return hostFileStats().reads - statsBefore.reads;
+}
+
+// Bytes that came from the card since the test started
+static uint64_t bytesSinceStart()
+{
+    return hostFileStats().bytesRead - statsBefore.bytesRead;
+}
+
+// Read the next chunk and check it holds the file's bytes from a position on, with an expected length
+static void assertNextChunk(uint32_t position, size_t length)
+{
+    const uint8_t *data;
+    size_t dataLength;
+    TEST_ASSERT_STORAGE_ERROR(StorageError::NONE, readStreamChunk(reader, data, dataLength));
+    TEST_ASSERT_EQUAL(length, dataLength);
+    for (size_t i = 0; i < dataLength; i++)
+    {
+        TEST_ASSERT_EQUAL(fileByte(position + i), data[i]);
+    }
+}
+
+// Seek to a position and check the bytes read from there
+static void assertReadAt(uint32_t position, size_t length)
+{
+    uint8_t data[64];
+    size_t readAmount;
+    TEST_ASSERT_STORAGE_ERROR(StorageError::NONE, seekStreamReader(reader, position));
+    TEST_ASSERT_STORAGE_ERROR(StorageError::NONE, readStream(reader, data, length, readAmount));
+    TEST_ASSERT_EQUAL(length, readAmount);
+    for (size_t i = 0; i < length; i++)
+    {
+        TEST_ASSERT_EQUAL(fileByte(position + i), data[i]);
+    }
+}
+
+// ===== Tests =====
+
+void setUp()
+{
+    clearTestCard();
+    std::string contents(TEST_FILE_SIZE, '\0');
+    for (uint32_t position = 0; position < TEST_FILE_SIZE; position++)
+    {
+        contents[position] = fileByte(position);
+    }
+    writeTestFile(testCardPath(TEST_FILE_PATH), contents);
+
+    TEST_ASSERT_STORAGE_ERROR(StorageError::NONE, openStreamReader(testFs, TEST_FILE_PATH, readerBuffer, sizeof(readerBuffer), reader));
+    statsBefore = hostFileStats();
+}
+
+void tearDown()
+{
+    closeStreamReader(reader);
+    removeTestCard();
+}
+
+void test_reading_in_order_reads_ahead()
+{
+    // The first block is read on its own, reading on from it reads the next blocks along in one read
+    assertNextChunk(0, STREAM_READER_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(1, readsSinceStart());
+    assertNextChunk(STREAM_READER_BLOCK_SIZE, STREAM_READER_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(2, readsSinceStart());
+    TEST_ASSERT_EQUAL((1 + STREAM_READER_READ_AHEAD_AMOUNT) * STREAM_READER_BLOCK_SIZE, bytesSinceStart());
+
+    // The block read ahead comes from its slot
+    assertNextChunk(2 * STREAM_READER_BLOCK_SIZE, STREAM_READER_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(2, readsSinceStart());
+}
+
+void test_seeking_back_into_a_cached_slot_reads_nothing()
+{
+    for (uint32_t block = 0; block < 3; block++)
+    {
+        assertNextChunk(block * STREAM_READER_BLOCK_SIZE, STREAM_READER_BLOCK_SIZE);
+    }
+    uint32_t reads = readsSinceStart();
+
+    assertReadAt(100, 32);
+    assertReadAt(STREAM_READER_BLOCK_SIZE + 5, 32);
+    assertReadAt(STREAM_READER_BLOCK_SIZE - 16, 32); // Across the end of a cached block into the next cached one
+    TEST_ASSERT_EQUAL(reads, readsSinceStart());
+}
+
+void test_seeking_to_a_block_not_read_reads_only_that_block()
+{
+    assertNextChunk(0, STREAM_READER_BLOCK_SIZE);
+    uint32_t reads = readsSinceStart();
+    uint64_t bytes = bytesSinceStart();
+
+    // A read that does not go on from the last one is no reason to read ahead
+    assertReadAt(7 * STREAM_READER_BLOCK_SIZE + 5, 32);
+    TEST_ASSERT_EQUAL(reads + 1, readsSinceStart());
+    TEST_ASSERT_EQUAL(bytes + STREAM_READER_BLOCK_SIZE, bytesSinceStart());
+
+    // Going on from it in order reads ahead again
+    TEST_ASSERT_STORAGE_ERROR(StorageError::NONE, seekStreamReader(reader, 8 * STREAM_READER_BLOCK_SIZE));
+    assertNextChunk(8 * STREAM_READER_BLOCK_SIZE, STREAM_READER_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(reads + 2, readsSinceStart());
+    TEST_ASSERT_EQUAL(bytes + STREAM_READER_BLOCK_SIZE + STREAM_READER_READ_AHEAD_AMOUNT * STREAM_READER_BLOCK_SIZE, bytesSinceStart());
+}
+
+void test_blocks_pushed_out_of_the_slots_are_read_again()
+{
+    for (uint32_t block = 0; block < 2 * STREAM_READER_CACHE_BLOCK_AMOUNT; block++)
+    {
+        assertNextChunk(block * STREAM_READER_BLOCK_SIZE, STREAM_READER_BLOCK_SIZE);
+    }
+    uint32_t reads = readsSinceStart();
+
+    assertReadAt(0, 32);
+    TEST_ASSERT_EQUAL(reads + 1, readsSinceStart());
+}
+
+void test_reading_ahead_stops_at_the_end_of_the_file()
+{
+    for (uint32_t block = 0; block < TEST_FILE_BLOCK_AMOUNT; block++)
+    {
+        assertNextChunk(block * STREAM_READER_BLOCK_SIZE, STREAM_READER_BLOCK_SIZE);
+    }
+    assertNextChunk(TEST_FILE_BLOCK_AMOUNT * STREAM_READER_BLOCK_SIZE, TEST_FILE_TAIL_SIZE);
+    TEST_ASSERT_EQUAL(TEST_FILE_SIZE, bytesSinceStart());
+
+    const uint8_t *data;
+    size_t dataLength;
+    TEST_ASSERT_STORAGE_ERROR(StorageError::END_OF_FILE, readStreamChunk(reader, data, dataLength));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_reading_in_order_reads_ahead);
+    RUN_TEST(test_seeking_back_into_a_cached_slot_reads_nothing);
+    RUN_TEST(test_seeking_to_a_block_not_read_reads_only_that_block);
+    RUN_TEST(test_blocks_pushed_out_of_the_slots_are_read_again);
+    RUN_TEST(test_reading_ahead_stops_at_the_end_of_the_file);
+    return UNITY_END();
+}
@@ -0,0 +1,56 @@
+// What the native unit tests share: a directory on the host that stands in for the SD card, checked writing of the files
+// they put on it, and comparing storage errors. Every test directory is a program of its own, so they all use one card
+
+#pragma once
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <filesystem>
+#include <string>
+
+#include "storage_hal.h"
+
+// ===== Test Card Definitions =====
+
+#define TEST_SD_ROOT "/tmp/portfolio_test_card"
+
+// Compare storage errors by their description, so a failure names both of them
+#define TEST_ASSERT_STORAGE_ERROR(expected, actual) TEST_ASSERT_EQUAL_STRING(storageErrorToString(expected), storageErrorToString(actual))
+
+// ===== Test Card =====
+
+static fs::FS testFs(TEST_SD_ROOT);
+
+// Start the test card over as an empty directory
+inline void clearTestCard()
+{
+    std::filesystem::remove_all(TEST_SD_ROOT);
+    TEST_ASSERT_TRUE(std::filesystem::create_directories(TEST_SD_ROOT));
+}
+
+// Remove the test card and everything the firmware wrote to it
+inline void removeTestCard()
+{
+    std::filesystem::remove_all(TEST_SD_ROOT);
+}
+
+// Get where a path on the test card is on the host, paths on the card start with a slash like the firmware's
+inline std::string testCardPath(const std::string &path)
+{
+    return TEST_SD_ROOT + path;
+}
+
+// Write a file on the host, failing the test when it can not be written completely
+inline void writeTestFile(const std::string &hostPath, const void *data, size_t size)
+{
+    FILE *file = fopen(hostPath.c_str(), "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    bool written = fwrite(data, 1, size, file) == size;
+    TEST_ASSERT_TRUE(fclose(file) == 0 && written);
+}
+
+inline void writeTestFile(const std::string &hostPath, const std::string &contents)
+{
+    writeTestFile(hostPath, contents.data(), contents.size());
+}
@@ -0,0 +1,149 @@
+// The topic cache evicts the least recently used topics that are not acquired when a new one needs room. Every topic here
+// takes a quarter of the cache, so it holds four of them, and whether a topic was still cached shows in the reads of the card
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+
+#include "../test_support.h"
+#include "topic_cache.h"
+#include "topic_catalog.h"
+
+// ===== Test Definitions =====
+
+#define TEST_TOPIC_AMOUNT 6
+#define TEST_TOPIC_SIZE TOPIC_CACHE_MAX_TOPIC_SIZE
+#define TEST_CACHED_TOPIC_AMOUNT (TOPIC_CACHE_SIZE / TEST_TOPIC_SIZE)
+
+// ===== Test Storage =====
+
+static TopicCatalog catalog;
+
+// ===== Test Helpers =====
+
+// Byte of the text of a topic at a position, differs between topics so a topic given the text of another one is noticed
+static uint8_t topicByte(uint16_t topicIndex, uint32_t position)
+{
+    return 'a' + (position + topicIndex) % 26;
+}
+
+// Acquire a topic, check its text and tell whether it had to be read from the card
+static bool acquireTopic(uint16_t topicIndex)
+{
+    uint32_t reads = hostFileStats().reads;
+    CachedTopic topic;
+    TEST_ASSERT_TRUE(acquireCachedTopic(topicIndex, topic));
+    TEST_ASSERT_EQUAL(TEST_TOPIC_SIZE, topic.size);
+    TEST_ASSERT_EQUAL(topicByte(topicIndex, 0), topic.text[0]);
+    TEST_ASSERT_EQUAL(topicByte(topicIndex, TEST_TOPIC_SIZE - 1), topic.text[TEST_TOPIC_SIZE - 1]);
+    return hostFileStats().reads > reads;
+}
+
+// Acquire a topic and release it right away, which only makes it the most recently used one
+static bool useTopic(uint16_t topicIndex)
+{
+    bool read = acquireTopic(topicIndex);
+    releaseCachedTopic(topicIndex);
+    return read;
+}
+
+// Leave the cache holding exactly the first topics, the last one of them the most recently used, whatever earlier tests left
+static void fillCacheInOrder()
+{
+    for (uint16_t topicIndex = 0; topicIndex < TEST_CACHED_TOPIC_AMOUNT; topicIndex++)
+    {
+        useTopic(topicIndex);
+    }
+}
+
+// ===== Tests =====
+
+// The cache itself lives on from test to test, each one starts by filling it with the topics it expects
+void setUp()
+{
+    clearTestCard();
+    for (uint16_t topicIndex = 0; topicIndex < TEST_TOPIC_AMOUNT; topicIndex++)
+    {
+        std::string text(TEST_TOPIC_SIZE, '\0');
+        for (uint32_t position = 0; position < TEST_TOPIC_SIZE; position++)
+        {
+            text[position] = topicByte(topicIndex, position);
+        }
+        writeTestFile(testCardPath("/Topic" + std::to_string(topicIndex) + TOPIC_FILE_EXTENSION), text);
+    }
+    TEST_ASSERT_STORAGE_ERROR(StorageError::NONE, assembleTopicsFromDirectory(testFs, "/", catalog));
+    TEST_ASSERT_EQUAL(TEST_TOPIC_AMOUNT, countTopics(catalog));
+    initializeTopicCache(testFs, "/", catalog);
+}
+
+void tearDown()
+{
+    removeTestCard();
+}
+
+void test_topics_are_read_once()
+{
+    fillCacheInOrder();
+    for (uint16_t topicIndex = 0; topicIndex < TEST_CACHED_TOPIC_AMOUNT; topicIndex++)
+    {
+        TEST_ASSERT_FALSE(useTopic(topicIndex));
+    }
+}
+
+void test_least_recently_used_topic_is_evicted_first()
+{
+    fillCacheInOrder();
+    useTopic(0); // Topic 1 is now the least recently used
+
+    TEST_ASSERT_TRUE(useTopic(TEST_CACHED_TOPIC_AMOUNT));
+    TEST_ASSERT_FALSE(useTopic(0));
+    TEST_ASSERT_FALSE(useTopic(2));
+    TEST_ASSERT_TRUE(useTopic(1));
+}
+
+void test_acquired_topics_are_never_evicted()
+{
+    fillCacheInOrder();
+    TEST_ASSERT_FALSE(acquireTopic(0));
+    for (uint16_t topicIndex = 1; topicIndex < TEST_CACHED_TOPIC_AMOUNT; topicIndex++)
+    {
+        useTopic(topicIndex); // Topic 0 stays the least recently used one, but acquired
+    }
+
+    // Room for the new topics comes from the oldest ones that are not acquired, topics 1 and 2
+    TEST_ASSERT_TRUE(useTopic(TEST_CACHED_TOPIC_AMOUNT));
+    TEST_ASSERT_TRUE(useTopic(TEST_CACHED_TOPIC_AMOUNT + 1));
+    TEST_ASSERT_FALSE(useTopic(3));
+    releaseCachedTopic(0);
+    TEST_ASSERT_FALSE(useTopic(0));
+    TEST_ASSERT_TRUE(useTopic(1));
+}
+
+void test_topic_is_not_cached_when_every_entry_is_acquired()
+{
+    fillCacheInOrder();
+    for (uint16_t topicIndex = 0; topicIndex < TEST_CACHED_TOPIC_AMOUNT; topicIndex++)
+    {
+        TEST_ASSERT_FALSE(acquireTopic(topicIndex));
+    }
+
+    // Nothing can make room, so the topic has to be streamed and the acquired ones all stay
+    CachedTopic topic;
+    TEST_ASSERT_FALSE(acquireCachedTopic(TEST_CACHED_TOPIC_AMOUNT, topic));
+    for (uint16_t topicIndex = 0; topicIndex < TEST_CACHED_TOPIC_AMOUNT; topicIndex++)
+    {
+        releaseCachedTopic(topicIndex);
+        TEST_ASSERT_FALSE(useTopic(topicIndex));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_topics_are_read_once);
+    RUN_TEST(test_least_recently_used_topic_is_evicted_first);
+    RUN_TEST(test_acquired_topics_are_never_evicted);
+    RUN_TEST(test_topic_is_not_cached_when_every_entry_is_acquired);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+// Builds a content pack from a directory of .txt files, see include/content_pack.h for the format.
+// The text is wrapped with the firmware's own layoutTopic(), so the checkpoint tables match what the device would compute.
+//
+//   content_packer <directory with .txt files> <output pack> [line width]
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "content_pack.h"
+#include "display_hal.h"
+#include "storage_hal.h"
+#include "text_layout.h"
+#include "topic_catalog.h"
+
+// ===== Struct Definitions =====
+
+struct PackedTopic
+{
+    String name;
+    std::vector<uint8_t> text;
+    TopicLayout layout;
+};
+
+// ===== Internal Helpers =====
+
+// Append the bytes of a value to a growing table
+template <typename T>
+static void appendBytes(std::vector<uint8_t> &destination, const T &value)
+{
+    const uint8_t *bytes = (const uint8_t *)&value;
+    destination.insert(destination.end(), bytes, bytes + sizeof(T));
+}
+
+// Read a text file completely and wrap it, through the same stream reader the firmware uses
+static bool loadTopic(fs::FS &inputFs, const String &fileName, uint8_t lineWidth, PackedTopic &topic)
+{
+    static uint8_t readBuffer[STREAM_READER_BUFFER_SIZE];
+    StreamReader reader;
+    StorageError error = openStreamReader(inputFs, "/" + fileName, readBuffer, sizeof(readBuffer), reader);
+    if (error == StorageError::NONE)
+    {
+        error = layoutTopic(reader, lineWidth, topic.layout);
+    }
+    if (error == StorageError::NONE && (error = seekStreamReader(reader, 0)) == StorageError::NONE)
+    {
+        const uint8_t *data;
+        size_t length;
+        while ((error = readStreamChunk(reader, data, length)) == StorageError::NONE)
+        {
+            topic.text.insert(topic.text.end(), data, data + length);
+        }
+        if (error == StorageError::END_OF_FILE)
+        {
+            error = StorageError::NONE;
+        }
+    }
+    closeStreamReader(reader);
+
+    if (error != StorageError::NONE)
+    {
+        fprintf(stderr, "%s: %s\n", fileName.c_str(), storageErrorToString(error));
+        return false;
+    }
+    topic.name = fileName.substring(0, fileName.length() - strlen(TOPIC_FILE_EXTENSION));
+    return true;
+}
+
+// ===== Entry Point =====
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <directory with .txt files> <output pack> [line width, default %d]\n", argv[0], DETAILS_LINE_WIDTH);
+        return 2;
+    }
+    int lineWidth = argc > 3 ? atoi(argv[3]) : DETAILS_LINE_WIDTH;
+    // The pack keeps the width in a byte, zero stands for a topic that is not laid out
+    if (lineWidth < 1 || lineWidth > UINT8_MAX)
+    {
+        fprintf(stderr, "line width has to be between 1 and %d\n", UINT8_MAX);
+        return 2;
+    }
+
+    // Collect the topics the same way the firmware scans the card, only .txt files count
+    fs::FS inputFs(argv[1]);
+    File root = inputFs.open("/");
+    if (!root || !root.isDirectory())
+    {
+        fprintf(stderr, "%s is not a directory\n", argv[1]);
+        return 1;
+    }
+    std::vector<PackedTopic> topics;
+    for (File file = root.openNextFile(); file; file = root.openNextFile())
+    {
+        String fileName = file.name();
+        if (file.isDirectory() || fileName.length() <= strlen(TOPIC_FILE_EXTENSION) || !fileName.endsWith(TOPIC_FILE_EXTENSION))
+        {
+            continue;
+        }
+        PackedTopic topic;
+        if (!loadTopic(inputFs, fileName, lineWidth, topic))
+        {
+            return 1;
+        }
+        topics.push_back(std::move(topic));
+    }
+    if (topics.size() > UINT16_MAX)
+    {
+        fprintf(stderr, "too many topics\n");
+        return 1;
+    }
+
+    // Lay out the table area: the topic table first, then every checkpoint table, then every name
+    std::vector<ContentPackTopic> entries(topics.size());
+    uint32_t tableSize = topics.size() * sizeof(ContentPackTopic);
+    for (size_t i = 0; i < topics.size(); i++)
+    {
+        entries[i].checkpointTableOffset = tableSize;
+        entries[i].lineAmount = countLayoutLines(topics[i].layout);
+        tableSize += checkpointTableSize(topics[i].layout);
+    }
+    for (size_t i = 0; i < topics.size(); i++)
+    {
+        entries[i].nameOffset = tableSize;
+        tableSize += topics[i].name.length() + 1;
+    }
+    uint32_t textOffset = sizeof(ContentPackHeader) + tableSize;
+    for (size_t i = 0; i < topics.size(); i++)
+    {
+        entries[i].textOffset = textOffset;
+        entries[i].textSize = topics[i].text.size();
+        entries[i].textChecksum = calculateChecksum(topics[i].text.data(), topics[i].text.size());
+        textOffset += entries[i].textSize;
+    }
+
+    std::vector<uint8_t> table;
+    table.reserve(tableSize);
+    for (const ContentPackTopic &entry : entries)
+    {
+        appendBytes(table, entry);
+    }
+    for (const PackedTopic &topic : topics)
+    {
+        table.resize(table.size() + checkpointTableSize(topic.layout));
+        packCheckpointTable(topic.layout, &table[table.size() - checkpointTableSize(topic.layout)]);
+    }
+    for (const PackedTopic &topic : topics)
+    {
+        table.insert(table.end(), topic.name.c_str(), topic.name.c_str() + topic.name.length() + 1);
+    }
+
+    ContentPackHeader header = {};
+    memcpy(header.magic, CONTENT_PACK_MAGIC, sizeof(header.magic));
+    header.version = CONTENT_PACK_VERSION;
+    header.lineWidth = lineWidth;
+    header.topicAmount = topics.size();
+    header.tableSize = tableSize;
+    header.tableChecksum = calculateChecksum(table.data(), table.size());
+    header.headerChecksum = calculateChecksum((const uint8_t *)&header, offsetof(ContentPackHeader, headerChecksum));
+
+    FILE *output = fopen(argv[2], "wb");
+    if (!output)
+    {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, output) == 1 && fwrite(table.data(), 1, table.size(), output) == table.size();
+    for (const PackedTopic &topic : topics)
+    {
+        written = written && fwrite(topic.text.data(), 1, topic.text.size(), output) == topic.text.size();
+    }
+    if (fclose(output) != 0 || !written)
+    {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    for (size_t i = 0; i < topics.size(); i++)
+    {
+        printf("%-32s %6u lines %8u bytes\n", topics[i].name.c_str(), (unsigned int)entries[i].lineAmount, (unsigned int)entries[i].textSize);
+    }
+    printf("%u topics, %u bytes of tables, %u bytes in total, wrapped at %d\n", (unsigned int)topics.size(), (unsigned int)tableSize, (unsigned int)textOffset, lineWidth);
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Compares drawing a full page of text through the GFX print with the glyph blitter, and checks both give the same pixels.
+// Runs on the host against lib/native_host, whose GFX stand-in draws characters block by block like the library does.
+//
+//   text_render_benchmark [iterations]
+
+#include <Arduino.h>
+#include <Arduino_GFX_Library.h>
+
+#include <chrono>
+
+#include "display_hal.h"
+#include "glyph_blitter.h"
+#include "indexed_canvas.h"
+
+// ===== Benchmark Definitions =====
+
+#define BENCHMARK_DEFAULT_ITERATIONS 200
+
+// ===== Internal Helpers =====
+
+// Fill a page of details text, every line as long as the details screen allows
+static void buildPage(char lines[DETAILS_LINE_AMOUNT][DETAILS_LINE_WIDTH + 1])
+{
+    for (uint8_t line = 0; line < DETAILS_LINE_AMOUNT; line++)
+    {
+        for (uint8_t column = 0; column < DETAILS_LINE_WIDTH; column++)
+        {
+            lines[line][column] = GLYPH_FIRST_CHARACTER + 1 + (line * DETAILS_LINE_WIDTH + column) % (GLYPH_AMOUNT - 1);
+        }
+        lines[line][DETAILS_LINE_WIDTH] = '\0';
+    }
+}
+
+// Draw the page the way the firmware draws the details screen, through the GFX print or through the blitter
+static void drawPage(IndexedCanvas &canvas, char lines[DETAILS_LINE_AMOUNT][DETAILS_LINE_WIDTH + 1], uint8_t textSize, bool useBlitter)
+{
+    uint8_t lineAmount = textSize == 1 ? DETAILS_LINE_AMOUNT : DETAILS_LINE_AMOUNT / textSize;
+    for (uint8_t line = 0; line < lineAmount; line++)
+    {
+        int16_t x = DETAILS_SCREEN_PADDING_SIZE + (textSize == 1 ? 0 : 1); // Larger text also covers the odd start of the menu
+        int16_t y = DETAILS_TEXT_Y + line * GLYPH_HEIGHT * textSize;
+        const char *text = textSize == 1 ? lines[line] : &lines[line][DETAILS_LINE_WIDTH / 2];
+        if (useBlitter)
+        {
+            blitText(canvas.getFramebuffer(), SCREEN_WIDTH, SCREEN_HEIGHT, x, y, text, textSize, canvas.colorIndex(WHITE));
+        }
+        else
+        {
+            canvas.setTextSize(textSize);
+            canvas.setTextColor(WHITE);
+            canvas.setCursor(x, y);
+            canvas.print(text);
+        }
+    }
+}
+
+// Time drawing the page a number of times, in microseconds per page
+static double timePage(IndexedCanvas &canvas, char lines[DETAILS_LINE_AMOUNT][DETAILS_LINE_WIDTH + 1], uint8_t textSize, bool useBlitter, uint32_t iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        drawPage(canvas, lines, textSize, useBlitter);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+// ===== Entry Point =====
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : BENCHMARK_DEFAULT_ITERATIONS;
+    if (iterations == 0)
+    {
+        iterations = 1;
+    }
+
+    Arduino_DataBus *bus = new Arduino_ESP32QSPI(DISPLAY_CS_PIN, DISPLAY_SCK_PIN, DISPLAY_D0_PIN, DISPLAY_D1_PIN, DISPLAY_D2_PIN, DISPLAY_D3_PIN);
+    Arduino_NV3041A *panel = new Arduino_NV3041A(bus, GFX_NOT_DEFINED, DISPLAY_ROTATION, DISPLAY_IS_IPS);
+    IndexedCanvas printCanvas(SCREEN_WIDTH, SCREEN_HEIGHT, panel);
+    IndexedCanvas blitCanvas(SCREEN_WIDTH, SCREEN_HEIGHT, panel);
+    if (!printCanvas.begin() || !blitCanvas.begin())
+    {
+        fprintf(stderr, "could not allocate the canvases\n");
+        return 1;
+    }
+
+    char lines[DETAILS_LINE_AMOUNT][DETAILS_LINE_WIDTH + 1];
+    buildPage(lines);
+
+    bool allEqual = true;
+    for (uint8_t textSize = 1; textSize <= GLYPH_BLITTER_MAX_TEXT_SIZE; textSize++)
+    {
+        // Both paths have to leave exactly the same pixels behind before their speed means anything
+        printCanvas.fillScreen(BLACK);
+        blitCanvas.fillScreen(BLACK);
+        drawPage(printCanvas, lines, textSize, false);
+        drawPage(blitCanvas, lines, textSize, true);
+        bool equal = memcmp(printCanvas.getFramebuffer(), blitCanvas.getFramebuffer(), FRAMEBUFFER_SIZE) == 0;
+        allEqual = allEqual && equal;
+
+        double printTime = timePage(printCanvas, lines, textSize, false, iterations);
+        double blitTime = timePage(blitCanvas, lines, textSize, true, iterations);
+        printf("text size %u: print %8.1f us/page, blitter %8.1f us/page, %5.1fx faster, pixels %s\n",
+               textSize, printTime, blitTime, printTime / blitTime, equal ? "equal" : "DIFFERENT");
+    }
+    return allEqual ? 0 : 1;
+}
@@ -0,0 +1,336 @@
+// Compresses every .txt file in a directory into a compressed text file, see include/compressed_text.h for the format, checks
+// each one decompresses to the same text through the firmware's stream reader, and compares opening both up to the first page.
+//
+// Opening is timed on the host, which decompresses far faster than the ESP32-S3, so the bytes and reads that reached the card
+// are counted as well. The card time is estimated from them at the given read speed, the SD card on SPI manages about 1500 kB/s.
+//
+//   topic_compressor <directory with .txt files> <output directory> [card read speed in kB/s] [iterations]
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <vector>
+
+#include "compressed_text.h"
+#include "display_hal.h"
+#include "storage_hal.h"
+#include "text_layout.h"
+#include "topic_catalog.h"
+
+// ===== Compressor Definitions =====
+
+#define COMPRESSOR_HASH_BITS 12         // Three byte prefixes are hashed into this many bits to find earlier repeats
+#define COMPRESSOR_MAX_CHAIN_LENGTH 128 // Earlier repeats of a prefix compared before settling on the longest match so far
+#define BENCHMARK_DEFAULT_CARD_SPEED 1500
+#define BENCHMARK_DEFAULT_ITERATIONS 20
+
+// ===== Struct Definitions =====
+
+struct OpenMeasurement
+{
+    double microseconds; // Average time on the host for one open
+    uint32_t reads;      // Reads that reached the card for one open
+    uint64_t bytesRead;
+};
+
+// ===== Internal Helpers =====
+
+// Append the bytes of a value to a growing file
+template <typename T>
+static void appendBytes(std::vector<uint8_t> &destination, const T &value)
+{
+    const uint8_t *bytes = (const uint8_t *)&value;
+    destination.insert(destination.end(), bytes, bytes + sizeof(T));
+}
+
+// Hash the three bytes a match has to start with at least
+static uint32_t hashPrefix(const uint8_t *text)
+{
+    uint32_t prefix = text[0] | (text[1] << 8) | (text[2] << 16);
+    return (prefix * 2654435761u) >> (32 - COMPRESSOR_HASH_BITS);
+}
+
+// Compress one block on its own, taking the longest earlier repeat at every position the hash chains turn up
+static void compressBlock(const uint8_t *text, size_t length, std::vector<uint8_t> &output)
+{
+    std::vector<int32_t> chainHeads(1 << COMPRESSOR_HASH_BITS, -1);
+    std::vector<int32_t> chainLinks(length, -1);
+    size_t flagsPosition = 0;
+    uint8_t flagBit = 8;
+    size_t position = 0;
+    while (position < length)
+    {
+        if (flagBit == 8)
+        {
+            flagsPosition = output.size();
+            output.push_back(0);
+            flagBit = 0;
+        }
+
+        size_t bestLength = 0;
+        size_t bestDistance = 0;
+        if (position + COMPRESSED_TEXT_MIN_MATCH <= length)
+        {
+            size_t maximumLength = min((size_t)COMPRESSED_TEXT_MAX_MATCH, length - position);
+            int32_t candidate = chainHeads[hashPrefix(&text[position])];
+            for (uint32_t chain = 0; candidate >= 0 && chain < COMPRESSOR_MAX_CHAIN_LENGTH; chain++, candidate = chainLinks[candidate])
+            {
+                size_t distance = position - candidate;
+                if (distance > COMPRESSED_TEXT_MAX_DISTANCE)
+                {
+                    break;
+                }
+                size_t matchLength = 0;
+                while (matchLength < maximumLength && text[candidate + matchLength] == text[position + matchLength])
+                {
+                    matchLength++;
+                }
+                if (matchLength > bestLength)
+                {
+                    bestLength = matchLength;
+                    bestDistance = distance;
+                    if (matchLength == maximumLength)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        size_t step = 1;
+        if (bestLength >= COMPRESSED_TEXT_MIN_MATCH)
+        {
+            output.push_back((bestDistance - 1) & 0xFF);
+            output.push_back((((bestDistance - 1) >> 8) << 4) | (bestLength - COMPRESSED_TEXT_MIN_MATCH));
+            step = bestLength;
+        }
+        else
+        {
+            output[flagsPosition] |= 1 << flagBit;
+            output.push_back(text[position]);
+        }
+        flagBit++;
+
+        // Every position passed over can start a later match
+        for (size_t i = 0; i < step; i++, position++)
+        {
+            if (position + COMPRESSED_TEXT_MIN_MATCH <= length)
+            {
+                uint32_t hash = hashPrefix(&text[position]);
+                chainLinks[position] = chainHeads[hash];
+                chainHeads[hash] = position;
+            }
+        }
+    }
+}
+
+// Build a whole compressed text file: the header, the block table and every block
+static std::vector<uint8_t> compressText(const std::vector<uint8_t> &text)
+{
+    CompressedTextHeader header = {};
+    memcpy(header.magic, COMPRESSED_TEXT_MAGIC, sizeof(header.magic));
+    header.version = COMPRESSED_TEXT_VERSION;
+    header.blockSize = COMPRESSED_TEXT_BLOCK_SIZE;
+    header.textSize = text.size();
+    header.headerChecksum = compressedTextHeaderChecksum(header);
+
+    uint32_t blockAmount = countCompressedTextBlocks(header.blockSize, header.textSize);
+    std::vector<uint8_t> blocks;
+    std::vector<uint32_t> blockOffsets;
+    uint32_t blocksStart = sizeof(header) + (blockAmount + 1) * sizeof(uint32_t);
+    for (uint32_t block = 0; block < blockAmount; block++)
+    {
+        blockOffsets.push_back(blocksStart + blocks.size());
+        size_t blockStart = block * header.blockSize;
+        compressBlock(&text[blockStart], min((size_t)header.blockSize, text.size() - blockStart), blocks);
+    }
+    blockOffsets.push_back(blocksStart + blocks.size());
+
+    std::vector<uint8_t> file;
+    appendBytes(file, header);
+    for (uint32_t offset : blockOffsets)
+    {
+        appendBytes(file, offset);
+    }
+    file.insert(file.end(), blocks.begin(), blocks.end());
+    return file;
+}
+
+// Read a whole file into memory
+static bool readWholeFile(fs::FS &fs, const String &path, std::vector<uint8_t> &data)
+{
+    File file = fs.open(path);
+    if (!file)
+    {
+        return false;
+    }
+    data.resize(file.size());
+    return file.read(data.data(), data.size()) == data.size();
+}
+
+// Write a whole file from memory
+static bool writeWholeFile(const String &path, const std::vector<uint8_t> &data)
+{
+    FILE *output = fopen(path.c_str(), "wb");
+    if (!output)
+    {
+        return false;
+    }
+    bool written = fwrite(data.data(), 1, data.size(), output) == data.size();
+    return fclose(output) == 0 && written;
+}
+
+// Open a topic and read its first page the way the firmware does. Without lines wrapped before, the topic is wrapped first,
+// which streams all of its text
+static StorageError openToFirstPage(fs::FS &fs, const String &path, bool compressed, TopicLayout &layout)
+{
+    static uint8_t readBuffer[STREAM_READER_BUFFER_SIZE];
+    static TopicViewport viewport;
+    StreamReader reader;
+    StorageError error = compressed ? openCompressedStreamReader(fs, path, readBuffer, sizeof(readBuffer), reader) : openStreamReader(fs, path, readBuffer, sizeof(readBuffer), reader);
+    if (error == StorageError::NONE && !isTopicLaidOut(layout, DETAILS_LINE_WIDTH))
+    {
+        error = layoutTopic(reader, DETAILS_LINE_WIDTH, layout);
+    }
+    if (error == StorageError::NONE)
+    {
+        openTopicViewport(layout, viewport);
+        error = moveTopicViewport(reader, viewport, 0, DETAILS_LINE_AMOUNT);
+    }
+    closeStreamReader(reader);
+    return error;
+}
+
+// Time opening a topic up to its first page, either wrapping it every time or with its lines already wrapped like the index cache has them
+static bool measureOpen(fs::FS &fs, const String &path, bool compressed, bool indexed, uint32_t iterations, OpenMeasurement &measurement)
+{
+    TopicLayout indexedLayout;
+    if (indexed && openToFirstPage(fs, path, compressed, indexedLayout) != StorageError::NONE)
+    {
+        return false;
+    }
+
+    HostFileStats before = hostFileStats();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        TopicLayout layout;
+        if (openToFirstPage(fs, path, compressed, indexed ? indexedLayout : layout) != StorageError::NONE)
+        {
+            return false;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    HostFileStats after = hostFileStats();
+
+    measurement.microseconds = std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+    measurement.reads = (after.reads - before.reads) / iterations;
+    measurement.bytesRead = (after.bytesRead - before.bytesRead) / iterations;
+    return true;
+}
+
+// Print one way of opening a topic, with the card time estimated from the bytes it read
+static void printMeasurement(const char *label, const OpenMeasurement &measurement, uint32_t cardSpeed)
+{
+    double cardMicroseconds = measurement.bytesRead * 1000.0 / cardSpeed;
+    printf("  %-18s %9.1f us host %6u reads %9llu bytes %9.1f us card %9.1f us total\n", label, measurement.microseconds, (unsigned int)measurement.reads,
+           (unsigned long long)measurement.bytesRead, cardMicroseconds, measurement.microseconds + cardMicroseconds);
+}
+
+// ===== Entry Point =====
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <directory with .txt files> <output directory> [card read speed in kB/s, default %d] [iterations, default %d]\n", argv[0],
+                BENCHMARK_DEFAULT_CARD_SPEED, BENCHMARK_DEFAULT_ITERATIONS);
+        return 2;
+    }
+    uint32_t cardSpeed = argc > 3 ? strtoul(argv[3], nullptr, 10) : BENCHMARK_DEFAULT_CARD_SPEED;
+    uint32_t iterations = argc > 4 ? strtoul(argv[4], nullptr, 10) : BENCHMARK_DEFAULT_ITERATIONS;
+    if (cardSpeed == 0 || iterations == 0)
+    {
+        fprintf(stderr, "card read speed and iterations have to be above zero\n");
+        return 2;
+    }
+
+    fs::FS inputFs(argv[1]);
+    fs::FS outputFs(argv[2]);
+    File root = inputFs.open("/");
+    if (!root || !root.isDirectory())
+    {
+        fprintf(stderr, "%s is not a directory\n", argv[1]);
+        return 1;
+    }
+
+    uint64_t totalTextSize = 0;
+    uint64_t totalCompressedSize = 0;
+    for (File file = root.openNextFile(); file; file = root.openNextFile())
+    {
+        String fileName = file.name();
+        if (file.isDirectory() || fileName.length() <= strlen(TOPIC_FILE_EXTENSION) || !fileName.endsWith(TOPIC_FILE_EXTENSION))
+        {
+            continue;
+        }
+        String name = fileName.substring(0, fileName.length() - strlen(TOPIC_FILE_EXTENSION));
+        String textPath = "/" + fileName;
+        String compressedPath = "/" + name + COMPRESSED_TEXT_FILE_EXTENSION;
+
+        std::vector<uint8_t> text;
+        if (!readWholeFile(inputFs, textPath, text))
+        {
+            fprintf(stderr, "%s: %s\n", fileName.c_str(), storageErrorToString(StorageError::READ_FAILED));
+            return 1;
+        }
+        std::vector<uint8_t> compressed = compressText(text);
+        if (!writeWholeFile(String(argv[2]) + compressedPath, compressed))
+        {
+            fprintf(stderr, "cannot write %s%s\n", argv[2], compressedPath.c_str());
+            return 1;
+        }
+
+        // Read it back through the firmware's reader, so a compressor bug never ends up on a card
+        std::vector<uint8_t> decompressed(text.size());
+        static uint8_t readBuffer[STREAM_READER_BUFFER_SIZE];
+        StreamReader reader;
+        size_t readAmount = 0;
+        StorageError error = openCompressedStreamReader(outputFs, compressedPath, readBuffer, sizeof(readBuffer), reader);
+        if (error == StorageError::NONE && !text.empty())
+        {
+            error = readStream(reader, decompressed.data(), decompressed.size(), readAmount);
+        }
+        closeStreamReader(reader);
+        if (error != StorageError::NONE || readAmount != text.size() || decompressed != text)
+        {
+            fprintf(stderr, "%s: does not decompress to the same text (%s)\n", fileName.c_str(), storageErrorToString(error));
+            return 1;
+        }
+
+        totalTextSize += text.size();
+        totalCompressedSize += compressed.size();
+        printf("%-32s %8u bytes %8u compressed %5.1f%%\n", name.c_str(), (unsigned int)text.size(), (unsigned int)compressed.size(),
+               text.empty() ? 100.0 : compressed.size() * 100.0 / text.size());
+
+        OpenMeasurement measurement;
+        const struct
+        {
+            const char *label;
+            bool compressed;
+            bool indexed;
+        } openings[] = {{"txt, wrapping", false, false}, {"txc, wrapping", true, false}, {"txt, indexed", false, true}, {"txc, indexed", true, true}};
+        for (const auto &opening : openings)
+        {
+            if (!measureOpen(opening.compressed ? outputFs : inputFs, opening.compressed ? compressedPath : textPath, opening.compressed, opening.indexed, iterations, measurement))
+            {
+                fprintf(stderr, "%s: could not be opened\n", fileName.c_str());
+                return 1;
+            }
+            printMeasurement(opening.label, measurement, cardSpeed);
+        }
+    }
+
+    printf("%llu bytes of text compressed into %llu bytes, %.1f%%, card estimated at %u kB/s\n", (unsigned long long)totalTextSize,
+           (unsigned long long)totalCompressedSize, totalTextSize == 0 ? 100.0 : totalCompressedSize * 100.0 / totalTextSize, (unsigned int)cardSpeed);
+    return 0;
+}